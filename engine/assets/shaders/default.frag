@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Samples the first image parm of the material out of the bindless array.
+
+// The bindless set, see DescriptorManager. Sampler 0 is linear and repeating.
+layout(set = 0, binding = 0) uniform texture2D images[];
+layout(set = 0, binding = 1) uniform sampler samplers[8];
+
+// DrawPushConstants of RenderCommon.h.
+layout(push_constant) uniform DrawPushConstants {
+    uint images[16];
+} draw;
+
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(sampler2D(images[draw.images[0]], samplers[0]), inTexCoord) * inColor;
+}
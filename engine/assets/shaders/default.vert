@@ -0,0 +1,24 @@
+#version 450
+
+// Draws DrawVert geometry transformed by the first uniform block of the surface
+// and tinted by its color.
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inNormal;
+layout(location = 3) in vec4 inColor;
+
+// UBO parm 0, bound at its dynamic offset in the ring.
+layout(set = 1, binding = 0) uniform DrawParms {
+    mat4 mvp;
+    vec4 color;
+} parms;
+
+layout(location = 0) out vec2 outTexCoord;
+layout(location = 1) out vec4 outColor;
+
+void main() {
+    gl_Position = parms.mvp * vec4(inPosition, 1.0);
+    outTexCoord = inTexCoord;
+    outColor = inColor * parms.color;
+}
@@ -5,7 +5,7 @@
 #include "ConfigManager.h"
 
 #include <cJSON.h>
-#include "ReloadLib/File.h"
+#include "ReloadLib/FileSystem.h"
 
 #ifndef RLD_DEBUG
 constexpr auto MAIN_CONFIG = "config/sys_config.json";
@@ -27,10 +27,18 @@ directory.
 ================================================================================
 */
 void ConfigManager::LoadSystemConfig() {
-    char *buffer = File::ReadAsString(MAIN_CONFIG);
-    cJSON *config = cJSON_Parse(buffer);
+    AssetFile configFile;
+    if (!configFile.Open(MAIN_CONFIG)) {
+        SDL_LogCritical(LOG_FILE, "Couldn't load the system configuration %s.", MAIN_CONFIG);
+        exit(1);
+    }
+
+    configFile.Advise(MAP_ADVICE_SEQUENTIAL);
+
+    const Span<const uint8_t> buffer = configFile.Data();
+    cJSON *config = cJSON_ParseWithLength(reinterpret_cast<const char *>(buffer.Data()), buffer.Size());
 
-    free(buffer);
+    configFile.Close();
 
     if (config == nullptr) {
         const char *errorPtr = cJSON_GetErrorPtr();
@@ -127,7 +135,10 @@ void ConfigManager::LoadSystemConfig() {
         const cJSON *selectedGpu = cJSON_GetObjectItem(vkConfigJson, "selectedGpu");
         const cJSON *deviceLocalMemoryMB = cJSON_GetObjectItem(vkConfigJson, "deviceLocalMemoryMB");
         const cJSON *uploadBufferSizeMB = cJSON_GetObjectItem(vkConfigJson, "uploadBufferSizeMB");
+        const cJSON *uploadSegments = cJSON_GetObjectItem(vkConfigJson, "uploadSegments");
+        const cJSON *dynamicBufferSizeMB = cJSON_GetObjectItem(vkConfigJson, "dynamicBufferSizeMB");
         const cJSON *swapInterval = cJSON_GetObjectItem(vkConfigJson, "swapInterval");
+        const cJSON *recordPipelines = cJSON_GetObjectItem(vkConfigJson, "recordPipelines");
 
         if (!cJSON_IsNumber(versionMajor)) {
             printf("Vulkan configuration error. Version major field is not number");
@@ -165,11 +176,23 @@ void ConfigManager::LoadSystemConfig() {
             printf("Vulkan configuration error. upload buffer size field is not number");
             goto free_mem_and_return;
         }
+        if (!cJSON_IsNumber(uploadSegments)) {
+            printf("Vulkan configuration error. upload segments field is not number");
+            goto free_mem_and_return;
+        }
+        if (!cJSON_IsNumber(dynamicBufferSizeMB)) {
+            printf("Vulkan configuration error. dynamic buffer size field is not number");
+            goto free_mem_and_return;
+        }
 
         if (!cJSON_IsNumber(swapInterval)) {
             printf("Vulkan configuration error. swap interval field is not number");
             goto free_mem_and_return;
         }
+        if (!cJSON_IsBool(recordPipelines)) {
+            printf("Vulkan configuration error. record pipelines field is not boolean");
+            goto free_mem_and_return;
+        }
 
         vkConfig.apiVersion.major = (unsigned int) versionMajor->valueint;
         vkConfig.apiVersion.minor = (unsigned int) versionMinor->valueint;
@@ -184,7 +207,10 @@ void ConfigManager::LoadSystemConfig() {
         vkConfig.selectedGpu =  selectedGpu->valueint;
         vkConfig.deviceLocalMemoryMB = (unsigned int)deviceLocalMemoryMB->valueint;
         vkConfig.uploadBufferSizeMB = (unsigned int)uploadBufferSizeMB->valueint;
+        vkConfig.uploadSegments = (unsigned int)uploadSegments->valueint;
+        vkConfig.dynamicBufferSizeMB = (unsigned int)dynamicBufferSizeMB->valueint;
         vkConfig.swapInterval = swapInterval->valueint;
+        vkConfig.recordPipelines = (bool) cJSON_IsTrue(recordPipelines);
     }
 
     free_mem_and_return:
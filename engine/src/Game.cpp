@@ -2,8 +2,12 @@
 
 #include "Renderer/Backend/RenderBackend.h"
 #include "ConfigManager.h"
+#include "ReloadLib/sys/AsyncIO.h"
+#include "ReloadLib/sys/JobSystem.h"
 
 static const uint32_t MS_PER_UPDATE = 16;
+static const int ASYNC_IO_FALLBACK_THREADS = 2;                                 // Reader threads when io_uring isn't available.
+static const char * PIPELINE_MANIFEST = "pipelines/game.manifest";              // Pipelines to precompile, until levels have their own.
 
 /*
 ================================================================================
@@ -36,7 +40,10 @@ Initializes all systems for the game.
 void Game::Init() {
 
     InitSDL();
+    jobSystem.Init();
+    asyncIO.Init(ASYNC_IO_FALLBACK_THREADS);
     m_renderSystem.Init();
+    m_renderSystem.PrecompilePipelines(PIPELINE_MANIFEST);
 }
 
 /*
@@ -49,6 +56,8 @@ Shuts down all the systems.
 */
 void Game::Shutdown() {
     m_renderSystem.Shutdown();
+    asyncIO.Shutdown();
+    jobSystem.Shutdown();
 }
 
 /*
@@ -104,15 +113,16 @@ void Game::Update() {
 
 /*
 ================================================================================
-Class::Method
+Game::Render
 
 DESCRIPTION:
-RETURNS:
-NOTE:
+Hands the frame's view to the renderer. There is no scene yet, so the view has
+no surfaces.
 ================================================================================
 */
 void Game::Render() {
-    m_renderSystem.RenderCommandBuffers();
+    m_renderSystem.DrawView(m_renderSystem.AllocView());
+    m_renderSystem.SwapCommandBuffers();
 }
 /*
 ================================================================================
@@ -136,6 +146,7 @@ void Game::Run() {
         lag += deltaTime;
 
         ProcessInput();
+        asyncIO.Poll();
 
         while (lag >= MS_PER_UPDATE) {
             Update();
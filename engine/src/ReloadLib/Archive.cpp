@@ -0,0 +1,220 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Archive.h"
+
+#include "Common.h"
+
+/*
+================================================================================
+Archive::Open
+
+DESCRIPTION:
+Maps the archive and validates the header and the bounds of the index, the
+bucket table and every entry, so lookups never have to check them again.
+
+RETURNS:
+`true` if the archive is ready to use.
+================================================================================
+*/
+bool Archive::Open(const char *path) {
+    Close();
+
+    if (!m_file.Open(path)) {
+        return false;
+    }
+
+    const Span<const uint8_t> data = m_file.Data();
+    const uint64_t fileSize = data.Size();
+
+    if (fileSize < sizeof(ArchiveHeader)) {
+        SDL_LogError(LOG_FILE, "%s is not an archive.", path);
+        m_file.Close();
+        return false;
+    }
+
+    const auto * header = reinterpret_cast<const ArchiveHeader *>(data.Data());
+    const uint64_t entriesSize = static_cast<uint64_t>(header->numEntries) * sizeof(ArchiveEntry);
+    const uint64_t bucketsSize = ((1ull << header->bucketBits) + 1) * sizeof(uint32_t);
+
+    bool valid = header->magic == ARCHIVE_MAGIC
+        && header->version == ARCHIVE_VERSION
+        && header->bucketBits < 32
+        && header->entriesOffset % alignof(ArchiveEntry) == 0
+        && header->entriesOffset <= fileSize && entriesSize <= fileSize - header->entriesOffset
+        && header->bucketsOffset % alignof(uint32_t) == 0
+        && header->bucketsOffset <= fileSize && bucketsSize <= fileSize - header->bucketsOffset
+        && header->namesOffset <= fileSize && header->namesSize <= fileSize - header->namesOffset;
+
+    if (!valid) {
+        SDL_LogError(LOG_FILE, "%s has an invalid archive header.", path);
+        m_file.Close();
+        return false;
+    }
+
+    m_entries = reinterpret_cast<const ArchiveEntry *>(data.Data() + header->entriesOffset);
+    m_buckets = reinterpret_cast<const uint32_t *>(data.Data() + header->bucketsOffset);
+    m_names = reinterpret_cast<const char *>(data.Data() + header->namesOffset);
+
+    const uint32_t numBuckets = 1u << header->bucketBits;
+    valid = m_buckets[numBuckets] == header->numEntries;
+
+    for (uint32_t i = 0; valid && i < numBuckets; i++) {
+        valid = m_buckets[i] <= m_buckets[i + 1];
+    }
+
+    for (uint32_t i = 0; valid && i < header->numEntries; i++) {
+        const ArchiveEntry & entry = m_entries[i];
+
+        valid = entry.offset <= fileSize && entry.storedSize <= fileSize - entry.offset
+            && static_cast<uint64_t>(entry.nameOffset) + entry.nameLength <= header->namesSize
+            && entry.compression == ARCHIVE_COMPRESSION_NONE
+            && entry.size == entry.storedSize;
+    }
+
+    if (!valid) {
+        SDL_LogError(LOG_FILE, "%s has an invalid archive index.", path);
+        m_entries = nullptr;
+        m_buckets = nullptr;
+        m_names = nullptr;
+        m_file.Close();
+        return false;
+    }
+
+    m_header = header;
+
+    // The index is touched by every lookup, keep it resident.
+    m_file.Advise(MAP_ADVICE_RANDOM);
+    m_file.Advise(MAP_ADVICE_WILLNEED, header->entriesOffset, entriesSize);
+    m_file.Advise(MAP_ADVICE_WILLNEED, header->bucketsOffset, bucketsSize);
+
+    return true;
+}
+
+/*
+================================================================================
+Archive::Close
+
+DESCRIPTION:
+Unmaps the archive. Views returned by `Find` become invalid.
+================================================================================
+*/
+void Archive::Close() {
+    m_file.Close();
+
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_buckets = nullptr;
+    m_names = nullptr;
+}
+
+/*
+================================================================================
+Archive::Find
+
+DESCRIPTION:
+Looks up the asset and returns a view of its data in the mapping.
+
+RETURNS:
+`true` if the asset is in the archive.
+================================================================================
+*/
+bool Archive::Find(std::string_view name, Span<const uint8_t> &data) const {
+    const ArchiveEntry * entry = FindEntry(name);
+    if (entry == nullptr) {
+        data = Span<const uint8_t>();
+        return false;
+    }
+
+    data = m_file.Data().Subspan(entry->offset, entry->storedSize);
+    return true;
+}
+
+/*
+================================================================================
+Archive::Locate
+
+DESCRIPTION:
+Looks up the asset and returns the range of its data in the archive file, for
+readers that load it with file reads instead of through the mapping.
+
+RETURNS:
+`true` if the asset is in the archive.
+================================================================================
+*/
+bool Archive::Locate(std::string_view name, uint64_t &offset, uint64_t &size) const {
+    const ArchiveEntry * entry = FindEntry(name);
+    if (entry == nullptr) {
+        offset = 0;
+        size = 0;
+        return false;
+    }
+
+    offset = entry->offset;
+    size = entry->storedSize;
+    return true;
+}
+
+/*
+================================================================================
+Archive::Contains
+
+RETURNS:
+`true` if the asset is in the archive.
+================================================================================
+*/
+bool Archive::Contains(std::string_view name) const {
+    return FindEntry(name) != nullptr;
+}
+
+/*
+================================================================================
+Archive::Prefetch
+
+DESCRIPTION:
+Asks the OS to start paging the asset in, ahead of the actual read.
+================================================================================
+*/
+void Archive::Prefetch(std::string_view name) const {
+    const ArchiveEntry * entry = FindEntry(name);
+    if (entry != nullptr) {
+        m_file.Advise(MAP_ADVICE_WILLNEED, entry->offset, entry->storedSize);
+    }
+}
+
+/*
+================================================================================
+Archive::FindEntry
+
+DESCRIPTION:
+Folds and hashes the name, then scans the entries of its bucket.
+
+RETURNS:
+The entry of the asset, or `nullptr` if it's not in the archive.
+================================================================================
+*/
+const ArchiveEntry * Archive::FindEntry(std::string_view name) const {
+    if (m_header == nullptr) {
+        return nullptr;
+    }
+
+    char buffer[ARCHIVE_MAX_NAME];
+    const std::string_view folded = ArchiveFoldName(name, buffer);
+    if (folded.empty()) {
+        return nullptr;
+    }
+
+    const uint64_t hash = ArchiveHashName(folded);
+    const uint32_t bucket = ArchiveBucket(hash, m_header->bucketBits);
+
+    for (uint32_t i = m_buckets[bucket]; i < m_buckets[bucket + 1]; i++) {
+        const ArchiveEntry & entry = m_entries[i];
+
+        if (entry.hash == hash && std::string_view(m_names + entry.nameOffset, entry.nameLength) == folded) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
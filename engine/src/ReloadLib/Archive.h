@@ -0,0 +1,46 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_ARCHIVE_H
+#define RELOAD_ARCHIVE_H
+
+#include <string_view>
+#include "ReloadLib/ArchiveFormat.h"
+#include "ReloadLib/File.h"
+
+/*
+================================================================================
+Archive
+
+DESCRIPTION:
+Runtime reader of packed asset archives. The whole archive is memory mapped
+once, lookups go through the bucket table of the index and the assets are
+served as views straight into the mapping, so loading an asset costs no system
+calls and no copies. See ArchiveFormat.h for the layout.
+================================================================================
+*/
+class Archive {
+public:
+    bool            Open(const char *path);                                     // Maps and validates the archive. Returns `false` on failure.
+    void            Close();                                                    // Unmaps the archive, invalidating all the views.
+
+    bool            Find(std::string_view name, Span<const uint8_t> &data) const;   // Gets a view of the asset. Returns `false` if it's not in the archive.
+    bool            Locate(std::string_view name, uint64_t &offset, uint64_t &size) const;  // Gets the range of the asset in the file. Returns `false` if it's not in the archive.
+    bool            Contains(std::string_view name) const;                      // Checks whether the asset is in the archive.
+    void            Prefetch(std::string_view name) const;                      // Starts paging in the asset.
+
+    [[nodiscard]] int   NumEntries() const { return m_header != nullptr ? static_cast<int>(m_header->numEntries) : 0; }
+    [[nodiscard]] bool  IsOpen() const { return m_header != nullptr; }
+
+private:
+    MappedFile              m_file;
+    const ArchiveHeader *   m_header = nullptr;
+    const ArchiveEntry *    m_entries = nullptr;
+    const uint32_t *        m_buckets = nullptr;
+    const char *            m_names = nullptr;
+
+    const ArchiveEntry *    FindEntry(std::string_view name) const;
+};
+
+#endif //RELOAD_ARCHIVE_H
@@ -0,0 +1,115 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_ARCHIVE_FORMAT_H
+#define RELOAD_ARCHIVE_FORMAT_H
+
+#include <cstdint>
+#include <string_view>
+#include "ReloadLib/Hash.h"
+
+/*
+================================================================================
+Archive format
+
+DESCRIPTION:
+On-disk layout of the packed asset archives, shared by the packer tool and the
+runtime reader. All values are little endian.
+
+    ArchiveHeader
+    blobs                   each one starts on an ARCHIVE_ALIGNMENT boundary
+    ArchiveEntry[]          sorted by name hash
+    uint32_t[]              bucket table, (1 << bucketBits) + 1 entry indices
+    char[]                  folded entry names, not NUL terminated
+
+The bucket table indexes the sorted entries by the top bits of the name hash,
+so a lookup hashes the name, reads two bucket bounds and scans the one or two
+entries of the bucket. Names are kept to rule out hash collisions.
+
+Names are folded before hashing: lower case with forward slashes, the extension
+is kept since the same base name can exist in several formats.
+================================================================================
+*/
+static const uint32_t ARCHIVE_MAGIC = 0x4B415052;                               // "RPAK"
+static const uint32_t ARCHIVE_VERSION = 1;
+static const uint64_t ARCHIVE_ALIGNMENT = 4096;
+static const uint32_t ARCHIVE_MAX_NAME = 1024;
+
+enum ArchiveCompression : uint32_t {
+    ARCHIVE_COMPRESSION_NONE = 0                                                // Stored as is, served as a view of the mapping.
+};
+
+struct ArchiveHeader {
+    uint32_t            magic;
+    uint32_t            version;
+    uint32_t            numEntries;
+    uint32_t            bucketBits;
+    uint64_t            entriesOffset;
+    uint64_t            bucketsOffset;
+    uint64_t            namesOffset;
+    uint64_t            namesSize;
+};
+
+struct ArchiveEntry {
+    uint64_t            hash;                                                   // ArchiveHashName of the folded name.
+    uint64_t            offset;                                                 // Start of the blob in the file.
+    uint64_t            size;                                                   // Size of the asset once decompressed.
+    uint64_t            storedSize;                                             // Size of the blob in the file.
+    uint32_t            nameOffset;                                             // Offset into the names block.
+    uint32_t            nameLength;
+    uint32_t            compression;                                            // ArchiveCompression.
+    uint32_t            reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader layout changed.");
+static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry layout changed.");
+
+/*
+================================================================================
+ArchiveFoldName
+
+DESCRIPTION:
+Folds the name into the buffer: lower case with forward slashes.
+
+RETURNS:
+The folded name, or an empty view if the name doesn't fit.
+================================================================================
+*/
+inline std::string_view ArchiveFoldName(std::string_view name, char (&buffer)[ARCHIVE_MAX_NAME]) {
+    if (name.length() > ARCHIVE_MAX_NAME) {
+        return std::string_view();
+    }
+
+    for (size_t i = 0; i < name.length(); i++) {
+        buffer[i] = name[i] == '\\' ? '/' : Hash::ToLower(name[i]);
+    }
+
+    return std::string_view(buffer, name.length());
+}
+
+/*
+================================================================================
+ArchiveHashName
+
+RETURNS:
+The hash of a folded name.
+================================================================================
+*/
+inline uint64_t ArchiveHashName(std::string_view foldedName) {
+    return Hash::Fnv1a64I(foldedName);
+}
+
+/*
+================================================================================
+ArchiveBucket
+
+RETURNS:
+The bucket of the hash for a table with the given number of bits.
+================================================================================
+*/
+inline uint32_t ArchiveBucket(uint64_t hash, uint32_t bucketBits) {
+    return bucketBits == 0 ? 0 : static_cast<uint32_t>(hash >> (64 - bucketBits));
+}
+
+#endif //RELOAD_ARCHIVE_FORMAT_H
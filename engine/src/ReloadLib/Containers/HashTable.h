@@ -0,0 +1,487 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_HASH_TABLE_H
+#define RELOAD_HASH_TABLE_H
+
+#include <cassert>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "Common.h"
+#include "ReloadLib/Hash.h"
+#include "ReloadLib/Extensions/Str.h"
+#include "ReloadLib/sys/Heap.h"
+
+/*
+================================================================================
+HashTraits<K>
+
+DESCRIPTION:
+Default hashing policy for integer, enum and pointer keys. A traits type has to
+provide `GetHash` and `Equals` for the stored key type and for any other type
+the table is queried with.
+================================================================================
+*/
+template<typename K>
+struct HashTraits {
+    static inline uint32_t  GetHash(const K &key) {
+        if constexpr (std::is_pointer<K>::value) {
+            return Hash::Int(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)));
+        } else {
+            return Hash::Int(static_cast<uint64_t>(key));
+        }
+    }
+
+    static inline bool      Equals(const K &a, const K &b) { return a == b; }
+};
+
+/*
+================================================================================
+StringHashTraitsI
+
+DESCRIPTION:
+Case-insensitive hashing policy for `std::string` keys. Both functions take a
+`std::string_view`, so the table can be queried with views and literals without
+building a temporary string.
+================================================================================
+*/
+struct StringHashTraitsI {
+    static inline uint32_t  GetHash(std::string_view key) { return Hash::Fnv1aI(key); }
+    static inline bool      Equals(std::string_view a, std::string_view b) { return Str::CompareI(a, b); }
+};
+
+/*
+================================================================================
+HashTable<K, V, Traits>
+
+DESCRIPTION:
+Open addressing hash table with Robin Hood linear probing. The full 32-bit hash
+of every entry is kept in a separate array, so probing walks a dense array of
+integers and only touches a key when the hashes match. A hash of 0 marks an
+empty slot. Removal uses backward shifting, which keeps the probe sequences
+short without tombstones.
+
+Lookups are templated on the query type and go through the traits, which makes
+heterogeneous lookups such as `std::string_view` against `std::string` keys
+allocation free.
+
+NOTE:
+Pointers to values are invalidated by any insertion or removal.
+================================================================================
+*/
+template<typename K, typename V, typename Traits = HashTraits<K>>
+class HashTable {
+public:
+    struct Entry {
+        K               key;
+        V               value;
+    };
+
+    class Iterator {
+    public:
+                        Iterator(const HashTable * table, int index) : m_table(table), m_index(index) { SkipEmpty(); }
+
+        Entry &         operator*() const { return m_table->m_entries[m_index]; }
+        Entry *         operator->() const { return &m_table->m_entries[m_index]; }
+        Iterator &      operator++() { m_index++; SkipEmpty(); return *this; }
+        bool            operator!=(const Iterator &other) const { return m_index != other.m_index; }
+
+    private:
+        const HashTable *   m_table;
+        int                 m_index;
+
+        void            SkipEmpty() {
+            while (m_index < m_table->m_capacity && m_table->m_hashes[m_index] == 0) {
+                m_index++;
+            }
+        }
+    };
+
+    explicit            HashTable(int initialCapacity = 0);
+                        HashTable(const HashTable &other) = delete;
+                        ~HashTable();
+
+    HashTable &         operator=(const HashTable &other) = delete;
+
+    template<typename L>
+    V *                 Find(const L &key) const;                               // Finds the value for the key. Returns `nullptr` if it isn't in the table.
+    template<typename L>
+    bool                Contains(const L &key) const;                           // Checks whether the key is in the table.
+    template<typename L>
+    V &                 Set(const L &key, V value);                             // Inserts or replaces the value for the key. Returns reference to the stored value.
+    template<typename L>
+    bool                Remove(const L &key);                                   // Removes the key. Returns `false` if it wasn't in the table.
+
+    void                Clear();                                                // Destroys all entries, keeps the storage.
+    void                Reserve(int count);                                     // Grows the table to hold the given number of entries without rehashing.
+
+    Iterator            begin() const { return Iterator(this, 0); }
+    Iterator            end() const { return Iterator(this, m_capacity); }
+
+    [[nodiscard]] int   Size() const { return m_size; }                         // Gets the number of entries in the table.
+    [[nodiscard]] int   Capacity() const { return m_capacity; }                 // Gets the number of slots in the table.
+    [[nodiscard]] size_t MemoryUsed() const;                                    // Gets the memory used by the slots.
+
+private:
+    static const int    MIN_CAPACITY = 16;
+
+    uint32_t *          m_hashes;                                               // Hash per slot, 0 when the slot is empty.
+    Entry *             m_entries;                                              // Raw storage, only slots with a hash are constructed.
+    int                 m_capacity;                                             // Always a power of two.
+    int                 m_size;
+
+    template<typename L>
+    static uint32_t     HashKey(const L &key);
+    int                 ProbeDistance(uint32_t hash, int slot) const;
+    template<typename L>
+    int                 FindSlot(const L &key, uint32_t hash) const;
+    int                 InsertNew(uint32_t hash, Entry &&entry);
+    void                Rehash(int newCapacity);
+};
+
+/*
+================================================================================
+HashTable<K, V, Traits>::HashTable
+
+DESCRIPTION:
+Creates the table, allocating the slots up front if a capacity is given.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline HashTable<K, V, Traits>::HashTable(int initialCapacity) {
+    m_hashes = nullptr;
+    m_entries = nullptr;
+    m_capacity = 0;
+    m_size = 0;
+
+    if (initialCapacity > 0) {
+        Reserve(initialCapacity);
+    }
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::~HashTable
+
+DESCRIPTION:
+Destroys the entries and frees the slots.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline HashTable<K, V, Traits>::~HashTable() {
+    Clear();
+    Mem::Free(m_hashes);
+    Mem::Free(m_entries);
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Find
+
+DESCRIPTION:
+Looks up the value stored for the key. The key can be of any type the traits
+can hash and compare against the stored keys.
+
+RETURNS:
+Pointer to the value, or `nullptr` if the key is not in the table.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline V * HashTable<K, V, Traits>::Find(const L &key) const {
+    const int slot = FindSlot(key, HashKey(key));
+    return slot >= 0 ? &m_entries[slot].value : nullptr;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Contains
+
+RETURNS:
+`true` if the key is in the table.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline bool HashTable<K, V, Traits>::Contains(const L &key) const {
+    return FindSlot(key, HashKey(key)) >= 0;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Set
+
+DESCRIPTION:
+Replaces the value of an existing key, or inserts a new entry. The stored key
+is only constructed from the given one when a new entry is inserted.
+
+RETURNS:
+Reference to the stored value.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline V & HashTable<K, V, Traits>::Set(const L &key, V value) {
+    const uint32_t hash = HashKey(key);
+
+    const int slot = FindSlot(key, hash);
+    if (slot >= 0) {
+        m_entries[slot].value = std::move(value);
+        return m_entries[slot].value;
+    }
+
+    if ((m_size + 1) * 8 > m_capacity * 7) {
+        Rehash(m_capacity > 0 ? m_capacity * 2 : MIN_CAPACITY);
+    }
+
+    return m_entries[InsertNew(hash, Entry{ K(key), std::move(value) })].value;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Remove
+
+DESCRIPTION:
+Removes the entry for the key and shifts the following entries of the probe
+sequence back by one slot.
+
+RETURNS:
+`true` if the key was removed, `false` if it wasn't in the table.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline bool HashTable<K, V, Traits>::Remove(const L &key) {
+    int slot = FindSlot(key, HashKey(key));
+    if (slot < 0) {
+        return false;
+    }
+
+    const int mask = m_capacity - 1;
+    m_entries[slot].~Entry();
+
+    int next = (slot + 1) & mask;
+    while (m_hashes[next] != 0 && ProbeDistance(m_hashes[next], next) > 0) {
+        new (&m_entries[slot]) Entry(std::move(m_entries[next]));
+        m_entries[next].~Entry();
+        m_hashes[slot] = m_hashes[next];
+
+        slot = next;
+        next = (next + 1) & mask;
+    }
+
+    m_hashes[slot] = 0;
+    m_size--;
+
+    return true;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Clear
+
+DESCRIPTION:
+Destroys all the entries. The slots are kept for reuse.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline void HashTable<K, V, Traits>::Clear() {
+    for (int i = 0; i < m_capacity; i++) {
+        if (m_hashes[i] != 0) {
+            m_entries[i].~Entry();
+            m_hashes[i] = 0;
+        }
+    }
+
+    m_size = 0;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Reserve
+
+DESCRIPTION:
+Grows the table so that the given number of entries fit under the load factor.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline void HashTable<K, V, Traits>::Reserve(int count) {
+    int newCapacity = MIN_CAPACITY;
+    while (count * 8 > newCapacity * 7) {
+        newCapacity *= 2;
+    }
+
+    if (newCapacity > m_capacity) {
+        Rehash(newCapacity);
+    }
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::MemoryUsed
+
+RETURNS:
+The memory used by the slots in bytes.
+
+NOTES:
+Doesn't take into account additional memory allocated by the keys or values.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline size_t HashTable<K, V, Traits>::MemoryUsed() const {
+    return static_cast<size_t>(m_capacity) * (sizeof(uint32_t) + sizeof(Entry));
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::HashKey
+
+DESCRIPTION:
+Hashes the key through the traits, moving 0 out of the way since it marks an
+empty slot.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline uint32_t HashTable<K, V, Traits>::HashKey(const L &key) {
+    const uint32_t hash = Traits::GetHash(key);
+    return hash != 0 ? hash : 1;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::ProbeDistance
+
+RETURNS:
+How far the entry with the given hash sits from its home slot.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline int HashTable<K, V, Traits>::ProbeDistance(uint32_t hash, int slot) const {
+    const int mask = m_capacity - 1;
+    return (slot - static_cast<int>(hash & static_cast<uint32_t>(mask))) & mask;
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::FindSlot
+
+DESCRIPTION:
+Walks the probe sequence of the hash. The walk stops early as soon as it meets
+an entry that is closer to its home slot than the key would be, since Robin
+Hood insertion would have placed the key before it.
+
+RETURNS:
+The slot of the key, or -1 if it's not in the table.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+template<typename L>
+inline int HashTable<K, V, Traits>::FindSlot(const L &key, uint32_t hash) const {
+    if (m_size == 0) {
+        return -1;
+    }
+
+    const int mask = m_capacity - 1;
+    int slot = static_cast<int>(hash & static_cast<uint32_t>(mask));
+
+    for (int distance = 0; ; distance++) {
+        const uint32_t slotHash = m_hashes[slot];
+
+        if (slotHash == 0 || ProbeDistance(slotHash, slot) < distance) {
+            return -1;
+        }
+
+        if (slotHash == hash && Traits::Equals(m_entries[slot].key, key)) {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::InsertNew
+
+DESCRIPTION:
+Inserts an entry that is known not to be in the table. Whenever the carried
+entry is further from home than the resident one, the two are swapped and the
+resident continues the probe.
+
+RETURNS:
+The slot the new entry ended up in.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline int HashTable<K, V, Traits>::InsertNew(uint32_t hash, Entry &&entry) {
+    const int mask = m_capacity - 1;
+    int slot = static_cast<int>(hash & static_cast<uint32_t>(mask));
+    int result = -1;
+
+    Entry carried(std::move(entry));
+    int distance = 0;
+
+    for (;;) {
+        const uint32_t slotHash = m_hashes[slot];
+
+        if (slotHash == 0) {
+            new (&m_entries[slot]) Entry(std::move(carried));
+            m_hashes[slot] = hash;
+            m_size++;
+            return result >= 0 ? result : slot;
+        }
+
+        const int slotDistance = ProbeDistance(slotHash, slot);
+        if (slotDistance < distance) {
+            std::swap(carried, m_entries[slot]);
+            std::swap(hash, m_hashes[slot]);
+            distance = slotDistance;
+
+            if (result < 0) {
+                result = slot;
+            }
+        }
+
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+}
+
+/*
+================================================================================
+HashTable<K, V, Traits>::Rehash
+
+DESCRIPTION:
+Moves all the entries into a new set of slots of the given power of two size.
+================================================================================
+*/
+template<typename K, typename V, typename Traits>
+inline void HashTable<K, V, Traits>::Rehash(int newCapacity) {
+    assert(newCapacity > 0 && (newCapacity & (newCapacity - 1)) == 0);
+    assert(newCapacity * 7 >= m_size * 8);
+
+    uint32_t * oldHashes = m_hashes;
+    Entry * oldEntries = m_entries;
+    const int oldCapacity = m_capacity;
+
+    m_hashes = static_cast<uint32_t *>(Mem::ClearedAlloc(sizeof(uint32_t) * static_cast<size_t>(newCapacity)));
+    m_entries = static_cast<Entry *>(Mem::Alloc(sizeof(Entry) * static_cast<size_t>(newCapacity)));
+    m_capacity = newCapacity;
+    m_size = 0;
+
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldHashes[i] != 0) {
+            InsertNew(oldHashes[i], std::move(oldEntries[i]));
+            oldEntries[i].~Entry();
+        }
+    }
+
+    Mem::Free(oldHashes);
+    Mem::Free(oldEntries);
+}
+
+#endif //RELOAD_HASH_TABLE_H
@@ -0,0 +1,685 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_INLINE_LIST_H
+#define RELOAD_INLINE_LIST_H
+
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Common.h"
+#include "ReloadLib/sys/Heap.h"
+
+/*
+================================================================================
+InlineList<T, N>
+
+DESCRIPTION:
+Companion of `List<T>` for lists that usually hold only a handful of elements.
+The first N elements are stored inside the object itself, so small lists never
+touch the heap. Once the list grows past N elements its contents spill into a
+block from `Mem::Alloc` which doubles in size as needed.
+
+Only the first `Size()` elements are constructed, the rest of the capacity is
+raw storage.
+
+NOTE:
+Moving an inline list moves the elements one by one while they are stored
+inline, only a spilled block is taken over as a whole.
+================================================================================
+*/
+template<typename T, int N>
+class InlineList {
+    static_assert(N > 0, "InlineList needs room for at least one inline element.");
+
+public:
+                    InlineList();
+                    InlineList(const InlineList &other);
+                    InlineList(InlineList &&other) noexcept;
+                    ~InlineList();
+
+    InlineList &    operator=(const InlineList &other);
+    InlineList &    operator=(InlineList &&other) noexcept;
+    const T &       operator[](int index) const;
+    T &             operator[](int index);
+
+    T *             Data();                                                     // Gets the pointer to the underlying array.
+    const T *       Data() const;                                               // Gets the pointer to the underlying array.
+
+    T &             Alloc();                                                    // Allocates new element at the end. Returns reference to the element.
+    int             Add(T const & obj);                                         // Adds element to the end. Returns the index of the element.
+    int             Add(T && obj);                                              // Moves element to the end. Returns the index of the element.
+    int             AddUnique(T const & obj);                                   // Adds unique element to the end. Returns the index of the element.
+    bool            RemoveIndex(int index);                                     // Removes the element at the given index.
+    bool            RemoveIndexFast(int index);                                 // Removes the element at the given index and places the last element into its spot - DOES NOT PRESERVE LIST ORDER.
+    bool            Remove(T const & obj);                                      // Removes the given element.
+    void            Clear();                                                    // Destroys the elements and returns to the inline storage.
+
+    void            Resize(int newSize);                                        // Resizes the storage to the given number of elements, never below N.
+    void            SetSize(int newSize);                                       // Sets the number of elements, new elements are default constructed.
+
+    int             IndexOf(T const & obj) const;                               // Finds and returns the index for the given element reference.
+    T *             Find(T const & obj) const;                                  // Finds and returns a pointer to the given element reference.
+    [[nodiscard]] int   Size() const;                                           // Gets the number of elements in the list.
+    [[nodiscard]] int   AllocatedCount() const;                                 // Gets the number of elements currently allocated for.
+    [[nodiscard]] bool  IsInline() const;                                       // Checks whether the elements are still in the inline storage.
+    [[nodiscard]] size_t MemoryUsed() const;                                    // Gets the heap memory used by the list.
+
+private:
+    int             m_size;
+    int             m_capacity;
+    T *             m_list;                                                     // Points either to m_inline or to the spilled heap block.
+    alignas(T) unsigned char m_inline[sizeof(T) * N];
+
+    T *             InlineData();
+    void            Relocate(int newCapacity);                                  // Moves the elements into storage of the given capacity.
+    void            Grow();                                                     // Doubles the capacity.
+    void            DestroyRange(int from, int to);                             // Destroys the elements in the range.
+};
+
+/*
+================================================================================
+InlineList<T, N>::InlineList
+
+DESCRIPTION:
+Creates an empty list using the inline storage.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N>::InlineList() {
+    m_size = 0;
+    m_capacity = N;
+    m_list = InlineData();
+}
+
+/*
+================================================================================
+InlineList<T, N>::InlineList
+
+DESCRIPTION:
+The list's copy constructor.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N>::InlineList(const InlineList &other) : InlineList() {
+    *this = other;
+}
+
+/*
+================================================================================
+InlineList<T, N>::InlineList
+
+DESCRIPTION:
+The list's move constructor. Takes over a spilled block, moves inline elements.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N>::InlineList(InlineList &&other) noexcept : InlineList() {
+    *this = std::move(other);
+}
+
+/*
+================================================================================
+InlineList<T, N>::~InlineList
+
+DESCRIPTION:
+The list's destructor.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N>::~InlineList() {
+    Clear();
+}
+
+/*
+================================================================================
+InlineList<T, N>::operator=
+
+DESCRIPTION:
+Copies the contents of another list.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N> & InlineList<T, N>::operator=(const InlineList &other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    Clear();
+    Resize(other.m_size);
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memcpy(static_cast<void *>(m_list), other.m_list, sizeof(T) * static_cast<size_t>(other.m_size));
+    } else {
+        for (int i = 0; i < other.m_size; i++) {
+            new (&m_list[i]) T(other.m_list[i]);
+        }
+    }
+
+    m_size = other.m_size;
+    return *this;
+}
+
+/*
+================================================================================
+InlineList<T, N>::operator=
+
+DESCRIPTION:
+Takes over the contents of another list, which is left empty.
+================================================================================
+*/
+template<typename T, int N>
+inline InlineList<T, N> & InlineList<T, N>::operator=(InlineList &&other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    Clear();
+
+    if (!other.IsInline()) {
+        m_list = other.m_list;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_list = other.InlineData();
+        other.m_size = 0;
+        other.m_capacity = N;
+        return *this;
+    }
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memcpy(static_cast<void *>(m_list), other.m_list, sizeof(T) * static_cast<size_t>(other.m_size));
+    } else {
+        for (int i = 0; i < other.m_size; i++) {
+            new (&m_list[i]) T(std::move(other.m_list[i]));
+        }
+    }
+
+    m_size = other.m_size;
+    other.Clear();
+    return *this;
+}
+
+/*
+================================================================================
+InlineList<T, N>::operator[]
+
+DESCRIPTION:
+Access operator.
+
+RETURNS:
+Reference to the element at the given index.
+================================================================================
+*/
+template<typename T, int N>
+inline const T & InlineList<T, N>::operator[](int index) const {
+    assert(index >= 0);
+    assert(index < m_size);
+
+    return m_list[index];
+}
+
+template<typename T, int N>
+inline T & InlineList<T, N>::operator[](int index) {
+    assert(index >= 0);
+    assert(index < m_size);
+
+    return m_list[index];
+}
+
+/*
+================================================================================
+InlineList<T, N>::Data
+
+DESCRIPTION:
+Gets the pointer to the underlying array.
+================================================================================
+*/
+template<typename T, int N>
+inline T * InlineList<T, N>::Data() {
+    return m_list;
+}
+
+template<typename T, int N>
+inline const T * InlineList<T, N>::Data() const {
+    return m_list;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Alloc
+
+DESCRIPTION:
+Default constructs a new element at the end of the list.
+
+RETURNS:
+Reference to the new element.
+================================================================================
+*/
+template<typename T, int N>
+inline T & InlineList<T, N>::Alloc() {
+    if (m_size == m_capacity) {
+        Grow();
+    }
+
+    new (&m_list[m_size]) T;
+    return m_list[m_size++];
+}
+
+/*
+================================================================================
+InlineList<T, N>::Add
+
+DESCRIPTION:
+Increases the size of the list by one element and copies the given data into it.
+
+RETURNS:
+The index of the new element.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::Add(T const & obj) {
+    if (m_size == m_capacity) {
+        // The element may live in this list, copy it before the storage moves.
+        T copy(obj);
+        Grow();
+        new (&m_list[m_size]) T(std::move(copy));
+    } else {
+        new (&m_list[m_size]) T(obj);
+    }
+
+    return m_size++;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Add
+
+DESCRIPTION:
+Increases the size of the list by one element and moves the given data into it.
+
+RETURNS:
+The index of the new element.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::Add(T && obj) {
+    if (m_size == m_capacity) {
+        T moved(std::move(obj));
+        Grow();
+        new (&m_list[m_size]) T(std::move(moved));
+    } else {
+        new (&m_list[m_size]) T(std::move(obj));
+    }
+
+    return m_size++;
+}
+
+/*
+================================================================================
+InlineList<T, N>::AddUnique
+
+DESCRIPTION:
+Adds the data to the list if it doesn't already exist.
+
+RETURNS:
+The index of the data in the list.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::AddUnique(T const & obj) {
+    int index = IndexOf(obj);
+
+    if (index < 0) {
+        index = Add(obj);
+    }
+
+    return index;
+}
+
+/*
+================================================================================
+InlineList<T, N>::RemoveIndex
+
+DESCRIPTION:
+Removes the element at the given index and moves the following elements down.
+
+RETURNS:
+`true` if the element was removed, `false` if the index is out of range.
+================================================================================
+*/
+template<typename T, int N>
+inline bool InlineList<T, N>::RemoveIndex(int index) {
+    assert(index >= 0);
+    assert(index < m_size);
+
+    if (index < 0 || index >= m_size) {
+        return false;
+    }
+
+    m_size--;
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memmove(static_cast<void *>(&m_list[index]), &m_list[index + 1], sizeof(T) * static_cast<size_t>(m_size - index));
+    } else {
+        for (int i = index; i < m_size; i++) {
+            m_list[i] = std::move(m_list[i + 1]);
+        }
+        m_list[m_size].~T();
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+InlineList<T, N>::RemoveIndexFast
+
+DESCRIPTION:
+Removes the element at the given index and places the last element into its
+spot. Does not preserve the order of the list.
+
+RETURNS:
+`true` if the element was removed, `false` if the index is out of range.
+================================================================================
+*/
+template<typename T, int N>
+inline bool InlineList<T, N>::RemoveIndexFast(int index) {
+    if (index < 0 || index >= m_size) {
+        return false;
+    }
+
+    m_size--;
+    if (index != m_size) {
+        m_list[index] = std::move(m_list[m_size]);
+    }
+
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        m_list[m_size].~T();
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Remove
+
+DESCRIPTION:
+Removes the given element from the list.
+
+RETURNS:
+`true` if the element was found and removed.
+================================================================================
+*/
+template<typename T, int N>
+inline bool InlineList<T, N>::Remove(T const & obj) {
+    int index = IndexOf(obj);
+
+    if (index >= 0) {
+        return RemoveIndex(index);
+    }
+
+    return false;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Clear
+
+DESCRIPTION:
+Destroys the elements, frees the spilled block if there is one and returns the
+list to its inline storage.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::Clear() {
+    DestroyRange(0, m_size);
+
+    if (!IsInline()) {
+        Mem::Free(m_list);
+    }
+
+    m_list = InlineData();
+    m_size = 0;
+    m_capacity = N;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Resize
+
+DESCRIPTION:
+Resizes the storage to hold the given number of elements while keeping the
+contents intact. The capacity never goes below N, shrinking to N or less moves
+the elements back into the inline storage. Elements that don't fit are
+destroyed.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::Resize(int newSize) {
+    assert(newSize >= 0);
+
+    if (newSize < N) {
+        newSize = N;
+    }
+
+    if (newSize == m_capacity) {
+        return;
+    }
+
+    if (newSize < m_size) {
+        DestroyRange(newSize, m_size);
+        m_size = newSize;
+    }
+
+    Relocate(newSize);
+}
+
+/*
+================================================================================
+InlineList<T, N>::SetSize
+
+DESCRIPTION:
+Sets the number of elements, growing the storage if needed. New elements are
+default constructed, extra elements are destroyed.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::SetSize(int newSize) {
+    assert(newSize >= 0);
+
+    if (newSize > m_capacity) {
+        Resize(newSize);
+    }
+
+    if constexpr (!std::is_trivially_default_constructible<T>::value) {
+        for (int i = m_size; i < newSize; i++) {
+            new (&m_list[i]) T;
+        }
+    }
+    DestroyRange(newSize, m_size);
+
+    m_size = newSize;
+}
+
+/*
+================================================================================
+InlineList<T, N>::IndexOf
+
+RETURNS:
+The index of the given element, or -1 if it's not in the list.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::IndexOf(T const & obj) const {
+    for (int i = 0; i < m_size; i++) {
+        if (m_list[i] == obj) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Find
+
+RETURNS:
+Pointer to the given element, or `nullptr` if it's not in the list.
+================================================================================
+*/
+template<typename T, int N>
+inline T * InlineList<T, N>::Find(T const & obj) const {
+    int index = IndexOf(obj);
+
+    if (index >= 0) {
+        return &m_list[index];
+    }
+
+    return nullptr;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Size
+
+RETURNS:
+The number of elements in the list.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::Size() const {
+    return m_size;
+}
+
+/*
+================================================================================
+InlineList<T, N>::AllocatedCount
+
+RETURNS:
+The number of elements the list has room for.
+================================================================================
+*/
+template<typename T, int N>
+inline int InlineList<T, N>::AllocatedCount() const {
+    return m_capacity;
+}
+
+/*
+================================================================================
+InlineList<T, N>::IsInline
+
+RETURNS:
+`true` while the elements are stored inside the list object.
+================================================================================
+*/
+template<typename T, int N>
+inline bool InlineList<T, N>::IsInline() const {
+    return m_list == reinterpret_cast<const T *>(m_inline);
+}
+
+/*
+================================================================================
+InlineList<T, N>::MemoryUsed
+
+RETURNS:
+The heap memory used by the list in bytes, zero while the list is inline.
+
+NOTES:
+Doesn't take into account additional memory allocated by T
+================================================================================
+*/
+template<typename T, int N>
+inline size_t InlineList<T, N>::MemoryUsed() const {
+    return IsInline() ? 0 : sizeof(T) * static_cast<size_t>(m_capacity);
+}
+
+/*
+================================================================================
+InlineList<T, N>::InlineData
+
+RETURNS:
+Pointer to the inline storage.
+================================================================================
+*/
+template<typename T, int N>
+inline T * InlineList<T, N>::InlineData() {
+    return reinterpret_cast<T *>(m_inline);
+}
+
+/*
+================================================================================
+InlineList<T, N>::Relocate
+
+DESCRIPTION:
+Moves the elements into the inline storage when the new capacity fits into it,
+otherwise into a new heap block. Trivially copyable elements are copied as raw
+memory, everything else is move constructed and the old elements destroyed.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::Relocate(int newCapacity) {
+    assert(newCapacity >= m_size);
+
+    const bool toInline = newCapacity <= N;
+    if (toInline && IsInline()) {
+        return;
+    }
+
+    T * newList = toInline
+        ? InlineData()
+        : static_cast<T *>(Mem::Alloc(sizeof(T) * static_cast<size_t>(newCapacity)));
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memcpy(static_cast<void *>(newList), m_list, sizeof(T) * static_cast<size_t>(m_size));
+    } else {
+        for (int i = 0; i < m_size; i++) {
+            new (&newList[i]) T(std::move(m_list[i]));
+        }
+        DestroyRange(0, m_size);
+    }
+
+    if (!IsInline()) {
+        Mem::Free(m_list);
+    }
+
+    m_list = newList;
+    m_capacity = toInline ? N : newCapacity;
+}
+
+/*
+================================================================================
+InlineList<T, N>::Grow
+
+DESCRIPTION:
+Doubles the capacity, spilling to the heap the first time the inline storage
+runs out.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::Grow() {
+    Relocate(m_capacity * 2);
+}
+
+/*
+================================================================================
+InlineList<T, N>::DestroyRange
+
+DESCRIPTION:
+Destroys the elements in the [from, to) range of the storage.
+================================================================================
+*/
+template<typename T, int N>
+inline void InlineList<T, N>::DestroyRange(int from, int to) {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (int i = from; i < to; i++) {
+            m_list[i].~T();
+        }
+    }
+}
+
+#endif //RELOAD_INLINE_LIST_H
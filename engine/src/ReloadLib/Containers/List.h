@@ -6,84 +6,108 @@
 #define RELOAD_LIST_H
 
 #include <cassert>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "Common.h"
 #include "ReloadLib/sys/Heap.h"
+#include "ReloadLib/Containers/Sort.h"
 
 /*
 ================================================================================
-List<T>::NewInternal
+AllocArray
 
 DESCRIPTION:
-Internal method for creating a new list to the given number of elements, and
-if needed zeroing it out.
+Internal method for allocating storage for the given number of elements. The
+elements are NOT constructed, the list constructs them as they are added.
 
 RETURNS:
-Pointer to the list.
+Pointer to the storage.
 ================================================================================
 */
-template<typename T>
-inline T * NewArray(int newSize, bool zeroBuffer) {
-    T * ptr;
-
-    if (zeroBuffer) {
-        ptr = static_cast<T *>(Mem::ClearedAlloc(sizeof(T) * newSize));
-    }
-    else {
-        ptr = static_cast<T *>(Mem::Alloc(sizeof(T) * newSize));
-    }
-
-    for (int i = 0; i < newSize; i++) {
-        new (&ptr[i]) T;
-    }
-
-    return ptr;
+template<typename T, typename Allocator = HeapAllocator>
+inline T * AllocArray(int capacity) {
+    return static_cast<T *>(Allocator::Alloc(sizeof(T) * static_cast<size_t>(capacity)));
 }
 
 /*
 ================================================================================
-List<T>::DeleteInternal
+DeleteArray
 
 DESCRIPTION:
-Internal method that calls the destructors on all the elements in the list,
-and frees up the allocated memory.
+Internal method that calls the destructors on the first `size` elements of the
+storage, and frees up the allocated memory.
 ================================================================================
 */
-template<typename T>
+template<typename T, typename Allocator = HeapAllocator>
 inline void DeleteArray(T *list, int size) {
-    for (int i = 0; i < size; i++) {
-        list[i].~T();
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (int i = 0; i < size; i++) {
+            list[i].~T();
+        }
     }
-    Mem::Free(list);
+    Allocator::Free(list);
 }
 
-
 /*
 ================================================================================
-List<T>::ResizeInternal
+ResizeArray
 
 DESCRIPTION:
-Internal method for resizing list to the given number of elements, and if needed
-zeroing it out.
+Internal method for moving the first `size` elements into storage with room for
+`newCapacity` elements. Elements that don't fit are destroyed. Trivially
+copyable types are relocated with a single realloc, everything else is move
+constructed into the new storage and the old elements are destroyed.
+
+RETURNS:
+Pointer to the new storage.
 ================================================================================
 */
-template<typename T>
-inline T * ResizeArray(T * oldList, int oldSize, int newSize, bool zeroBuffer) {
-    T * newList = nullptr;
+template<typename T, typename Allocator = HeapAllocator>
+inline T * ResizeArray(T * oldList, int size, int oldCapacity, int newCapacity) {
+    assert(size <= oldCapacity);
 
-    if (newSize > 0) {
-        newList = NewArray<T>(newSize, zeroBuffer);
-        int overlap = std::min(oldSize, newSize);
+    if (newCapacity <= 0) {
+        DeleteArray<T, Allocator>(oldList, size);
+        return nullptr;
+    }
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        return static_cast<T *>(Allocator::Realloc(
+                oldList,
+                sizeof(T) * static_cast<size_t>(oldCapacity),
+                sizeof(T) * static_cast<size_t>(newCapacity)));
+    } else {
+        T * newList = AllocArray<T, Allocator>(newCapacity);
+        const int overlap = std::min(size, newCapacity);
 
         for (int i = 0; i < overlap; i++) {
-            newList[i] = oldList[i];
+            new (&newList[i]) T(std::move(oldList[i]));
         }
-    }
 
-    DeleteArray<T>(oldList, oldSize);
-    return newList;
+        DeleteArray<T, Allocator>(oldList, size);
+        return newList;
+    }
 }
 
-template<typename T>
+/*
+================================================================================
+List<T>
+
+DESCRIPTION:
+Dynamically growing array of elements. The allocator policy decides where the
+elements are stored, the heap by default, or the current frame arena when
+`FrameAllocator` is used for per-frame temporaries.
+
+Only the first `Size()` elements are constructed, the rest of the allocated
+capacity is raw storage.
+
+NOTE:
+A list using the frame allocator has to be cleared before its frame arena is
+reset, the arena reclaims the memory without calling any destructors.
+================================================================================
+*/
+template<typename T, typename Allocator = HeapAllocator>
 class List {
 public:
     typedef int		cmp_t(const T *, const T * );
@@ -91,9 +115,11 @@ public:
 
     explicit        List(int newGranularity = 16);
                     List(const List &other);
+                    List(List &&other) noexcept;
                     ~List();
 
-    List<T> &       operator=(const List<T> &other);
+    List &          operator=(const List &other);
+    List &          operator=(List &&other) noexcept;
     const T  &      operator[](int index) const;
     T &             operator[](int index);
 
@@ -102,14 +128,18 @@ public:
 
     T &             Alloc();                                                    // Allocates new element at the end. Returns reference to the element.
     int             Add(T const & obj);                                         // Adds element to the end. Returns the index of the element.
+    int             Add(T && obj);                                              // Moves element to the end. Returns the index of the element.
     int             AddUnique(T const & obj);                                   // Adds unique element to the end. Returns the index of the element.
     int             AddRange(const List & other);                               // Appends another list to the end. Returns the appended list's first element index.
     int             Insert(T const & obj, int index = 0);                       // Inserts element at the given index.
     bool			RemoveIndex(int index);				    			        // Removes the element at the given index.
     bool			RemoveIndexFast(int index);                                 // Removes the element at the given index and places the last element into its spot - DOES NOT PRESERVE LIST ORDER.
     bool			Remove(T const & obj);              						// Removes the given element.
-//    void            Sort();                                                   // Sorts the list.
-//    void            Swap(List & other);                                       // Swaps the contents of the list.
+    void            Sort();                                                     // Sorts the list using the < operator of the elements.
+    void            Sort(cmp_t * compare);                                      // Sorts the list using the comparison function.
+    template<typename KeyFunc>
+    void            SortByKey(KeyFunc getKey);                                  // Stable radix sort by an unsigned 32 or 64-bit key.
+    void            Swap(List & other);                                         // Swaps the contents of the list.
     void            Clear();                                                    // Clears the list.
     void            DeleteContents(bool clear = true);                          // Deletes the contents of the list.
 
@@ -138,6 +168,10 @@ private:
     int 			m_capacity;
     int 			m_granularity;
     T * 		    m_list;
+
+    void            Grow();                                                     // Grows the storage by the granularity.
+    void            ConstructRange(int from, int to);                           // Default constructs the elements in the range.
+    void            DestroyRange(int from, int to);                             // Destroys the elements in the range.
 };
 
 
@@ -150,8 +184,8 @@ List's constructor with m_granularity as parameter. Default m_granularity is set
 16.
 ================================================================================
 */
-template<typename T>
-inline List<T>::List(int newGranularity) {
+template<typename T, typename Allocator>
+inline List<T, Allocator>::List(int newGranularity) {
     assert(newGranularity > 0);
 
     m_size = 0;
@@ -169,12 +203,35 @@ DESCRIPTION:
 The list's copy constructor.
 ================================================================================
 */
-template<typename T>
-inline List<T>::List(const List &other) {
+template<typename T, typename Allocator>
+inline List<T, Allocator>::List(const List &other) {
+    m_size = 0;
+    m_capacity = 0;
+    m_granularity = other.m_granularity;
     m_list = nullptr;
     *this = other;
 }
 
+/*
+================================================================================
+List<T>::List
+
+DESCRIPTION:
+The list's move constructor. Takes over the storage of the other list.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline List<T, Allocator>::List(List &&other) noexcept {
+    m_size = other.m_size;
+    m_capacity = other.m_capacity;
+    m_granularity = other.m_granularity;
+    m_list = other.m_list;
+
+    other.m_size = 0;
+    other.m_capacity = 0;
+    other.m_list = nullptr;
+}
+
 /*
 ================================================================================
 List<T>::~List
@@ -183,8 +240,8 @@ DESCRIPTION:
 The list's destructor.
 ================================================================================
 */
-template<typename T>
-inline List<T>::~List() {
+template<typename T, typename Allocator>
+inline List<T, Allocator>::~List() {
     Clear();
 }
 
@@ -196,8 +253,8 @@ DESCRIPTION:
 Gets the pointer to the underlying array.
 ================================================================================
 */
-template<typename T>
-const inline T * List<T>::Data() const {
+template<typename T, typename Allocator>
+const inline T * List<T, Allocator>::Data() const {
     return m_list;
 }
 
@@ -209,8 +266,8 @@ DESCRIPTION:
 Gets the pointer to the underlying array.
 ================================================================================
 */
-template<typename T>
-inline T * List<T>::Data() {
+template<typename T, typename Allocator>
+inline T * List<T, Allocator>::Data() {
     return m_list;
 }
 
@@ -222,10 +279,10 @@ DESCRIPTION:
 Frees up the memory allocated by the list.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::Clear() {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Clear() {
     if(m_list) {
-        DeleteArray<T>(m_list, m_capacity);
+        DeleteArray<T, Allocator>(m_list, m_size);
     }
 
     m_list = nullptr;
@@ -250,8 +307,8 @@ when this function is called.  Function will set all pointers in the list to
 `nullptr`.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::DeleteContents(bool clear) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::DeleteContents(bool clear) {
     for(int i = 0; i < m_size; i++) {
         delete m_list[i];
         m_list[i] = nullptr;
@@ -260,7 +317,7 @@ inline void List<T>::DeleteContents(bool clear) {
     if (clear) {
         Clear();
     } else {
-        memset(m_list, 0, m_capacity * sizeof(T));
+        memset(static_cast<void *>(m_list), 0, m_capacity * sizeof(T));
     }
 }
 
@@ -275,8 +332,8 @@ NOTES:
 Doesn't take into account additional memory allocated by T
 ================================================================================
 */
-template<typename T>
-inline size_t List<T>::Allocated() const {
+template<typename T, typename Allocator>
+inline size_t List<T, Allocator>::Allocated() const {
     return m_capacity * sizeof(T);
 }
 
@@ -291,9 +348,9 @@ NOTES:
 Doesn't take into account additional memory allocated by T
 ================================================================================
 */
-template<typename T>
-inline size_t List<T>::SizeInBytes() const {
-    return sizeof(List<T>) + Allocated();
+template<typename T, typename Allocator>
+inline size_t List<T, Allocator>::SizeInBytes() const {
+    return sizeof(List<T, Allocator>) + Allocated();
 }
 
 /*
@@ -304,8 +361,8 @@ RETURNS:
 The total memory used by the list.
 ================================================================================
 */
-template<typename T>
-inline size_t List<T>::MemoryUsed() const {
+template<typename T, typename Allocator>
+inline size_t List<T, Allocator>::MemoryUsed() const {
     return m_size * sizeof(*m_list);
 }
 
@@ -320,8 +377,8 @@ NOTE:
 This is NOT an indication of the memory allocated.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::Size() const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::Size() const {
     return m_size;
 }
 
@@ -333,8 +390,8 @@ RETURNS:
 The number of elements currently allocated for.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::AllocatedCount() const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::AllocatedCount() const {
     return m_capacity;
 }
 
@@ -343,17 +400,24 @@ inline int List<T>::AllocatedCount() const {
 List<T>::SetSize
 
 DESCRIPTION:
-Sets the number of elements and resizes the list to match.
+Sets the number of elements and resizes the list to match. New elements are
+default constructed.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::SetSize(int newSize) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::SetSize(int newSize) {
     assert(newSize >= 0);
 
     if (newSize > m_capacity) {
         Resize(newSize);
     }
 
+    if (newSize > m_size) {
+        ConstructRange(m_size, newSize);
+    } else {
+        DestroyRange(newSize, m_size);
+    }
+
     m_size = newSize;
 }
 
@@ -365,8 +429,8 @@ DESCRIPTION:
 Sets the base size of the array and resizes the list to match.
 ================================================================================
 */
-template< typename T>
-inline void List<T>::SetGranularity( int newGranularity ) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::SetGranularity( int newGranularity ) {
     assert(newGranularity > 0);
 
     if (m_list) {
@@ -389,8 +453,8 @@ DESCRIPTION:
 Get the current m_granularity.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::Granularity() const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::Granularity() const {
     return m_granularity;
 }
 
@@ -403,8 +467,8 @@ Resizes the list to exactly the number of elements it contains or frees up
 memory if empty.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::Condense() {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Condense() {
     if (m_list) {
         if (m_size) {
             Resize(m_size);
@@ -420,12 +484,12 @@ List<T>::Resize
 
 DESCRIPTION:
 Allocates memory for the amount of elements requested while keeping the contents
-intact. Contents are copied using their = operator so that data is correctly
-instantiated.
+intact. Contents are relocated with their move constructor, or as raw memory for
+trivially copyable types. Elements that don't fit are destroyed.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::Resize(int newSize) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Resize(int newSize) {
     assert(newSize >= 0);
 
     if (newSize <= 0) {
@@ -437,12 +501,13 @@ inline void List<T>::Resize(int newSize) {
         return;
     }
 
-    m_list = ResizeArray<T>(m_list, m_capacity, newSize, false);
-    m_capacity = newSize;
-
-    if (m_capacity < m_size) {
-        m_size = m_capacity;
+    if (newSize < m_size) {
+        DestroyRange(newSize, m_size);
+        m_size = newSize;
     }
+
+    m_list = ResizeArray<T, Allocator>(m_list, m_size, m_capacity, newSize);
+    m_capacity = newSize;
 }
 
 /*
@@ -451,28 +516,16 @@ List<T>::Resize
 
 DESCRIPTION:
 Allocates memory for the amount of elements requested while keeping the contents
-intact. Contents are copied using their = operator so that data is correctly
-instantiated.
+intact and sets the new granularity.
 ================================================================================
 */
-template<typename T>
-inline void List<T>::Resize(int newSize, int newGranularity) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Resize(int newSize, int newGranularity) {
     assert(newSize >= 0);
     assert(newGranularity > 0);
 
     m_granularity = newGranularity;
-
-    if (newSize <= 0) {
-        Clear();
-        return;
-    }
-
-    m_list = ResizeArray<T>(m_list, m_capacity, newSize, false);
-    m_capacity = newSize;
-
-    if (m_capacity < m_size) {
-        m_size = m_capacity;
-    }
+    Resize(newSize);
 }
 
 /*
@@ -480,11 +533,12 @@ inline void List<T>::Resize(int newSize, int newGranularity) {
 List<T>::AssureSize
 
 DESCRIPTION:
-Makes sure the list has at least the given number of elements.
+Makes sure the list has at least the given number of elements. New elements are
+default constructed, which leaves trivial types uninitialized.
 ================================================================================
 */
-template< typename T>
-inline void List<T>::AssureSize(int newSize) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::AssureSize(int newSize) {
     int newCount = newSize;
 
     if (newSize > m_capacity) {
@@ -493,6 +547,12 @@ inline void List<T>::AssureSize(int newSize) {
         Resize(newSize);
     }
 
+    if (newCount > m_size) {
+        ConstructRange(m_size, newCount);
+    } else {
+        DestroyRange(newCount, m_size);
+    }
+
     m_size = newCount;
 }
 
@@ -505,8 +565,8 @@ Makes sure the list has at least the given number of elements and initialize
 any elements not yet initialized.
 ================================================================================
 */
-template< typename T>
-inline void List<T>::AssureSize(int newSize, const T &initValue) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::AssureSize(int newSize, const T &initValue) {
     int newCount = newSize;
 
     if (newSize > m_capacity) {
@@ -517,13 +577,13 @@ inline void List<T>::AssureSize(int newSize, const T &initValue) {
 
         newSize += m_granularity - 1;
         newSize -= newSize % m_granularity;
-        m_size = m_capacity;
         Resize(newSize);
+    }
 
-        for (int i = m_size; i < newSize; i++) {
-            m_list[i] = initValue;
-        }
+    for (int i = m_size; i < newCount; i++) {
+        new (&m_list[i]) T(initValue);
     }
+    DestroyRange(newCount, m_size);
 
     m_size = newCount;
 }
@@ -541,8 +601,8 @@ This function can only be called on lists containing pointers. Calling it
 on non-pointer lists will cause a compiler error.
 ================================================================================
 */
-template< typename T>
-inline void List<T>::AssureSizeAlloc(int newSize, new_t *allocator) {
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::AssureSizeAlloc(int newSize, new_t *allocator) {
     int newCount = newSize;
 
     if (newSize > m_capacity) {
@@ -553,13 +613,13 @@ inline void List<T>::AssureSizeAlloc(int newSize, new_t *allocator) {
 
         newSize += m_granularity - 1;
         newSize -= newSize % m_granularity;
-        m_size = m_capacity;
         Resize(newSize);
+    }
 
-        for (int i = m_size; i < newSize; i++) {
-            m_list[i] = (*allocator)();
-        }
+    for (int i = m_size; i < newCount; i++) {
+        new (&m_list[i]) T((*allocator)());
     }
+    DestroyRange(newCount, m_size);
 
     m_size = newCount;
 }
@@ -572,8 +632,12 @@ DESCRIPTION:
 Copies the contents and size attributes of another list.
 ================================================================================
 */
-template<typename T>
-inline List<T> & List<T>::operator=(const List<T> &other) {
+template<typename T, typename Allocator>
+inline List<T, Allocator> & List<T, Allocator>::operator=(const List<T, Allocator> &other) {
+    if (this == &other) {
+        return *this;
+    }
+
     Clear();
 
     m_size		= other.m_size;
@@ -581,15 +645,48 @@ inline List<T> & List<T>::operator=(const List<T> &other) {
     m_granularity	= other.m_granularity;
 
     if (m_capacity) {
-        m_list = NewArray<T>(m_capacity, false);
-        for(int i = 0; i < m_size; i++ ) {
-            m_list[i] = other.m_list[i];
+        m_list = AllocArray<T, Allocator>(m_capacity);
+
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            memcpy(static_cast<void *>(m_list), other.m_list, m_size * sizeof(T));
+        } else {
+            for(int i = 0; i < m_size; i++ ) {
+                new (&m_list[i]) T(other.m_list[i]);
+            }
         }
     }
 
     return *this;
 }
 
+/*
+================================================================================
+List<T>::operator=
+
+DESCRIPTION:
+Takes over the contents and size attributes of another list.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline List<T, Allocator> & List<T, Allocator>::operator=(List<T, Allocator> &&other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    Clear();
+
+    m_size		= other.m_size;
+    m_capacity		= other.m_capacity;
+    m_granularity	= other.m_granularity;
+    m_list          = other.m_list;
+
+    other.m_size = 0;
+    other.m_capacity = 0;
+    other.m_list = nullptr;
+
+    return *this;
+}
+
 /*
 ================================================================================
 List<T>::operator[] const
@@ -599,8 +696,8 @@ Access operator.  Index must be within range or an assert will be issued in
 debug builds. Release builds do no range checking.
 ================================================================================
 */
-template<typename T>
-inline const T & List<T>::operator[](int index) const {
+template<typename T, typename Allocator>
+inline const T & List<T, Allocator>::operator[](int index) const {
     assert(index >= 0);
     assert(index < m_size);
 
@@ -616,8 +713,8 @@ Access operator.  Index must be within range or an assert will be issued in
 debug builds. Release builds do no range checking.
 ================================================================================
 */
-template<typename T>
-inline T & List<T>::operator[](int index) {
+template<typename T, typename Allocator>
+inline T & List<T, Allocator>::operator[](int index) {
     assert( index >= 0 );
     assert(index < m_size);
 
@@ -636,16 +733,13 @@ Reference to the new data element.
 ================================================================================
 
 */
-template<typename T>
-inline T & List<T>::Alloc() {
-    if (!m_list) {
-        Resize(m_granularity);
-    }
-
+template<typename T, typename Allocator>
+inline T & List<T, Allocator>::Alloc() {
     if (m_size == m_capacity) {
-        Resize(m_capacity + m_granularity);
+        Grow();
     }
 
+    new (&m_list[m_size]) T;
     return m_list[m_size++];
 }
 
@@ -660,18 +754,43 @@ RETURNS:
 The index of the new element.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::Add(T const & obj) {
-    if (!m_list) {
-        Resize(m_granularity);
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::Add(T const & obj) {
+    if (m_size == m_capacity) {
+        // The element may live in this list, copy it before the storage moves.
+        T copy(obj);
+        Grow();
+        new (&m_list[m_size]) T(std::move(copy));
+    } else {
+        new (&m_list[m_size]) T(obj);
     }
 
+    m_size++;
+
+    return m_size - 1;
+}
+
+/*
+================================================================================
+List<T>::Add
+
+DESCRIPTION:
+Increases the size of the list by one element and moves the given data into it.
+
+RETURNS:
+The index of the new element.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::Add(T && obj) {
     if (m_size == m_capacity) {
-        int newSize = m_capacity + m_granularity;
-        Resize(newSize - newSize % m_granularity);
+        T moved(std::move(obj));
+        Grow();
+        new (&m_list[m_size]) T(std::move(moved));
+    } else {
+        new (&m_list[m_size]) T(std::move(obj));
     }
 
-    m_list[m_size] = obj;
     m_size++;
 
     return m_size - 1;
@@ -690,33 +809,38 @@ RETURNS:
 The index of the new element.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::Insert(T const & obj, int index) {
-    if (!m_list) {
-        Resize(m_granularity);
-    }
-
-    if (m_size == m_capacity) {
-        int newSize;
-
-        if (m_granularity == 0) {	// this is a hack to fix our memset classes
-            m_granularity = 16;
-        }
-        newSize = m_capacity + m_granularity;
-        Resize(newSize - newSize % m_granularity);
-    }
-
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::Insert(T const & obj, int index) {
     if (index < 0) {
         index = 0;
     }
     else if (index > m_size) {
         index = m_size;
     }
-    for (int i = m_size; i > index; --i) {
-        m_list[i] = m_list[i - 1];
+
+    if (index == m_size) {
+        return Add(obj);
+    }
+
+    // The element may live in this list, copy it before anything moves.
+    T copy(obj);
+
+    if (m_size == m_capacity) {
+        Grow();
+    }
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memmove(static_cast<void *>(&m_list[index + 1]), &m_list[index], (m_size - index) * sizeof(T));
+        m_list[index] = copy;
+    } else {
+        new (&m_list[m_size]) T(std::move(m_list[m_size - 1]));
+        for (int i = m_size - 1; i > index; --i) {
+            m_list[i] = std::move(m_list[i - 1]);
+        }
+        m_list[index] = std::move(copy);
     }
+
     m_size++;
-    m_list[index] = obj;
     return index;
 }
 
@@ -731,8 +855,8 @@ RETURNS:
 The size of the new combined list
 ================================================================================
 */
-template<typename T>
-inline int List<T>::AddRange(const List<T> &other) {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::AddRange(const List<T, Allocator> &other) {
     if (!m_list) {
         if (m_granularity == 0) {	// this is a hack to fix our memset classes
             m_granularity = 16;
@@ -740,7 +864,7 @@ inline int List<T>::AddRange(const List<T> &other) {
         Resize(m_granularity);
     }
 
-    int n = other.Count();
+    int n = other.Size();
     for (int i = 0; i < n; i++) {
         Add(other[i]);
     }
@@ -759,8 +883,8 @@ RETURNS:
 The index of the data in the list.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::AddUnique(T const & obj) {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::AddUnique(T const & obj) {
     int index;
 
     index = IndexOf(obj);
@@ -782,8 +906,8 @@ RETURNS:
 -1 if the data is not found.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::IndexOf(T const & obj) const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::IndexOf(T const & obj) const {
     for(int i = 0; i < m_size; i++) {
         if (m_list[i] == obj) {
             return i;
@@ -809,8 +933,8 @@ Function will assert in debug builds if pointer is outside the bounds of the lis
 but remains silent in release builds.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::IndexOf(T const *objPtr) const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::IndexOf(T const *objPtr) const {
     int index = objPtr - m_list;
 
     assert(index >= 0);
@@ -830,8 +954,8 @@ RETURNS:
 `nullptr` if the data is not found.
 ================================================================================
 */
-template<typename T>
-inline T *List<T>::Find(T const & obj) const {
+template<typename T, typename Allocator>
+inline T *List<T, Allocator>::Find(T const & obj) const {
     int i = IndexOf(obj);
     if (i >= 0) {
         return &m_list[i];
@@ -855,8 +979,8 @@ This function can only be called on lists containing pointers. Calling it
 on non-pointer lists will cause a compiler error.
 ================================================================================
 */
-template<typename T>
-inline int List<T>::FindNull() const {
+template<typename T, typename Allocator>
+inline int List<T, Allocator>::FindNull() const {
     for(int i = 0; i < m_size; i++ ) {
         if (m_list[i] == nullptr) {
             return i;
@@ -878,12 +1002,13 @@ by one.
 RETURNS:
 False if the index is outside the bounds of the list.
 
-NOTE: that the element is not destroyed, so any memory used by it may not be
-freed until the destruction of the list.
+NOTE:
+The vacated last slot is destroyed, the storage itself is kept until the list
+is resized or destroyed.
 ================================================================================
 */
-template<typename T>
-inline bool List<T>::RemoveIndex(int index) {
+template<typename T, typename Allocator>
+inline bool List<T, Allocator>::RemoveIndex(int index) {
     assert(m_list != nullptr);
     assert(index >= 0);
     assert(index < m_size);
@@ -893,8 +1018,14 @@ inline bool List<T>::RemoveIndex(int index) {
     }
 
     m_size--;
-    for(int i = index; i < m_size; i++) {
-        m_list[i] = m_list[i + 1];
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memmove(static_cast<void *>(&m_list[index]), &m_list[index + 1], (m_size - index) * sizeof(T));
+    } else {
+        for(int i = index; i < m_size; i++) {
+            m_list[i] = std::move(m_list[i + 1]);
+        }
+        m_list[m_size].~T();
     }
 
     return true;
@@ -914,12 +1045,12 @@ RETURNS:
 False if the data is not found in the list.
 
 NOTE:
-The element is not destroyed, so any memory used by it may not be freed
-until the destruction of the list.
+The vacated last slot is destroyed, the storage itself is kept until the list
+is resized or destroyed.
 ================================================================================
 */
-template<typename T>
-inline bool List<T>::RemoveIndexFast(int index)
+template<typename T, typename Allocator>
+inline bool List<T, Allocator>::RemoveIndexFast(int index)
 {
     if (index < 0 || index >= m_size)
     {
@@ -929,7 +1060,12 @@ inline bool List<T>::RemoveIndexFast(int index)
     m_size--;
     if (index != m_size)
     {
-        m_list[index] = m_list[m_size];
+        m_list[index] = std::move(m_list[m_size]);
+    }
+
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        m_list[m_size].~T();
     }
 
     return true;
@@ -952,10 +1088,10 @@ The element is not destroyed, so any memory used by it may not be freed until
 the destruction of the list.
 ================================================================================
 */
-template<typename T>
-inline bool List<T>::Remove(T const & obj)
+template<typename T, typename Allocator>
+inline bool List<T, Allocator>::Remove(T const & obj)
 {
-    int index = FindIndex(obj);
+    int index = IndexOf(obj);
     if (index >= 0)
     {
         return RemoveIndex(index);
@@ -964,4 +1100,121 @@ inline bool List<T>::Remove(T const & obj)
     return false;
 }
 
+/*
+================================================================================
+List<T>::Sort
+
+DESCRIPTION:
+Sorts the list using the < operator of the elements. The sort is not stable.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Sort() {
+    if (m_size > 1) {
+        std::sort(m_list, m_list + m_size);
+    }
+}
+
+/*
+================================================================================
+List<T>::Sort
+
+DESCRIPTION:
+Sorts the list using the comparison function, which returns a negative value
+when the first element goes before the second. The sort is not stable.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Sort(cmp_t * compare) {
+    if (m_size > 1) {
+        std::sort(m_list, m_list + m_size, [compare](const T & a, const T & b) {
+            return compare(&a, &b) < 0;
+        });
+    }
+}
+
+/*
+================================================================================
+List<T>::SortByKey
+
+DESCRIPTION:
+Stable sort of the list by the unsigned 32 or 64-bit key returned by `getKey`
+for every element. Uses a radix sort with scratch memory from the current frame
+arena, see `RadixSort`.
+================================================================================
+*/
+template<typename T, typename Allocator>
+template<typename KeyFunc>
+inline void List<T, Allocator>::SortByKey(KeyFunc getKey) {
+    RadixSort(m_list, m_size, getKey);
+}
+
+/*
+================================================================================
+List<T>::Swap
+
+DESCRIPTION:
+Swaps the contents of the two lists without copying any elements.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Swap(List<T, Allocator> &other) {
+    std::swap(m_size, other.m_size);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_granularity, other.m_granularity);
+    std::swap(m_list, other.m_list);
+}
+
+/*
+================================================================================
+List<T>::Grow
+
+DESCRIPTION:
+Grows the storage by the granularity, rounded down to a multiple of it.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::Grow() {
+    if (m_granularity == 0) {	// this is a hack to fix our memset classes
+        m_granularity = 16;
+    }
+
+    int newSize = m_capacity + m_granularity;
+    Resize(newSize - newSize % m_granularity);
+}
+
+/*
+================================================================================
+List<T>::ConstructRange
+
+DESCRIPTION:
+Default constructs the elements in the [from, to) range of the storage.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::ConstructRange(int from, int to) {
+    if constexpr (!std::is_trivially_default_constructible<T>::value) {
+        for (int i = from; i < to; i++) {
+            new (&m_list[i]) T;
+        }
+    }
+}
+
+/*
+================================================================================
+List<T>::DestroyRange
+
+DESCRIPTION:
+Destroys the elements in the [from, to) range of the storage.
+================================================================================
+*/
+template<typename T, typename Allocator>
+inline void List<T, Allocator>::DestroyRange(int from, int to) {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (int i = from; i < to; i++) {
+            m_list[i].~T();
+        }
+    }
+}
+
 #endif //RELOAD_LIST_H
@@ -0,0 +1,100 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_SORT_H
+#define RELOAD_SORT_H
+
+#include <cassert>
+#include <type_traits>
+#include "Common.h"
+#include "ReloadLib/sys/Heap.h"
+
+/*
+================================================================================
+RadixSort
+
+DESCRIPTION:
+Stable LSD radix sort of the items by an unsigned 32 or 64-bit key, 8 bits per
+pass. The keys are extracted once up front and moved along with the items, so
+the key function is called exactly once per item. The histograms for all digits
+are built in a single pass over the keys, and any digit that is the same for
+every item is skipped, which makes sorting by sparse keys considerably cheaper.
+
+The scratch buffers for the keys and the items come from the current frame
+arena.
+
+NOTE:
+The items are moved around as raw memory, so they have to be trivially
+copyable. Sorting pointers or small handles keeps the passes cheap.
+================================================================================
+*/
+template<typename T, typename KeyFunc>
+inline void RadixSort(T * items, int count, KeyFunc getKey) {
+    using Key = std::decay_t<decltype(getKey(*items))>;
+
+    static_assert(std::is_same<Key, uint32_t>::value || std::is_same<Key, uint64_t>::value,
+                  "RadixSort keys have to be uint32_t or uint64_t.");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "RadixSort items have to be trivially copyable.");
+
+    constexpr int NUM_PASSES = static_cast<int>(sizeof(Key));
+    constexpr int RADIX = 256;
+
+    if (count < 2) {
+        return;
+    }
+
+    const auto n = static_cast<size_t>(count);
+    auto * keys = static_cast<Key *>(Mem::FrameAlloc(sizeof(Key) * n * 2));
+    auto * keysTmp = keys + n;
+    auto * itemsTmp = static_cast<T *>(Mem::FrameAlloc(sizeof(T) * n, alignof(T) > 16 ? alignof(T) : 16));
+
+    uint32_t histograms[NUM_PASSES][RADIX] = {};
+
+    for (size_t i = 0; i < n; i++) {
+        const Key key = getKey(items[i]);
+        keys[i] = key;
+
+        for (int pass = 0; pass < NUM_PASSES; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    Key * srcKeys = keys;
+    Key * dstKeys = keysTmp;
+    T * srcItems = items;
+    T * dstItems = itemsTmp;
+
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        uint32_t * histogram = histograms[pass];
+        const int shift = pass * 8;
+
+        // Every key has the same digit, the pass wouldn't change the order.
+        if (histogram[(srcKeys[0] >> shift) & 0xFF] == static_cast<uint32_t>(count)) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int digit = 0; digit < RADIX; digit++) {
+            const uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t dst = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[dst] = srcKeys[i];
+            dstItems[dst] = srcItems[i];
+        }
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcItems, dstItems);
+    }
+
+    if (srcItems != items) {
+        memcpy(static_cast<void *>(items), srcItems, sizeof(T) * n);
+    }
+}
+
+#endif //RELOAD_SORT_H
@@ -0,0 +1,46 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_SPAN_H
+#define RELOAD_SPAN_H
+
+#include <cassert>
+#include <cstddef>
+
+/*
+================================================================================
+Span<T>
+
+DESCRIPTION:
+Non-owning view of a contiguous range of elements, the engine's stand-in for
+std::span until the project moves past C++17.
+================================================================================
+*/
+template<typename T>
+class Span {
+public:
+    constexpr           Span() : m_data(nullptr), m_size(0) {}
+    constexpr           Span(T * data, size_t size) : m_data(data), m_size(size) {}
+
+    constexpr T &       operator[](size_t index) const { assert(index < m_size); return m_data[index]; }
+
+    constexpr T *       Data() const { return m_data; }                         // Gets the pointer to the first element.
+    constexpr size_t    Size() const { return m_size; }                         // Gets the number of elements.
+    constexpr size_t    SizeInBytes() const { return m_size * sizeof(T); }      // Gets the size of the range in bytes.
+    constexpr bool      Empty() const { return m_size == 0; }                   // Checks whether the range is empty.
+
+    constexpr Span      Subspan(size_t offset, size_t count) const {            // Gets a view of part of the range.
+        assert(offset <= m_size && count <= m_size - offset);
+        return Span(m_data + offset, count);
+    }
+
+    constexpr T *       begin() const { return m_data; }
+    constexpr T *       end() const { return m_data + m_size; }
+
+private:
+    T *                 m_data;
+    size_t              m_size;
+};
+
+#endif //RELOAD_SPAN_H
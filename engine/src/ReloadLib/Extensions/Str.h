@@ -5,15 +5,25 @@
 #ifndef RELOAD_STR_H
 #define RELOAD_STR_H
 
+#include <string_view>
 #include "Common.h"
+#include "ReloadLib/Hash.h"
 
 class Str {
 public:
 
-    static inline bool CompareI(std::string s1, std::string s2) {
-        transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
-        transform(s2.begin(), s2.end(), s2.begin(), ::tolower);
-        return s1 == s2;
+    static inline bool CompareI(std::string_view s1, std::string_view s2) {
+        if (s1.length() != s2.length()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < s1.length(); i++) {
+            if (Hash::ToLower(s1[i]) != Hash::ToLower(s2[i])) {
+                return false;
+            }
+        }
+
+        return true;
     }
 
     static inline void Replace(std::string & str, const std::string & from, const std::string & to) {
@@ -26,5 +36,9 @@ public:
     static inline void TrimExtension(std::string &str) {
         str = str.substr(0, str.find_last_of('.'));
     }
+
+    static inline std::string_view StripExtension(std::string_view str) {
+        return str.substr(0, str.find_last_of('.'));
+    }
 };
 #endif //RELOAD_STR_H
@@ -1,61 +1,290 @@
 #include "File.h"
 
-#include <stdio.h>
+#include <cstdio>
+#include <filesystem>
+#include "../Common.h"
 
-#ifdef __linux__
-#include <linux/limits.h>
-const auto RLD_PATH_MAX = PATH_MAX;
+#ifdef WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
 #else
-#include <stdlib.h>
-const auto RLD_PATH_MAX = _MAX_PATH;
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
 #endif
 
-#include "../Common.h"
+/*
+================================================================================
+MappedFile::MappedFile
+
+DESCRIPTION:
+The mapped file's move constructor. Takes over the mapping of the other file.
+================================================================================
+*/
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+/*
+================================================================================
+MappedFile::~MappedFile
+
+DESCRIPTION:
+Unmaps the file.
+================================================================================
+*/
+MappedFile::~MappedFile() {
+    Close();
+}
+
+/*
+================================================================================
+MappedFile::operator=
+
+DESCRIPTION:
+Closes the current mapping and takes over the mapping of the other file.
+================================================================================
+*/
+MappedFile & MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    Close();
+
+    m_data = other.m_data;
+    m_size = other.m_size;
+    m_isOpen = other.m_isOpen;
+#ifdef WIN32
+    m_fileHandle = other.m_fileHandle;
+    m_mappingHandle = other.m_mappingHandle;
+    other.m_fileHandle = nullptr;
+    other.m_mappingHandle = nullptr;
+#endif
+
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_isOpen = false;
+
+    return *this;
+}
+
+/*
+================================================================================
+MappedFile::Open
 
-char * File::ReadAsString(const char *filepath){
-    char cwd[MAX_PATH];
+DESCRIPTION:
+Maps the whole file read-only. Relative paths are resolved against the working
+directory. An empty file opens successfully with an empty span.
 
-    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
-        SDL_LogError(LOG_FILE, "Error getting working directory.");
-        exit(1);
+RETURNS:
+`true` if the file was mapped.
+================================================================================
+*/
+bool MappedFile::Open(const char *path) {
+    Close();
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        SDL_LogError(LOG_FILE, "Error opening %s.", path);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        SDL_LogError(LOG_FILE, "Error getting the size of %s.", path);
+        CloseHandle(file);
+        return false;
     }
 
-    size_t pathLen = strlen(cwd) + strlen(SEPARATOR) + strlen(filepath);
+    m_fileHandle = file;
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_isOpen = true;
 
-    if (pathLen > MAX_PATH) {
-        SDL_LogError(LOG_FILE, "Path length is longer then what the OS supports.");
-        exit(1);
+    if (m_size == 0) {
+        return true;
     }
 
-    char *fullFilePath = new char[pathLen];
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        SDL_LogError(LOG_FILE, "Error mapping %s.", path);
+        Close();
+        return false;
+    }
 
-    sprintf(fullFilePath, "%s%s%s", cwd, SEPARATOR, filepath);
+    m_mappingHandle = mapping;
+    m_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
 
-    FILE *file;
-    char *buffer;
-    long  numbytes;
+    if (m_data == nullptr) {
+        SDL_LogError(LOG_FILE, "Error mapping %s.", path);
+        Close();
+        return false;
+    }
+#else
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        SDL_LogError(LOG_FILE, "Error opening %s.", path);
+        return false;
+    }
 
-    file = fopen(fullFilePath, "rb");
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        SDL_LogError(LOG_FILE, "Error getting the size of %s.", path);
+        close(fd);
+        return false;
+    }
 
-    if (file == nullptr) {
-        SDL_LogError(LOG_FILE, "Error opening %s.", fullFilePath);
-        exit(1);
+    m_size = static_cast<size_t>(fileStat.st_size);
+    m_isOpen = true;
+
+    if (m_size > 0) {
+        void * data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            SDL_LogError(LOG_FILE, "Error mapping %s.", path);
+            close(fd);
+            m_size = 0;
+            m_isOpen = false;
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t *>(data);
     }
 
-    fseek(file, 0L, SEEK_END);
-    numbytes = ftell(file);
-    fseek(file, 0L, SEEK_SET);
+    // The mapping keeps its own reference to the file.
+    close(fd);
+#endif
+
+    return true;
+}
 
-    buffer = (char *)calloc((size_t)numbytes, sizeof(char));
+/*
+================================================================================
+MappedFile::Close
 
-    if (buffer == nullptr) {
-        SDL_LogError(LOG_FILE, "Error creating buffer for %s.", fullFilePath);
-        exit(1);
+DESCRIPTION:
+Unmaps the file. Any span taken from it becomes invalid.
+================================================================================
+*/
+void MappedFile::Close() {
+#ifdef WIN32
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr) {
+        CloseHandle(m_fileHandle);
     }
 
-    fread(buffer, sizeof(char), (size_t)numbytes, file);
-    fclose(file);
-    delete[] fullFilePath;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isOpen = false;
+}
+
+/*
+================================================================================
+MappedFile::Advise
+
+DESCRIPTION:
+Hints the access pattern of the whole file to the OS.
+================================================================================
+*/
+void MappedFile::Advise(MapAdvice advice) const {
+    Advise(advice, 0, m_size);
+}
+
+/*
+================================================================================
+MappedFile::Advise
+
+DESCRIPTION:
+Hints the access pattern of a range of the file to the OS. The range is widened
+to whole pages. Only `MAP_ADVICE_WILLNEED` has an effect on Windows, where it
+prefetches the range.
+================================================================================
+*/
+void MappedFile::Advise(MapAdvice advice, size_t offset, size_t size) const {
+    if (m_data == nullptr || offset >= m_size) {
+        return;
+    }
+
+    if (size > m_size - offset) {
+        size = m_size - offset;
+    }
+
+#ifdef WIN32
+    if (advice == MAP_ADVICE_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<uint8_t *>(m_data + offset);
+        range.NumberOfBytes = size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    int flag = MADV_NORMAL;
+    switch (advice) {
+        case MAP_ADVICE_NORMAL:     flag = MADV_NORMAL; break;
+        case MAP_ADVICE_SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+        case MAP_ADVICE_RANDOM:     flag = MADV_RANDOM; break;
+        case MAP_ADVICE_WILLNEED:   flag = MADV_WILLNEED; break;
+    }
+
+    // The mapping starts on a page boundary, so only the offset needs aligning.
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t alignedOffset = offset & ~(pageSize - 1);
+
+    madvise(const_cast<uint8_t *>(m_data + alignedOffset), size + (offset - alignedOffset), flag);
+#endif
+}
+
+/*
+================================================================================
+WriteFileAtomically
+
+DESCRIPTION:
+Writes the data to `path.tmp` and renames it over `path`, so readers either see
+the old file or the complete new one.
+
+RETURNS:
+`false` on any IO error, the old file is left untouched then.
+================================================================================
+*/
+bool WriteFileAtomically(const char *path, const void *data, size_t size) {
+    namespace fs = std::filesystem;
+
+    const std::string tempPath = std::string(path) + ".tmp";
+
+    FILE * file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool failed = fwrite(data, 1, size, file) != size;
+    failed |= fflush(file) != 0;
+    failed |= fclose(file) != 0;
+
+    std::error_code error;
+    if (!failed) {
+        // Replaces the existing file on all platforms.
+        fs::rename(tempPath, path, error);
+    }
+
+    if (failed || error) {
+        fs::remove(tempPath, error);
+        return false;
+    }
 
-    return buffer;
+    return true;
 }
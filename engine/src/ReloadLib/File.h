@@ -1,8 +1,60 @@
 #ifndef __SYS_FILE_H
 #define __SYS_FILE_H
 
-class File {
+#include <cstddef>
+#include <cstdint>
+#include "ReloadLib/Containers/Span.h"
+
+// Access pattern hints for the pages of a mapped file.
+enum MapAdvice {
+    MAP_ADVICE_NORMAL,
+    MAP_ADVICE_SEQUENTIAL,                                                      // Read front to back once, read ahead aggressively.
+    MAP_ADVICE_RANDOM,                                                          // Scattered reads, don't read ahead.
+    MAP_ADVICE_WILLNEED                                                         // Start paging the range in now.
+};
+
+/*
+================================================================================
+MappedFile
+
+DESCRIPTION:
+Read-only memory mapping of a whole file. The contents are exposed directly as
+a span of bytes, so parsers and decoders read from the page cache without any
+copy into the heap. The mapping lives until the file is closed or destroyed.
+
+NOTE:
+The mapped data is not NUL terminated, text parsers have to use the size.
+================================================================================
+*/
+class MappedFile {
 public:
-    static char * ReadAsString(const char *path);
+                    MappedFile() = default;
+                    MappedFile(const MappedFile &other) = delete;
+                    MappedFile(MappedFile &&other) noexcept;
+                    ~MappedFile();
+
+    MappedFile &    operator=(const MappedFile &other) = delete;
+    MappedFile &    operator=(MappedFile &&other) noexcept;
+
+    bool            Open(const char *path);                                     // Maps the file relative to the working directory. Returns `false` on failure.
+    void            Close();                                                    // Unmaps the file.
+    void            Advise(MapAdvice advice) const;                             // Hints the access pattern of the whole file.
+    void            Advise(MapAdvice advice, size_t offset, size_t size) const; // Hints the access pattern of a range of the file.
+
+    [[nodiscard]] Span<const uint8_t>   Data() const { return Span<const uint8_t>(m_data, m_size); }
+    [[nodiscard]] size_t                Size() const { return m_size; }
+    [[nodiscard]] bool                  IsOpen() const { return m_isOpen; }
+
+private:
+    const uint8_t * m_data = nullptr;
+    size_t          m_size = 0;
+    bool            m_isOpen = false;
+#ifdef WIN32
+    void *          m_fileHandle = nullptr;
+    void *          m_mappingHandle = nullptr;
+#endif
 };
-#endif // !__SYS_FILE_H
\ No newline at end of file
+
+bool                WriteFileAtomically(const char *path, const void *data, size_t size);    // Writes the whole file or leaves the old one. Returns `false` on failure.
+
+#endif // !__SYS_FILE_H
@@ -0,0 +1,156 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "FileSystem.h"
+
+#include <filesystem>
+#include "Common.h"
+
+FileSystem fileSystem;
+
+/*
+================================================================================
+FileSystem::Mount
+
+DESCRIPTION:
+Mounts the archive, from then on its assets shadow the loose files. A missing
+archive isn't an error, development builds run from the loose files.
+
+RETURNS:
+`true` if the archive was mounted.
+================================================================================
+*/
+bool FileSystem::Mount(const char *archivePath) {
+    Unmount();
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(archivePath, error)) {
+        SDL_LogInfo(LOG_FILE, "No archive at %s, reading the loose files.", archivePath);
+        return false;
+    }
+
+    if (!m_archive.Open(archivePath)) {
+        return false;
+    }
+
+    m_archivePath = archivePath;
+    SDL_LogInfo(LOG_FILE, "Mounted %s with %d assets.", archivePath, m_archive.NumEntries());
+
+    return true;
+}
+
+/*
+================================================================================
+FileSystem::Unmount
+
+DESCRIPTION:
+Unmounts the archive. Views of archived assets become invalid.
+================================================================================
+*/
+void FileSystem::Unmount() {
+    m_archive.Close();
+    m_archivePath.clear();
+}
+
+/*
+================================================================================
+FileSystem::Find
+
+DESCRIPTION:
+Gets a view of the asset in the archive mapping.
+
+RETURNS:
+`true` if the asset is in the mounted archive.
+================================================================================
+*/
+bool FileSystem::Find(const char *path, Span<const uint8_t> &data) const {
+    return m_archive.Find(path, data);
+}
+
+/*
+================================================================================
+FileSystem::Locate
+
+DESCRIPTION:
+Resolves where the asset has to be read from, for readers that load it with
+file reads instead of mapping it: the range of its blob in the archive, or the
+whole loose file.
+
+RETURNS:
+The location of the asset. Loose files aren't checked for existence, the read
+fails instead.
+================================================================================
+*/
+AssetLocation FileSystem::Locate(const char *path) const {
+    AssetLocation location;
+    uint64_t offset;
+    uint64_t size;
+
+    if (m_archive.Locate(path, offset, size)) {
+        location.path = m_archivePath.c_str();
+        location.offset = static_cast<size_t>(offset);
+        location.size = static_cast<size_t>(size);
+        location.archived = true;
+    } else {
+        location.path = path;
+    }
+
+    return location;
+}
+
+/*
+================================================================================
+AssetFile::Open
+
+DESCRIPTION:
+Opens the asset from the mounted archive, otherwise maps the loose file.
+
+RETURNS:
+`true` if the asset was found.
+================================================================================
+*/
+bool AssetFile::Open(const char *path) {
+    Close();
+
+    if (fileSystem.Find(path, m_data)) {
+        m_isOpen = true;
+        return true;
+    }
+
+    if (!m_file.Open(path)) {
+        return false;
+    }
+
+    m_data = m_file.Data();
+    m_isOpen = true;
+
+    return true;
+}
+
+/*
+================================================================================
+AssetFile::Close
+
+DESCRIPTION:
+Releases the view, unmapping the loose file.
+================================================================================
+*/
+void AssetFile::Close() {
+    m_file.Close();
+    m_data = Span<const uint8_t>();
+    m_isOpen = false;
+}
+
+/*
+================================================================================
+AssetFile::Advise
+
+DESCRIPTION:
+Hints the access pattern of a loose file. Archived assets share the mapping of
+the archive, which is advised as a whole when it's mounted.
+================================================================================
+*/
+void AssetFile::Advise(MapAdvice advice) const {
+    m_file.Advise(advice);
+}
@@ -0,0 +1,80 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_FILE_SYSTEM_H
+#define RELOAD_FILE_SYSTEM_H
+
+#include <string>
+#include "ReloadLib/Archive.h"
+#include "ReloadLib/File.h"
+
+// Where to read an asset from: a range of the mounted archive or a loose file.
+struct AssetLocation {
+    const char *        path = nullptr;                                         // The archive or the loose file, valid while the archive stays mounted.
+    size_t              offset = 0;
+    size_t              size = 0;                                               // 0 reads the whole loose file.
+    bool                archived = false;
+};
+
+/*
+================================================================================
+FileSystem
+
+DESCRIPTION:
+Resolves asset paths. Assets of the mounted archive shadow the loose files, so
+a shipped build reads everything from one mapping while a development build
+without an archive keeps reading the files next to the executable. The paths
+are relative to the working directory, the same names the packer stores.
+
+NOTE:
+The archive is mounted once at startup, before any system loads assets, and
+unmounted after they are all shut down. Lookups are read-only and can be done
+from any thread in between.
+================================================================================
+*/
+class FileSystem {
+public:
+    bool            Mount(const char *archivePath);                             // Mounts the archive. Returns `false` if it doesn't exist or is invalid.
+    void            Unmount();                                                  // Unmounts the archive, invalidating all the archived views.
+
+    bool            Find(const char *path, Span<const uint8_t> &data) const;    // Gets a view of an archived asset. Returns `false` if it's not archived.
+    AssetLocation   Locate(const char *path) const;                             // Gets where to read the asset from, for asynchronous reads.
+
+    [[nodiscard]] bool  IsMounted() const { return m_archive.IsOpen(); }
+
+private:
+    Archive         m_archive;
+    std::string     m_archivePath;
+};
+
+extern FileSystem fileSystem;
+
+/*
+================================================================================
+AssetFile
+
+DESCRIPTION:
+Read-only view of a whole asset. Opening looks the asset up in the mounted
+archive first and serves it as a view of the archive mapping, otherwise maps
+the loose file from disk.
+================================================================================
+*/
+class AssetFile {
+public:
+    bool            Open(const char *path);                                     // Opens the asset. Returns `false` if it's neither archived nor on disk.
+    void            Close();                                                    // Releases the view.
+    void            Advise(MapAdvice advice) const;                             // Hints the access pattern of a loose file.
+
+    [[nodiscard]] Span<const uint8_t>   Data() const { return m_data; }
+    [[nodiscard]] size_t                Size() const { return m_data.Size(); }
+    [[nodiscard]] bool                  IsOpen() const { return m_isOpen; }
+    [[nodiscard]] bool                  IsArchived() const { return m_isOpen && !m_file.IsOpen(); }
+
+private:
+    MappedFile          m_file;                                                 // Only open for loose files.
+    Span<const uint8_t> m_data;
+    bool                m_isOpen = false;
+};
+
+#endif //RELOAD_FILE_SYSTEM_H
@@ -0,0 +1,71 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_HASH_H
+#define RELOAD_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+/*
+================================================================================
+Hash
+
+DESCRIPTION:
+Dependency-free string hashing used by the containers and registries. The
+functions are 32-bit FNV-1a, the case-insensitive variant folds ASCII upper case
+letters before mixing them in so that "Textures/Foo" and "textures/foo" hash the
+same without building a lower case copy of the string.
+================================================================================
+*/
+class Hash {
+public:
+    static constexpr uint32_t   FNV_OFFSET_BASIS = 2166136261u;
+    static constexpr uint32_t   FNV_PRIME = 16777619u;
+    static constexpr uint64_t   FNV_OFFSET_BASIS_64 = 14695981039346656037ull;
+    static constexpr uint64_t   FNV_PRIME_64 = 1099511628211ull;
+
+    static constexpr char       ToLower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr uint32_t   Fnv1a(std::string_view str) {
+        uint32_t hash = FNV_OFFSET_BASIS;
+        for (char c : str) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static constexpr uint32_t   Fnv1aI(std::string_view str) {
+        uint32_t hash = FNV_OFFSET_BASIS;
+        for (char c : str) {
+            hash ^= static_cast<uint8_t>(ToLower(c));
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static constexpr uint64_t   Fnv1a64I(std::string_view str) {                // 64-bit variant for persisted ids, collisions are far less likely.
+        uint64_t hash = FNV_OFFSET_BASIS_64;
+        for (char c : str) {
+            hash ^= static_cast<uint8_t>(ToLower(c));
+            hash *= FNV_PRIME_64;
+        }
+        return hash;
+    }
+
+    static constexpr uint32_t   Int(uint64_t key) {                              // Mixes an integer key, 64-bit finalizer folded to 32 bits.
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return static_cast<uint32_t>(key);
+    }
+};
+
+#endif //RELOAD_HASH_H
@@ -0,0 +1,204 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "NameTable.h"
+
+#include <mutex>
+
+NameTable nameTable;
+
+/*
+================================================================================
+FoldName
+
+DESCRIPTION:
+Writes the folded form of the path into the buffer: lower case and forward
+slashes. The extension is kept, files that only differ in it are different
+assets.
+
+RETURNS:
+The folded name, a view into the buffer. Empty if the path doesn't fit.
+================================================================================
+*/
+static std::string_view FoldName(std::string_view path, char (&buffer)[MAX_PATH]) {
+    const size_t length = path.length();
+
+    if (length >= MAX_PATH) {
+        SDL_LogWarn(LOG_SYSTEM, "Name \"%.*s\" is too long.", static_cast<int>(length), path.data());
+        return {};
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        const char c = path[i];
+        buffer[i] = c == '\\' ? '/' : Hash::ToLower(c);
+    }
+
+    return std::string_view(buffer, length);
+}
+
+/*
+================================================================================
+NameTable::NameTable
+
+DESCRIPTION:
+Creates the table with the `NAME_NONE` entry at index 0.
+================================================================================
+*/
+NameTable::NameTable()
+        : m_ids(1024)
+        , m_strings(1024)
+        , m_chunkOffset(CHUNK_SIZE) {
+    m_strings.Add("");
+}
+
+/*
+================================================================================
+NameTable::~NameTable
+
+DESCRIPTION:
+Frees the string chunks.
+================================================================================
+*/
+NameTable::~NameTable() {
+    for (int i = 0; i < m_chunks.Size(); i++) {
+        Mem::Free(m_chunks[i]);
+    }
+}
+
+/*
+================================================================================
+NameTable::Intern
+
+DESCRIPTION:
+Folds the path and looks it up, adding it to the table if it's a new name.
+
+RETURNS:
+The id of the name, `NAME_NONE` for an empty path or one that is too long.
+================================================================================
+*/
+NameId NameTable::Intern(std::string_view path) {
+    char buffer[MAX_PATH];
+    const std::string_view name = FoldName(path, buffer);
+
+    if (name.empty()) {
+        return NAME_NONE;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        const NameId * id = m_ids.Find(name);
+        if (id != nullptr) {
+            return *id;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    // Another thread may have added it between the two locks.
+    const NameId * existing = m_ids.Find(name);
+    if (existing != nullptr) {
+        return *existing;
+    }
+
+    const char * stored = StoreString(name);
+    const auto id = static_cast<NameId>(m_strings.Add(stored));
+    m_ids.Set(std::string_view(stored, name.length()), id);
+
+    return id;
+}
+
+/*
+================================================================================
+NameTable::Find
+
+DESCRIPTION:
+Folds the path and looks it up without adding it.
+
+RETURNS:
+The id of the name, or `NAME_NONE` if it was never interned or is too long.
+================================================================================
+*/
+NameId NameTable::Find(std::string_view path) const {
+    char buffer[MAX_PATH];
+    const std::string_view name = FoldName(path, buffer);
+
+    if (name.empty()) {
+        return NAME_NONE;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    const NameId * id = m_ids.Find(name);
+
+    return id != nullptr ? *id : NAME_NONE;
+}
+
+/*
+================================================================================
+NameTable::GetString
+
+RETURNS:
+The folded name of the id. The pointer stays valid for the lifetime of the table.
+================================================================================
+*/
+const char * NameTable::GetString(NameId id) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    assert(static_cast<int>(id) < m_strings.Size());
+
+    return m_strings[static_cast<int>(id)];
+}
+
+/*
+================================================================================
+NameTable::Count
+
+RETURNS:
+The number of interned names.
+================================================================================
+*/
+int NameTable::Count() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_strings.Size() - 1;
+}
+
+/*
+================================================================================
+NameTable::MemoryUsed
+
+RETURNS:
+The memory used by the string chunks and the lookup tables in bytes.
+================================================================================
+*/
+size_t NameTable::MemoryUsed() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return static_cast<size_t>(m_chunks.Size()) * CHUNK_SIZE + m_ids.MemoryUsed() + m_strings.MemoryUsed();
+}
+
+/*
+================================================================================
+NameTable::StoreString
+
+DESCRIPTION:
+Copies the string into the current chunk, starting a new chunk when it's full.
+Must be called with the exclusive lock held.
+
+RETURNS:
+Pointer to the NUL terminated copy.
+================================================================================
+*/
+const char * NameTable::StoreString(std::string_view str) {
+    const size_t size = str.length() + 1;
+    assert(size <= CHUNK_SIZE);
+
+    if (m_chunkOffset + size > CHUNK_SIZE) {
+        m_chunks.Add(static_cast<char *>(Mem::Alloc(CHUNK_SIZE)));
+        m_chunkOffset = 0;
+    }
+
+    char * stored = m_chunks[m_chunks.Size() - 1] + m_chunkOffset;
+    memcpy(stored, str.data(), str.length());
+    stored[str.length()] = '\0';
+    m_chunkOffset += size;
+
+    return stored;
+}
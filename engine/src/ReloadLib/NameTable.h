@@ -0,0 +1,68 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_NAME_TABLE_H
+#define RELOAD_NAME_TABLE_H
+
+#include <shared_mutex>
+#include <string_view>
+#include "Common.h"
+#include "ReloadLib/Containers/HashTable.h"
+#include "ReloadLib/Containers/List.h"
+
+// Interned asset name, two names refer to the same asset when their ids match.
+typedef uint32_t NameId;
+
+static const NameId NAME_NONE = 0;
+
+/*
+================================================================================
+NameTable
+
+DESCRIPTION:
+Global table of interned asset names. Paths are folded before interning: ASCII
+letters are lower cased and backslashes turned into forward slashes, so
+"Textures\Wall.TGA" and "textures/wall.tga" get the same id. The extension is
+part of the name, "wall.tga" and "wall.png" are different assets. Paths of
+MAX_PATH or longer can't be interned and get `NAME_NONE`.
+
+The folded strings live in large chunks that are never freed or moved while the
+table is alive, so the pointers returned by `GetString` stay valid. Lookups fold
+the name into a stack buffer and don't allocate.
+
+NOTE:
+Safe to use from multiple threads, lookups only take a shared lock.
+================================================================================
+*/
+class NameTable {
+public:
+                    NameTable();
+                    ~NameTable();
+
+    NameId          Intern(std::string_view path);                              // Gets the id of the path, adding it to the table if needed.
+    NameId          Find(std::string_view path) const;                          // Gets the id of the path, or `NAME_NONE` if it was never interned.
+    const char *    GetString(NameId id) const;                                 // Gets the folded name of the id.
+    int             Count() const;                                              // Gets the number of interned names.
+    size_t          MemoryUsed() const;                                         // Gets the memory used by the string chunks.
+
+private:
+    struct FoldedNameTraits {
+        static inline uint32_t  GetHash(std::string_view key) { return Hash::Fnv1a(key); }
+        static inline bool      Equals(std::string_view a, std::string_view b) { return a == b; }
+    };
+
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    mutable std::shared_mutex                           m_mutex;
+    HashTable<std::string_view, NameId, FoldedNameTraits> m_ids;                // Folded name to id, views point into the chunks.
+    List<const char *>                                  m_strings;              // Id to folded name, index 0 is `NAME_NONE`.
+    List<char *>                                        m_chunks;
+    size_t                                              m_chunkOffset;
+
+    const char *    StoreString(std::string_view str);
+};
+
+extern NameTable nameTable;
+
+#endif //RELOAD_NAME_TABLE_H
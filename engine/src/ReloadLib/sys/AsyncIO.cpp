@@ -0,0 +1,1024 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "AsyncIO.h"
+
+#include <cerrno>
+#include "Heap.h"
+
+#ifdef WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <sys/uio.h>
+#   include <unistd.h>
+#endif
+
+#ifdef __linux__
+#   include <linux/io_uring.h>
+#   include <sys/eventfd.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#       define RLD_USE_IO_URING
+#   endif
+#endif
+
+AsyncIO asyncIO;
+
+static const unsigned IO_RING_ENTRIES = 64;                                     // Upper bound for reads in flight through io_uring.
+
+#ifdef WIN32
+typedef HANDLE FileHandle;
+static const FileHandle INVALID_FILE = INVALID_HANDLE_VALUE;
+#else
+typedef int FileHandle;
+static const FileHandle INVALID_FILE = -1;
+#endif
+
+struct IoRequest {
+    IoRequestId         id = INVALID_IO_REQUEST;
+    std::string         path;
+    size_t              offset = 0;
+    size_t              size = 0;
+    uint8_t *           data = nullptr;
+    bool                ownsData = false;                                       // The buffer was allocated by the loader.
+    IoPriority          priority = IO_PRIORITY_NORMAL;
+    IoCallback          callback = nullptr;
+    void *              userData = nullptr;
+
+    IoStatus            status = IO_STATUS_PENDING;
+    std::atomic<bool>   canceled{false};
+    FileHandle          file = INVALID_FILE;
+    size_t              bytesDone = 0;
+#ifdef RLD_USE_IO_URING
+    struct iovec        iov{};                                                  // Has to stay alive until the kernel consumed the read.
+#endif
+};
+
+/*
+================================================================================
+OpenForRead
+
+DESCRIPTION:
+Opens the file for reading and gets its size.
+
+RETURNS:
+The file handle, or INVALID_FILE on failure.
+================================================================================
+*/
+static FileHandle OpenForRead(const char *path, size_t &fileSize) {
+#ifdef WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return INVALID_FILE;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return INVALID_FILE;
+    }
+
+    fileSize = static_cast<size_t>(size.QuadPart);
+    return file;
+#else
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return INVALID_FILE;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return INVALID_FILE;
+    }
+
+    fileSize = static_cast<size_t>(fileStat.st_size);
+    return fd;
+#endif
+}
+
+/*
+================================================================================
+CloseFile
+================================================================================
+*/
+static void CloseFile(FileHandle file) {
+    if (file == INVALID_FILE) {
+        return;
+    }
+
+#ifdef WIN32
+    CloseHandle(file);
+#else
+    close(file);
+#endif
+}
+
+/*
+================================================================================
+ReadAt
+
+DESCRIPTION:
+Blocking positional read that keeps reading until the range is filled or the
+end of the file is reached.
+
+RETURNS:
+`false` on a read error.
+================================================================================
+*/
+static bool ReadAt(FileHandle file, uint8_t *dest, size_t size, size_t offset, size_t &bytesRead) {
+    bytesRead = 0;
+
+    while (bytesRead < size) {
+#ifdef WIN32
+        const size_t chunk = std::min<size_t>(size - bytesRead, 0x40000000);
+        const uint64_t position = offset + bytesRead;
+
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD numRead = 0;
+        if (!ReadFile(file, dest + bytesRead, static_cast<DWORD>(chunk), &numRead, &overlapped)) {
+            return GetLastError() == ERROR_HANDLE_EOF;
+        }
+        const auto result = static_cast<ssize_t>(numRead);
+#else
+        const ssize_t result = pread(file, dest + bytesRead, size - bytesRead, static_cast<off_t>(offset + bytesRead));
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+#endif
+        if (result == 0) {
+            break;
+        }
+
+        bytesRead += static_cast<size_t>(result);
+    }
+
+    return true;
+}
+
+#ifdef RLD_USE_IO_URING
+struct IoRing {
+    int                 fd = -1;
+    int                 eventFd = -1;                                           // Signaled by every completion and by `RingWake`.
+    unsigned            entries = 0;
+
+    void *              sqRing = MAP_FAILED;
+    size_t              sqRingSize = 0;
+    void *              cqRing = MAP_FAILED;
+    size_t              cqRingSize = 0;
+    io_uring_sqe *      sqes = nullptr;
+    size_t              sqesSize = 0;
+
+    unsigned *          sqHead = nullptr;
+    unsigned *          sqTail = nullptr;
+    unsigned *          sqMask = nullptr;
+    unsigned *          sqArray = nullptr;
+
+    unsigned *          cqHead = nullptr;
+    unsigned *          cqTail = nullptr;
+    unsigned *          cqMask = nullptr;
+    io_uring_cqe *      cqes = nullptr;
+};
+
+/*
+================================================================================
+DestroyRing
+
+DESCRIPTION:
+Unmaps the rings and closes the io_uring instance.
+================================================================================
+*/
+static void DestroyRing(IoRing *ring) {
+    if (ring->sqes != nullptr) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->cqRing != MAP_FAILED && ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqRing != MAP_FAILED) {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    if (ring->eventFd >= 0) {
+        close(ring->eventFd);
+    }
+
+    delete ring;
+}
+
+/*
+================================================================================
+CreateRing
+
+DESCRIPTION:
+Sets up an io_uring instance through the raw system calls and maps its
+submission and completion rings. An eventfd is registered with it, so the ring
+thread can sleep until either a read completes or a new request is queued.
+
+RETURNS:
+The ring, or `nullptr` if io_uring is not available, e.g. an old kernel or a
+sandbox that blocks the system calls.
+================================================================================
+*/
+static IoRing * CreateRing(unsigned entries) {
+    io_uring_params params = {};
+
+    const auto fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    auto * ring = new IoRing;
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    ring->sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED) {
+        DestroyRing(ring);
+        return nullptr;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cqRing = ring->sqRing;
+    } else {
+        ring->cqRing = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+        if (ring->cqRing == MAP_FAILED) {
+            DestroyRing(ring);
+            return nullptr;
+        }
+    }
+
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void * sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        DestroyRing(ring);
+        return nullptr;
+    }
+    ring->sqes = static_cast<io_uring_sqe *>(sqes);
+
+    auto * sq = static_cast<uint8_t *>(ring->sqRing);
+    ring->sqHead  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    ring->sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    ring->sqMask  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    ring->sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto * cq = static_cast<uint8_t *>(ring->cqRing);
+    ring->cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    ring->cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    ring->cqMask  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    ring->cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    ring->eventFd = eventfd(0, EFD_CLOEXEC);
+    if (ring->eventFd < 0) {
+        DestroyRing(ring);
+        return nullptr;
+    }
+
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &ring->eventFd, 1) < 0) {
+        DestroyRing(ring);
+        return nullptr;
+    }
+
+    return ring;
+}
+
+/*
+================================================================================
+RingQueueRead
+
+DESCRIPTION:
+Fills a submission queue entry for the remaining part of the request. The
+entry is only handed to the kernel by the next `RingEnter`.
+================================================================================
+*/
+static void RingQueueRead(IoRing *ring, IoRequest *request) {
+    const unsigned tail = *ring->sqTail;
+    const unsigned index = tail & *ring->sqMask;
+
+    request->iov.iov_base = request->data + request->bytesDone;
+    request->iov.iov_len = request->size - request->bytesDone;
+
+    io_uring_sqe & sqe = ring->sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = request->file;
+    sqe.addr = reinterpret_cast<uint64_t>(&request->iov);
+    sqe.len = 1;
+    sqe.off = request->offset + request->bytesDone;
+    sqe.user_data = reinterpret_cast<uint64_t>(request);
+
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+================================================================================
+RingUnsubmitted
+
+RETURNS:
+The number of entries queued that the kernel hasn't consumed yet.
+================================================================================
+*/
+static unsigned RingUnsubmitted(IoRing *ring) {
+    return *ring->sqTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+}
+
+/*
+================================================================================
+RingSubmit
+
+DESCRIPTION:
+Hands the queued entries to the kernel without waiting for any of them to
+complete. Entries the kernel can't take right now stay queued for the next
+call.
+
+RETURNS:
+`false` if io_uring failed and can't be used anymore.
+================================================================================
+*/
+static bool RingSubmit(IoRing *ring) {
+    const unsigned toSubmit = RingUnsubmitted(ring);
+    if (toSubmit == 0) {
+        return true;
+    }
+
+    const long result = syscall(__NR_io_uring_enter, ring->fd, toSubmit, 0, 0, nullptr, 0);
+    if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        SDL_LogError(LOG_FILE, "io_uring_enter failed: %s.", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+RingWake
+
+DESCRIPTION:
+Wakes the ring thread from `RingWait`.
+================================================================================
+*/
+static void RingWake(IoRing *ring) {
+    const uint64_t value = 1;
+    while (write(ring->eventFd, &value, sizeof(value)) < 0 && errno == EINTR) {}
+}
+
+/*
+================================================================================
+RingWait
+
+DESCRIPTION:
+Sleeps until a read completes or `RingWake` is called. Returns right away if
+that happened since the last wait.
+================================================================================
+*/
+static void RingWait(IoRing *ring) {
+    uint64_t value;
+    while (read(ring->eventFd, &value, sizeof(value)) < 0 && errno == EINTR) {}
+}
+#else
+struct IoRing {};
+#endif
+
+/*
+================================================================================
+AsyncIO::AsyncIO
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+AsyncIO::AsyncIO()
+    : m_requests(256)
+    , m_nextId(INVALID_IO_REQUEST + 1)
+    , m_running(false)
+    , m_numInFlight(0)
+    , m_ring(nullptr)
+    , m_numFallbackThreads(0) {}
+
+/*
+================================================================================
+AsyncIO::~AsyncIO
+
+DESCRIPTION:
+Makes sure the threads are stopped.
+================================================================================
+*/
+AsyncIO::~AsyncIO() {
+    Shutdown();
+}
+
+/*
+================================================================================
+AsyncIO::Init
+
+DESCRIPTION:
+Sets up io_uring and starts the thread that drives it. When io_uring isn't
+available, starts the given number of threads that execute the reads with
+blocking positional reads instead.
+================================================================================
+*/
+void AsyncIO::Init(int numFallbackThreads) {
+    assert(numFallbackThreads > 0);
+
+    m_running = true;
+    m_numFallbackThreads = numFallbackThreads;
+
+#ifdef RLD_USE_IO_URING
+    m_ring = CreateRing(IO_RING_ENTRIES);
+#endif
+
+    if (m_ring != nullptr) {
+        SDL_LogInfo(LOG_FILE, "Async IO using io_uring.");
+        m_threads.Add(new std::thread(&AsyncIO::RingThread, this));
+        return;
+    }
+
+    StartFallbackThreads();
+}
+
+/*
+================================================================================
+AsyncIO::StartFallbackThreads
+
+DESCRIPTION:
+Starts the threads that execute the reads with blocking positional reads.
+
+NOTE:
+Must be called with m_mutex held once the other threads are running.
+================================================================================
+*/
+void AsyncIO::StartFallbackThreads() {
+    SDL_LogInfo(LOG_FILE, "Async IO using %d threads.", m_numFallbackThreads);
+    for (int i = 0; i < m_numFallbackThreads; i++) {
+        m_threads.Add(new std::thread(&AsyncIO::WorkerThread, this));
+    }
+}
+
+/*
+================================================================================
+AsyncIO::Shutdown
+
+DESCRIPTION:
+Cancels all the queued requests, waits for the reads in flight to finish and
+stops the threads. The callbacks of everything that was outstanding are then
+dispatched with the final status so the owners can release their data.
+================================================================================
+*/
+void AsyncIO::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+
+        m_running = false;
+
+        for (auto & queue : m_queues) {
+            for (IoRequest * request : queue) {
+                Complete(request, IO_STATUS_CANCELED);
+            }
+            queue.clear();
+        }
+
+#ifdef RLD_USE_IO_URING
+        if (m_ring != nullptr) {
+            RingWake(m_ring);
+        }
+#endif
+    }
+
+    m_queueCv.notify_all();
+
+    // The ring thread starts the fallback threads if io_uring fails, so the
+    // list is only read under the lock until every thread is joined.
+    for (;;) {
+        std::thread * thread;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_threads.Size() == 0) {
+                break;
+            }
+
+            thread = m_threads[m_threads.Size() - 1];
+            m_threads.RemoveIndex(m_threads.Size() - 1);
+        }
+
+        thread->join();
+        delete thread;
+    }
+
+#ifdef RLD_USE_IO_URING
+    if (m_ring != nullptr) {
+        DestroyRing(m_ring);
+    }
+#endif
+    m_ring = nullptr;
+
+    Poll();
+}
+
+/*
+================================================================================
+AsyncIO::Read
+
+DESCRIPTION:
+Queues a read of the file. The callback is called from `Poll` once the read is
+done, failed or was canceled.
+
+RETURNS:
+The id of the request, used for canceling it.
+================================================================================
+*/
+IoRequestId AsyncIO::Read(const IoReadRequest &request) {
+    assert(request.path != nullptr);
+    assert(request.dest == nullptr || request.size > 0);
+    assert(request.priority >= 0 && request.priority < IO_PRIORITY_COUNT);
+
+    auto * ioRequest = new IoRequest;
+    ioRequest->path = request.path;
+    ioRequest->offset = request.offset;
+    ioRequest->size = request.size;
+    ioRequest->data = static_cast<uint8_t *>(request.dest);
+    ioRequest->ownsData = request.dest == nullptr;
+    ioRequest->priority = request.priority;
+    ioRequest->callback = request.callback;
+    ioRequest->userData = request.userData;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_running) {
+            SDL_LogCritical(LOG_FILE, "Async read of %s requested while the IO service is not running.", request.path);
+            exit(1);
+        }
+
+        ioRequest->id = m_nextId++;
+        if (m_nextId == INVALID_IO_REQUEST) {
+            m_nextId++;
+        }
+
+        m_requests.Set(ioRequest->id, ioRequest);
+        m_queues[ioRequest->priority].push_back(ioRequest);
+        m_numInFlight++;
+
+#ifdef RLD_USE_IO_URING
+        // The ring thread may be sleeping on reads in flight, it has to pick
+        // this one up right away in case it's more urgent.
+        if (m_ring != nullptr) {
+            RingWake(m_ring);
+        }
+#endif
+    }
+
+    m_queueCv.notify_one();
+
+    return ioRequest->id;
+}
+
+/*
+================================================================================
+AsyncIO::Cancel
+
+DESCRIPTION:
+Cancels the request. A queued request is dropped right away, one that is being
+read is reported as canceled once the read finishes.
+
+RETURNS:
+`false` if the request is unknown or its callback was already dispatched.
+================================================================================
+*/
+bool AsyncIO::Cancel(IoRequestId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    IoRequest ** found = m_requests.Find(id);
+    if (found == nullptr) {
+        return false;
+    }
+
+    IoRequest * request = *found;
+    request->canceled = true;
+
+    std::deque<IoRequest *> & queue = m_queues[request->priority];
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (*it == request) {
+            queue.erase(it);
+            Complete(request, IO_STATUS_CANCELED);
+            break;
+        }
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+AsyncIO::Poll
+
+DESCRIPTION:
+Dispatches the callbacks of all the requests that completed since the last
+poll, on the calling thread.
+
+RETURNS:
+The number of dispatched requests.
+================================================================================
+*/
+int AsyncIO::Poll() {
+    List<IoRequest *> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        completed.Swap(m_completed);
+    }
+
+    for (int i = 0; i < completed.Size(); i++) {
+        IoRequest * request = completed[i];
+
+        // Canceled after the read completed but before it was dispatched.
+        if (request->canceled && request->status == IO_STATUS_COMPLETE) {
+            request->status = IO_STATUS_CANCELED;
+        }
+
+        // Loader allocated buffers are only handed out for successful reads.
+        const bool deliverData = request->status == IO_STATUS_COMPLETE || !request->ownsData;
+
+        IoResult result = {};
+        result.id = request->id;
+        result.status = request->status;
+        result.data = deliverData ? request->data : nullptr;
+        result.size = request->bytesDone;
+        result.userData = request->userData;
+
+        if (request->callback != nullptr) {
+            request->callback(result);
+        }
+
+        if (request->ownsData) {
+            Mem::Free(deliverData ? result.data : request->data);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.Remove(request->id);
+        }
+
+        delete request;
+    }
+
+    return completed.Size();
+}
+
+/*
+================================================================================
+AsyncIO::Flush
+
+DESCRIPTION:
+Blocks until every outstanding request has completed and dispatches them. Meant
+for loading screens, where nothing else can progress anyway.
+================================================================================
+*/
+void AsyncIO::Flush() {
+    {
+        std::unique_lock<std::mutex> lock(m_completedMutex);
+        m_completedCv.wait(lock, [this] { return m_numInFlight.load() == 0; });
+    }
+
+    Poll();
+}
+
+/*
+================================================================================
+AsyncIO::HasQueued
+
+RETURNS:
+`true` if any request is waiting to be started.
+================================================================================
+*/
+bool AsyncIO::HasQueued() const {
+    for (const auto & queue : m_queues) {
+        if (!queue.empty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+================================================================================
+AsyncIO::PopRequest
+
+RETURNS:
+The oldest request of the highest priority, or `nullptr` if nothing is queued.
+================================================================================
+*/
+IoRequest * AsyncIO::PopRequest() {
+    for (auto & queue : m_queues) {
+        if (!queue.empty()) {
+            IoRequest * request = queue.front();
+            queue.pop_front();
+            return request;
+        }
+    }
+
+    return nullptr;
+}
+
+/*
+================================================================================
+AsyncIO::PrepareRead
+
+DESCRIPTION:
+Opens the file, resolves the size of the read and allocates the destination if
+the request didn't provide one. Requests that fail here, or that have nothing to
+read, are completed right away.
+
+RETURNS:
+`true` if the request is ready to be read.
+================================================================================
+*/
+bool AsyncIO::PrepareRead(IoRequest *request) {
+    size_t fileSize = 0;
+    request->file = OpenForRead(request->path.c_str(), fileSize);
+
+    if (request->file == INVALID_FILE) {
+        SDL_LogError(LOG_FILE, "Error opening %s.", request->path.c_str());
+        Complete(request, IO_STATUS_FAILED);
+        return false;
+    }
+
+    if (request->offset > fileSize) {
+        SDL_LogError(LOG_FILE, "Read offset %zu is past the end of %s.", request->offset, request->path.c_str());
+        Complete(request, IO_STATUS_FAILED);
+        return false;
+    }
+
+    if (request->size == 0) {
+        request->size = fileSize - request->offset;
+    }
+
+    if (request->size == 0) {
+        Complete(request, IO_STATUS_COMPLETE);
+        return false;
+    }
+
+    if (request->ownsData) {
+        request->data = static_cast<uint8_t *>(Mem::Alloc(request->size));
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+AsyncIO::Complete
+
+DESCRIPTION:
+Closes the file and moves the request to the completed list, where it waits
+for `Poll` to dispatch it.
+================================================================================
+*/
+void AsyncIO::Complete(IoRequest *request, IoStatus status) {
+    CloseFile(request->file);
+    request->file = INVALID_FILE;
+
+    if (status == IO_STATUS_COMPLETE && request->canceled) {
+        status = IO_STATUS_CANCELED;
+    }
+
+    request->status = status;
+
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        m_completed.Add(request);
+        m_numInFlight--;
+    }
+
+    m_completedCv.notify_all();
+}
+
+/*
+================================================================================
+AsyncIO::RingThread
+
+DESCRIPTION:
+Drives the io_uring instance. Keeps up to a ring's worth of reads in flight,
+picking new requests by priority as slots free up, and resubmits the rest of
+any read the kernel returned short. Submitting doesn't wait for completions,
+the thread sleeps on the ring's eventfd instead, which a new request signals
+as well, so a high priority read is submitted without waiting for unrelated
+reads to finish.
+================================================================================
+*/
+void AsyncIO::RingThread() {
+#ifdef RLD_USE_IO_URING
+    IoRing * ring = m_ring;
+    IoRequest * batch[IO_RING_ENTRIES];
+    unsigned inFlight = 0;
+
+    for (;;) {
+        unsigned batchSize = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (!m_running && inFlight == 0 && !HasQueued()) {
+                return;
+            }
+
+            while (inFlight + batchSize < ring->entries && batchSize < IO_RING_ENTRIES) {
+                IoRequest * request = PopRequest();
+                if (request == nullptr) {
+                    break;
+                }
+                batch[batchSize++] = request;
+            }
+        }
+
+        for (unsigned i = 0; i < batchSize; i++) {
+            IoRequest * request = batch[i];
+
+            if (request->canceled) {
+                Complete(request, IO_STATUS_CANCELED);
+                continue;
+            }
+
+            if (PrepareRead(request)) {
+                RingQueueRead(ring, request);
+                inFlight++;
+            }
+        }
+
+        if (!RingSubmit(ring)) {
+            RingFallback(inFlight);
+            return;
+        }
+
+        RingReap(inFlight, true);
+
+        // Short reads were queued again and still have to be submitted.
+        if (RingUnsubmitted(ring) == 0) {
+            RingWait(ring);
+        }
+    }
+#endif
+}
+
+/*
+================================================================================
+AsyncIO::RingReap
+
+DESCRIPTION:
+Completes the reads the kernel finished. When `resubmit` is set the rest of a
+short read is queued again, otherwise the read completes with what it got.
+================================================================================
+*/
+void AsyncIO::RingReap(unsigned &inFlight, bool resubmit) {
+#ifdef RLD_USE_IO_URING
+    IoRing * ring = m_ring;
+
+    unsigned head = *ring->cqHead;
+    const unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const io_uring_cqe & cqe = ring->cqes[head & *ring->cqMask];
+        auto * request = reinterpret_cast<IoRequest *>(cqe.user_data);
+        inFlight--;
+
+        if (resubmit && (cqe.res == -EINTR || cqe.res == -EAGAIN)) {
+            RingQueueRead(ring, request);
+            inFlight++;
+            continue;
+        }
+
+        if (cqe.res < 0) {
+            SDL_LogError(LOG_FILE, "Error reading %s: %s.", request->path.c_str(), strerror(-cqe.res));
+            Complete(request, IO_STATUS_FAILED);
+            continue;
+        }
+
+        request->bytesDone += static_cast<size_t>(cqe.res);
+
+        // A short read that isn't at the end of the file, read the rest.
+        if (resubmit && cqe.res > 0 && request->bytesDone < request->size && !request->canceled) {
+            RingQueueRead(ring, request);
+            inFlight++;
+            continue;
+        }
+
+        Complete(request, IO_STATUS_COMPLETE);
+    }
+
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+#else
+    (void)inFlight;
+    (void)resubmit;
+#endif
+}
+
+/*
+================================================================================
+AsyncIO::RingFallback
+
+DESCRIPTION:
+Called by the ring thread once io_uring failed. The reads the kernel never
+took fail with `IO_STATUS_FAILED`, the ones it did are waited for, since it
+still writes into their buffers. The queued requests are then left to the
+fallback threads.
+================================================================================
+*/
+void AsyncIO::RingFallback(unsigned &inFlight) {
+#ifdef RLD_USE_IO_URING
+    IoRing * ring = m_ring;
+
+    const unsigned tail = *ring->sqTail;
+    for (unsigned head = *ring->sqHead; head != tail; head++) {
+        const io_uring_sqe & sqe = ring->sqes[ring->sqArray[head & *ring->sqMask]];
+        Complete(reinterpret_cast<IoRequest *>(sqe.user_data), IO_STATUS_FAILED);
+        inFlight--;
+    }
+
+    while (inFlight > 0) {
+        RingWait(ring);
+        RingReap(inFlight, false);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ring = nullptr;
+
+        if (m_running) {
+            StartFallbackThreads();
+        }
+    }
+
+    m_queueCv.notify_all();
+    DestroyRing(ring);
+#else
+    (void)inFlight;
+#endif
+}
+
+/*
+================================================================================
+AsyncIO::WorkerThread
+
+DESCRIPTION:
+Fallback worker, executes one request at a time with blocking reads.
+================================================================================
+*/
+void AsyncIO::WorkerThread() {
+    for (;;) {
+        IoRequest * request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueCv.wait(lock, [this] { return !m_running || HasQueued(); });
+
+            request = PopRequest();
+            if (request == nullptr) {
+                return;
+            }
+        }
+
+        if (request->canceled) {
+            Complete(request, IO_STATUS_CANCELED);
+            continue;
+        }
+
+        if (!PrepareRead(request)) {
+            continue;
+        }
+
+        const bool success = ReadAt(request->file, request->data, request->size, request->offset, request->bytesDone);
+        if (!success) {
+            SDL_LogError(LOG_FILE, "Error reading %s.", request->path.c_str());
+        }
+
+        Complete(request, success ? IO_STATUS_COMPLETE : IO_STATUS_FAILED);
+    }
+}
@@ -0,0 +1,125 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_ASYNC_IO_H
+#define RELOAD_ASYNC_IO_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Common.h"
+#include "ReloadLib/Containers/HashTable.h"
+#include "ReloadLib/Containers/List.h"
+
+typedef uint32_t IoRequestId;
+
+static const IoRequestId INVALID_IO_REQUEST = 0;
+
+enum IoPriority {
+    IO_PRIORITY_HIGH,                                                           // Needed this frame, e.g. a missing texture on screen.
+    IO_PRIORITY_NORMAL,
+    IO_PRIORITY_LOW,                                                            // Prefetching and background streaming.
+    IO_PRIORITY_COUNT
+};
+
+enum IoStatus {
+    IO_STATUS_PENDING,
+    IO_STATUS_COMPLETE,
+    IO_STATUS_FAILED,
+    IO_STATUS_CANCELED
+};
+
+struct IoResult {
+    IoRequestId         id;
+    IoStatus            status;
+    uint8_t *           data;                                                   // Set to nullptr in the callback to take ownership of a loader allocated buffer.
+    size_t              size;                                                   // Number of bytes read.
+    void *              userData;
+};
+
+typedef void (*IoCallback)(IoResult &result);
+
+struct IoReadRequest {
+    const char *        path = nullptr;                                         // Copied, doesn't have to outlive the call.
+    size_t              offset = 0;
+    size_t              size = 0;                                               // 0 reads from the offset to the end of the file.
+    void *              dest = nullptr;                                         // Optional destination, otherwise the buffer is allocated with Mem::Alloc.
+    IoPriority          priority = IO_PRIORITY_NORMAL;
+    IoCallback          callback = nullptr;                                     // Called from `Poll` on the polling thread.
+    void *              userData = nullptr;
+};
+
+struct IoRequest;
+struct IoRing;
+
+/*
+================================================================================
+AsyncIO
+
+DESCRIPTION:
+Asynchronous file read service. Requests are queued by priority and executed
+in the background, either through an io_uring instance on Linux or through a
+small pool of threads issuing blocking positional reads where io_uring isn't
+available. Completed requests are collected and their callbacks are dispatched
+by `Poll` on the thread that calls it, usually once per frame on the main
+thread, so callbacks never run concurrently with the game code.
+
+When a request doesn't provide a destination the loader allocates the buffer.
+It is freed after the callback returns, unless the callback takes ownership of
+it by clearing `IoResult::data`.
+
+NOTE:
+Canceling a request that is already being read only suppresses its result, the
+callback is still called with `IO_STATUS_CANCELED`.
+================================================================================
+*/
+class AsyncIO {
+public:
+                    AsyncIO();
+                    ~AsyncIO();
+
+    void            Init(int numFallbackThreads);                               // Starts the io_uring thread, or the fallback thread pool.
+    void            Shutdown();                                                 // Cancels the queued requests and waits for the ones in flight.
+
+    IoRequestId     Read(const IoReadRequest &request);                         // Queues a read. Returns the id of the request.
+    bool            Cancel(IoRequestId id);                                     // Cancels the request. Returns `false` if it was already dispatched.
+    int             Poll();                                                     // Dispatches the callbacks of completed requests. Returns their number.
+    void            Flush();                                                    // Blocks until all the requests are complete and dispatches them.
+
+    [[nodiscard]] bool  IsUsingIoUring() const { return m_ring.load() != nullptr; }
+    [[nodiscard]] int   PendingCount() const { return m_numInFlight.load(); }   // Gets the number of requests that haven't completed yet.
+
+private:
+    std::mutex                          m_mutex;                                // Guards the queues and the request table.
+    std::condition_variable             m_queueCv;
+    std::deque<IoRequest *>             m_queues[IO_PRIORITY_COUNT];
+    HashTable<IoRequestId, IoRequest *> m_requests;                             // All requests that haven't been dispatched yet.
+    IoRequestId                         m_nextId;
+    bool                                m_running;
+
+    std::mutex                          m_completedMutex;
+    std::condition_variable             m_completedCv;
+    List<IoRequest *>                   m_completed;
+    std::atomic<int>                    m_numInFlight;                          // Queued or executing, not yet completed.
+
+    std::atomic<IoRing *>               m_ring;                                 // Cleared under m_mutex if io_uring fails.
+    List<std::thread *>                 m_threads;                              // Guarded by m_mutex once the threads are running.
+    int                                 m_numFallbackThreads;
+
+    bool            HasQueued() const;                                          // Must be called with m_mutex held.
+    IoRequest *     PopRequest();                                               // Must be called with m_mutex held.
+    bool            PrepareRead(IoRequest *request);
+    void            Complete(IoRequest *request, IoStatus status);
+    void            StartFallbackThreads();
+    void            RingThread();
+    void            RingReap(unsigned &inFlight, bool resubmit);
+    void            RingFallback(unsigned &inFlight);
+    void            WorkerThread();
+};
+
+extern AsyncIO asyncIO;
+
+#endif //RELOAD_ASYNC_IO_H
@@ -1,6 +1,28 @@
 #include "Heap.h"
 
 #include <cstdlib>
+#include <atomic>
+#include <mutex>
+
+struct FrameOverflowBlock {
+    FrameOverflowBlock *    next;
+};
+
+struct FrameArena {
+    char *                  base = nullptr;
+    size_t                  size = 0;
+    std::atomic<size_t>     offset{0};
+    size_t                  overflowBytes = 0;                                  // Bytes that did not fit into the arena this frame.
+    FrameOverflowBlock *    overflow = nullptr;                                 // Heap blocks handed out after the arena ran out.
+};
+
+static FrameArena               s_frameArenas[MAX_FRAME_ARENAS];
+static int                      s_numFrameArenas = 0;
+static std::atomic<FrameArena *> s_currentArena{nullptr};                       // Published with release, so allocating threads see the reset arena.
+static std::mutex               s_overflowMutex;
+
+static const size_t FRAME_ARENA_ALIGNMENT = 64;
+static const size_t FRAME_ARENA_GROW_SIZE = 1024 * 1024;
 
 void *Mem::Alloc16(const int size) {
     if (!size) {
@@ -21,4 +43,228 @@ void *	Mem::ClearedAlloc(const size_t size) {
     return mem;
 }
 
+/*
+================================================================================
+AllocArenaMemory
+
+DESCRIPTION:
+Allocates the backing block of a frame arena aligned to a cache line.
+================================================================================
+*/
+static char * AllocArenaMemory(size_t size) {
+    const size_t paddedSize = (size + FRAME_ARENA_ALIGNMENT - 1) & ~(FRAME_ARENA_ALIGNMENT - 1);
+#ifdef WIN32
+    return static_cast<char *>(_aligned_malloc(paddedSize, FRAME_ARENA_ALIGNMENT));
+#else
+    return static_cast<char *>(std::aligned_alloc(FRAME_ARENA_ALIGNMENT, paddedSize));
+#endif
+}
+
+/*
+================================================================================
+FreeArenaMemory
+
+DESCRIPTION:
+Frees the backing block of a frame arena.
+================================================================================
+*/
+static void FreeArenaMemory(char * mem) {
+#ifdef WIN32
+    _aligned_free(mem);
+#else
+    std::free(mem);
+#endif
+}
+
+/*
+================================================================================
+FreeArenaOverflow
+
+DESCRIPTION:
+Frees all the heap blocks that were handed out after the arena ran out of space.
+================================================================================
+*/
+static void FreeArenaOverflow(FrameArena & arena) {
+    FrameOverflowBlock * block = arena.overflow;
+
+    while (block != nullptr) {
+        FrameOverflowBlock * next = block->next;
+        std::free(block);
+        block = next;
+    }
+
+    arena.overflow = nullptr;
+}
+
+/*
+================================================================================
+Mem::InitFrameArenas
+
+DESCRIPTION:
+Allocates one linear arena per frame slot. Memory handed out by `FrameAlloc` is
+only valid until the same frame slot is started again, which gives the frontend
+a whole frame in flight before its temporaries are recycled.
+================================================================================
+*/
+void Mem::InitFrameArenas(int numArenas, size_t arenaSize) {
+    assert(numArenas > 0 && numArenas <= MAX_FRAME_ARENAS);
+    assert(arenaSize > 0);
+
+    ShutdownFrameArenas();
+
+    for (int i = 0; i < numArenas; i++) {
+        FrameArena & arena = s_frameArenas[i];
+        arena.base = AllocArenaMemory(arenaSize);
+        arena.size = arenaSize;
+        arena.offset = 0;
+        arena.overflowBytes = 0;
+        arena.overflow = nullptr;
+
+        if (arena.base == nullptr) {
+            SDL_LogCritical(LOG_SYSTEM, "Couldn't allocate %zu bytes for the frame arena.", arenaSize);
+            exit(1);
+        }
+    }
+
+    s_numFrameArenas = numArenas;
+    s_currentArena.store(&s_frameArenas[0], std::memory_order_release);
+}
+
+/*
+================================================================================
+Mem::ShutdownFrameArenas
+
+DESCRIPTION:
+Frees the per-frame arenas and any overflow allocations.
+================================================================================
+*/
+void Mem::ShutdownFrameArenas() {
+    for (int i = 0; i < s_numFrameArenas; i++) {
+        FrameArena & arena = s_frameArenas[i];
+
+        FreeArenaOverflow(arena);
+        FreeArenaMemory(arena.base);
+
+        arena.base = nullptr;
+        arena.size = 0;
+        arena.offset = 0;
+        arena.overflowBytes = 0;
+    }
+
+    s_numFrameArenas = 0;
+    s_currentArena.store(nullptr, std::memory_order_release);
+}
+
+/*
+================================================================================
+Mem::BeginFrameArena
+
+DESCRIPTION:
+Resets the arena of the given frame slot and makes it the current one. If the
+arena overflowed the last time it was used it is grown to fit, so allocations
+stop hitting the heap once the frame working set is known.
+
+NOTE:
+Must not be called while other threads are allocating frame memory.
+================================================================================
+*/
+void Mem::BeginFrameArena(int arenaIdx) {
+    assert(arenaIdx >= 0 && arenaIdx < s_numFrameArenas);
+
+    FrameArena & arena = s_frameArenas[arenaIdx];
+    FreeArenaOverflow(arena);
+
+    if (arena.overflowBytes > 0) {
+        size_t newSize = arena.size + arena.overflowBytes + FRAME_ARENA_GROW_SIZE - 1;
+        newSize -= newSize % FRAME_ARENA_GROW_SIZE;
+
+        SDL_LogWarn(LOG_SYSTEM, "Frame arena %d overflowed by %zu bytes, growing to %zu bytes.",
+                    arenaIdx, arena.overflowBytes, newSize);
+
+        FreeArenaMemory(arena.base);
+        arena.base = AllocArenaMemory(newSize);
+        arena.size = newSize;
+        arena.overflowBytes = 0;
+
+        if (arena.base == nullptr) {
+            SDL_LogCritical(LOG_SYSTEM, "Couldn't allocate %zu bytes for the frame arena.", newSize);
+            exit(1);
+        }
+    }
+
+    arena.offset = 0;
+    s_currentArena.store(&arena, std::memory_order_release);
+}
+
+/*
+================================================================================
+Mem::FrameAlloc
+
+DESCRIPTION:
+Bump allocates memory from the current frame arena. The memory is not cleared
+and is never freed individually. Safe to call from multiple threads. When the
+arena is full the request falls back to the heap, and the arena is grown the
+next time it is reset.
+
+RETURNS:
+Pointer to the allocated memory.
+================================================================================
+*/
+void * Mem::FrameAlloc(size_t size, size_t alignment) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
 
+    FrameArena * arena = s_currentArena.load(std::memory_order_acquire);
+    if (arena == nullptr) {
+        SDL_LogCritical(LOG_SYSTEM, "Frame memory requested before the frame arenas were initialized.");
+        exit(1);
+    }
+
+    size_t offset = arena->offset.load(std::memory_order_relaxed);
+    for (;;) {
+        const size_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+        const size_t end = alignedOffset + size;
+
+        if (end > arena->size) {
+            break;
+        }
+
+        if (arena->offset.compare_exchange_weak(offset, end, std::memory_order_relaxed)) {
+            return arena->base + alignedOffset;
+        }
+    }
+
+    // The arena is full, fall back to the heap for the rest of the frame.
+    const size_t headerSize = (sizeof(FrameOverflowBlock) + alignment - 1) & ~(alignment - 1);
+    auto * block = static_cast<FrameOverflowBlock *>(std::malloc(headerSize + size + alignment));
+
+    if (block == nullptr) {
+        SDL_LogCritical(LOG_SYSTEM, "Couldn't allocate %zu bytes of frame memory.", size);
+        exit(1);
+    }
+
+    std::lock_guard<std::mutex> lock(s_overflowMutex);
+    block->next = arena->overflow;
+    arena->overflow = block;
+    arena->overflowBytes += size + alignment;
+
+    const auto address = reinterpret_cast<uintptr_t>(block) + headerSize;
+    return reinterpret_cast<void *>((address + alignment - 1) & ~(alignment - 1));
+}
+
+/*
+================================================================================
+Mem::FrameMemoryUsed
+
+RETURNS:
+The number of bytes allocated from the current frame arena.
+================================================================================
+*/
+size_t Mem::FrameMemoryUsed() {
+    const FrameArena * arena = s_currentArena.load(std::memory_order_acquire);
+    if (arena == nullptr) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(s_overflowMutex);
+    return arena->offset.load(std::memory_order_relaxed) + arena->overflowBytes;
+}
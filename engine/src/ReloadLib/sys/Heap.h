@@ -7,6 +7,9 @@
 
 #include "Common.h"
 
+// Upper bound for the number of frame arenas, one is used per frame in flight.
+static const int MAX_FRAME_ARENAS = 4;
+
 class Mem {
 public:
     static inline void *    Alloc(size_t size) {
@@ -23,10 +26,55 @@ public:
         }
     }
 
+    static inline void *    Realloc(void *ptr, size_t size) {
+#if defined(USE_ALIGNED_ALLOC) && defined(WIN32)
+        return _aligned_realloc(ptr, size, 16);
+#else
+        return std::realloc(ptr, size);
+#endif
+    }
+
     static void *		    ClearedAlloc(size_t size);
 
+    static void             InitFrameArenas(int numArenas, size_t arenaSize);   // Allocates the linear per-frame arenas.
+    static void             ShutdownFrameArenas();                              // Frees the per-frame arenas and any overflow allocations.
+    static void             BeginFrameArena(int arenaIdx);                      // Resets the arena of the given frame slot and makes it current.
+    static void *           FrameAlloc(size_t size, size_t alignment = 16);     // Bump allocates memory that lives until the arena is reset.
+    static size_t           FrameMemoryUsed();                                  // Gets the number of bytes allocated from the current arena.
+
 private:
     static void *           Alloc16(int size);
 };
 
+/*
+================================================================================
+Allocator policies
+
+DESCRIPTION:
+Static allocation policies that can be plugged into the containers. The heap
+policy goes through the general purpose allocator, while the frame policy takes
+memory from the current frame arena and never frees it individually, the whole
+arena is dropped when its frame slot comes around again. `Realloc` is only used
+by the containers for trivially copyable elements.
+================================================================================
+*/
+struct HeapAllocator {
+    static inline void *    Alloc(size_t size) { return Mem::Alloc(size); }
+    static inline void *    Realloc(void *ptr, size_t, size_t newSize) { return Mem::Realloc(ptr, newSize); }
+    static inline void      Free(void *ptr) { Mem::Free(ptr); }
+};
+
+struct FrameAllocator {
+    static inline void *    Alloc(size_t size) { return Mem::FrameAlloc(size); }
+    static inline void      Free(void *) {}
+
+    static inline void *    Realloc(void *ptr, size_t oldSize, size_t newSize) {
+        void * mem = Mem::FrameAlloc(newSize);
+        if (ptr != nullptr) {
+            memcpy(mem, ptr, std::min(oldSize, newSize));
+        }
+        return mem;
+    }
+};
+
 #endif //RELOAD_HEAP_H
@@ -0,0 +1,526 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#ifdef WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+JobSystem jobSystem;
+
+static const int MAX_JOB_THREADS = 64;
+static const int NUM_RESERVED_CORES = 2;                                        // The thread that calls Init and the render thread.
+
+static thread_local int workerIndex = -1;
+
+/*
+================================================================================
+PinThreadToCore
+
+DESCRIPTION:
+Restricts the thread to a single core, so the scheduler doesn't move the worker
+around and its caches stay warm.
+================================================================================
+*/
+static void PinThreadToCore(std::thread &thread, int core) {
+#ifdef WIN32
+    SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet) != 0) {
+        SDL_LogWarn(LOG_SYSTEM, "Couldn't pin the job worker to core %d.", core);
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+/*
+================================================================================
+JobSystem::JobSystem
+
+DESCRIPTION:
+Until Init is called the jobs are executed right away on the calling thread.
+================================================================================
+*/
+JobSystem::JobSystem() : m_queues(nullptr), m_numThreads(1), m_numQueued(0), m_running(false), m_numPushes(0) {}
+
+/*
+================================================================================
+JobSystem::~JobSystem
+
+DESCRIPTION:
+Makes sure the workers are stopped.
+================================================================================
+*/
+JobSystem::~JobSystem() {
+    Shutdown();
+}
+
+/*
+================================================================================
+JobSystem::Init
+
+DESCRIPTION:
+Starts the workers, by default one per core besides the ones reserved for the
+calling thread and the render thread, and at least one. Worker `i` is pinned to
+core `i + 1`, so the first cores are left to the reserved threads. Workers past
+the last core aren't pinned.
+================================================================================
+*/
+void JobSystem::Init(int numWorkers) {
+    assert(!m_running);
+
+    const int numCores = static_cast<int>(std::thread::hardware_concurrency());
+
+    if (numWorkers < 0) {
+        numWorkers = std::max(1, numCores - NUM_RESERVED_CORES);
+    }
+    numWorkers = std::min(numWorkers, MAX_JOB_THREADS - 1);
+
+    m_numThreads = numWorkers + 1;
+    m_queues = new WorkerQueue[m_numThreads];
+    m_numQueued = 0;
+    m_running = true;
+
+    workerIndex = 0;
+
+    for (int i = 1; i < m_numThreads; i++) {
+        auto * thread = new std::thread(&JobSystem::WorkerLoop, this, i);
+        if (i + 1 < numCores) {
+            PinThreadToCore(*thread, i + 1);
+        }
+        m_threads.Add(thread);
+    }
+
+    SDL_LogInfo(LOG_SYSTEM, "Job system using %d workers.", numWorkers);
+}
+
+/*
+================================================================================
+JobSystem::Shutdown
+
+DESCRIPTION:
+Stops the workers. All the jobs have to be waited on before, anything still
+queued is dropped.
+================================================================================
+*/
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        if (!m_running) {
+            return;
+        }
+
+        m_running = false;
+    }
+
+    m_sleepCv.notify_all();
+
+    for (int i = 0; i < m_threads.Size(); i++) {
+        m_threads[i]->join();
+        delete m_threads[i];
+    }
+    m_threads.Clear();
+
+    delete[] m_queues;
+    m_queues = nullptr;
+    m_numThreads = 1;
+
+    workerIndex = -1;
+}
+
+/*
+================================================================================
+JobSystem::Run
+
+DESCRIPTION:
+Queues the jobs. When a counter is given, it's incremented for every job and
+decremented again as each of them finishes.
+================================================================================
+*/
+void JobSystem::Run(const Job *jobs, int count, JobCounter *counter) {
+    Start(jobs, count, counter, false);
+}
+
+/*
+================================================================================
+JobSystem::RunBackground
+
+DESCRIPTION:
+Queues long running jobs on the background queue. Workers only take them when
+there's no other work, and a `Wait` only executes them when it waits on their
+counter, so they never stall a frame that waits on something else.
+================================================================================
+*/
+void JobSystem::RunBackground(const Job *jobs, int count, JobCounter *counter) {
+    Start(jobs, count, counter, true);
+}
+
+/*
+================================================================================
+JobSystem::Start
+
+DESCRIPTION:
+Counts the jobs on the counter and pushes them to the queues in batches.
+================================================================================
+*/
+void JobSystem::Start(const Job *jobs, int count, JobCounter *counter, bool background) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (counter != nullptr) {
+        counter->value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    QueuedJob queued[MAX_JOB_THREADS];
+    for (int i = 0; i < count; i += MAX_JOB_THREADS) {
+        const int batch = std::min(count - i, MAX_JOB_THREADS);
+
+        for (int j = 0; j < batch; j++) {
+            queued[j].job = jobs[i + j];
+            queued[j].counter = counter;
+            queued[j].background = background;
+        }
+
+        Push(queued, batch);
+    }
+}
+
+/*
+================================================================================
+JobSystem::RunAfter
+
+DESCRIPTION:
+Queues the jobs once the dependency is done. The counter is incremented right
+away, so waiting on it also covers the jobs that haven't been started yet.
+================================================================================
+*/
+void JobSystem::RunAfter(JobCounter *dependency, const Job *jobs, int count, JobCounter *counter) {
+    if (dependency == nullptr) {
+        Run(jobs, count, counter);
+        return;
+    }
+
+    if (count <= 0) {
+        return;
+    }
+
+    {
+        // Finish flushes the waiting jobs under the same lock after the counter
+        // hit zero, so either the jobs get parked before that or the dependency
+        // is already seen as done here.
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->IsDone()) {
+            if (counter != nullptr) {
+                counter->value.fetch_add(count, std::memory_order_relaxed);
+            }
+
+            for (int i = 0; i < count; i++) {
+                dependency->waiting.Add({ jobs[i], counter, false });
+            }
+            return;
+        }
+    }
+
+    Run(jobs, count, counter);
+}
+
+/*
+================================================================================
+JobSystem::Wait
+
+DESCRIPTION:
+Executes queued jobs on the calling thread until the counter is done, instead of
+blocking while the workers do all the work. Background jobs are only taken when
+they belong to the counter, the wait must not get stuck in a long job it doesn't
+depend on. When there's nothing to take the thread sleeps until the counter is
+done or new jobs are queued. Once it returns the counter can be destroyed.
+================================================================================
+*/
+void JobSystem::Wait(JobCounter *counter) {
+    const int index = workerIndex;
+    uint64_t numPushes = m_numPushes.load(std::memory_order_acquire);
+
+    while (!counter->IsDone()) {
+        QueuedJob job;
+        if (GetJob(index, job) || GetBackgroundJob(counter, job)) {
+            Execute(job);
+            continue;
+        }
+
+        // Anything queued after numPushes was read is seen by the predicate,
+        // the jobs queued before it were just found to be none of ours.
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_waitCv.wait(lock, [&] {
+            return counter->IsDone() || m_numPushes.load(std::memory_order_relaxed) != numPushes;
+        });
+        numPushes = m_numPushes.load(std::memory_order_relaxed);
+    }
+
+    // The job that finished the counter may still hold its lock.
+    std::lock_guard<std::mutex> lock(counter->mutex);
+}
+
+/*
+================================================================================
+JobSystem::WorkerIndex
+
+RETURNS:
+The index of the calling worker, 0 for the thread that called Init and -1 for
+threads that don't belong to the job system.
+================================================================================
+*/
+int JobSystem::WorkerIndex() {
+    return workerIndex;
+}
+
+/*
+================================================================================
+JobSystem::ThreadSlot
+
+DESCRIPTION:
+Maps the calling thread to one of `numThreads + 1` per-thread resources. Job
+threads get their own slot, every other thread shares the last one and has to
+guard it.
+
+RETURNS:
+The worker index for job threads, `numThreads` for any other thread.
+================================================================================
+*/
+int JobSystem::ThreadSlot(int numThreads) {
+    return workerIndex >= 0 && workerIndex < numThreads ? workerIndex : numThreads;
+}
+
+/*
+================================================================================
+JobSystem::Push
+
+DESCRIPTION:
+Pushes the jobs to the back of the queue of the calling worker, or the shared
+queue for other threads, background jobs to the background queue, and wakes up
+the sleeping workers. Without workers the jobs are executed right away.
+================================================================================
+*/
+void JobSystem::Push(const QueuedJob *jobs, int count) {
+    if (!m_running) {
+        for (int i = 0; i < count; i++) {
+            Execute(jobs[i]);
+        }
+        return;
+    }
+
+    const int index = workerIndex;
+    auto insert = [&](WorkerQueue &queue, bool background) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (int i = 0; i < count; i++) {
+            if (jobs[i].background == background) {
+                queue.jobs.push_back(jobs[i]);
+            }
+        }
+    };
+
+    insert(index >= 0 ? m_queues[index] : m_sharedQueue, false);
+    insert(m_backgroundQueue, true);
+
+    {
+        // Taking the lock orders the increment with the check of sleeping
+        // workers, so a worker can't miss the wake up.
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_numQueued.fetch_add(count, std::memory_order_release);
+        m_numPushes.fetch_add(1, std::memory_order_release);
+    }
+
+    if (count == 1) {
+        m_sleepCv.notify_one();
+    } else {
+        m_sleepCv.notify_all();
+    }
+    m_waitCv.notify_all();
+}
+
+/*
+================================================================================
+JobSystem::GetJob
+
+DESCRIPTION:
+Takes the newest job of the worker's own queue, then the oldest one from the
+shared queue and finally tries to steal the oldest job of the other workers.
+Background jobs are left alone.
+
+RETURNS:
+`true` if a job was taken.
+================================================================================
+*/
+bool JobSystem::GetJob(int index, QueuedJob &job) {
+    if (m_numQueued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    auto take = [&](WorkerQueue &queue, bool newest) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return false;
+        }
+
+        if (newest) {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        } else {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+
+        m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    };
+
+    if (index >= 0 && take(m_queues[index], true)) {
+        return true;
+    }
+
+    if (take(m_sharedQueue, false)) {
+        return true;
+    }
+
+    const int first = index >= 0 ? index + 1 : 0;
+    for (int i = 0; i < m_numThreads; i++) {
+        const int victim = (first + i) % m_numThreads;
+        if (victim != index && take(m_queues[victim], false)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+================================================================================
+JobSystem::GetBackgroundJob
+
+DESCRIPTION:
+Takes the oldest background job, or with a counter the oldest background job
+of that counter.
+
+RETURNS:
+`true` if a job was taken.
+================================================================================
+*/
+bool JobSystem::GetBackgroundJob(const JobCounter *counter, QueuedJob &job) {
+    if (m_numQueued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_backgroundQueue.mutex);
+    std::deque<QueuedJob> & jobs = m_backgroundQueue.jobs;
+
+    auto it = jobs.begin();
+    if (counter != nullptr) {
+        it = std::find_if(jobs.begin(), jobs.end(), [counter](const QueuedJob &queued) {
+            return queued.counter == counter;
+        });
+    }
+
+    if (it == jobs.end()) {
+        return false;
+    }
+
+    job = *it;
+    jobs.erase(it);
+
+    m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+/*
+================================================================================
+JobSystem::Execute
+
+DESCRIPTION:
+Runs the job and signals its counter.
+================================================================================
+*/
+void JobSystem::Execute(const QueuedJob &job) {
+    job.job.func(job.job.data);
+
+    if (job.counter != nullptr) {
+        Finish(job.counter);
+    }
+}
+
+/*
+================================================================================
+JobSystem::Finish
+
+DESCRIPTION:
+Decrements the counter. The job that brings it to zero wakes up the threads
+waiting on it and starts the jobs that were waiting on it.
+================================================================================
+*/
+void JobSystem::Finish(JobCounter *counter) {
+    List<QueuedJob> waiting;
+    {
+        // Decrementing under the lock lets Wait make sure this is done with the
+        // counter before the owner is allowed to destroy it.
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->value.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        waiting = std::move(counter->waiting);
+    }
+
+    {
+        // A waiter checks the counter under this lock before it sleeps, so it
+        // either sees it done or is already asleep for the notify.
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_waitCv.notify_all();
+
+    if (waiting.Size() > 0) {
+        Push(waiting.Data(), waiting.Size());
+    }
+}
+
+/*
+================================================================================
+JobSystem::WorkerLoop
+
+DESCRIPTION:
+Executes jobs until the job system is shut down, sleeping while all the queues
+are empty. Background jobs are only taken when there's nothing else to do.
+================================================================================
+*/
+void JobSystem::WorkerLoop(int index) {
+    workerIndex = index;
+
+    while (true) {
+        QueuedJob job;
+        if (GetJob(index, job) || GetBackgroundJob(nullptr, job)) {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.wait(lock, [this] {
+            return !m_running || m_numQueued.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!m_running) {
+            return;
+        }
+    }
+}
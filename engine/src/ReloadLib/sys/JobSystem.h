@@ -0,0 +1,185 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_JOB_SYSTEM_H
+#define RELOAD_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Common.h"
+#include "ReloadLib/Containers/InlineList.h"
+#include "ReloadLib/Containers/List.h"
+
+struct JobCounter;
+
+typedef void (*JobFunc)(void *data);
+
+struct Job {
+    JobFunc             func = nullptr;
+    void *              data = nullptr;
+};
+
+// A job together with the counter it decrements once it's done.
+struct QueuedJob {
+    Job                 job;
+    JobCounter *        counter;
+    bool                background;                                             // Queued on the background queue, see JobSystem::RunBackground.
+};
+
+/*
+================================================================================
+JobCounter
+
+DESCRIPTION:
+Tracks a group of jobs. Every job started with the counter increments it and
+decrements it once it's done, so the group is finished when the counter is back
+at zero. Jobs started with `JobSystem::RunAfter` are parked on the counter they
+depend on and kicked off when it reaches zero.
+
+NOTE:
+The counter has to outlive all the jobs that use it.
+================================================================================
+*/
+struct JobCounter {
+    std::atomic<int>    value{0};
+    std::mutex          mutex;                                                  // Guards the waiting jobs.
+    List<QueuedJob>     waiting;                                                // Jobs that start once the counter reaches zero.
+
+    [[nodiscard]] bool  IsDone() const { return value.load(std::memory_order_acquire) == 0; }
+};
+
+/*
+================================================================================
+JobSystem
+
+DESCRIPTION:
+Work-stealing job scheduler. Every worker thread owns a queue, it pushes the jobs
+it spawns to the back and takes its own work from the back as well, so nested
+work stays hot in its cache. Idle workers steal the oldest jobs from the front
+of the other queues. Jobs submitted from threads that are not workers go to a
+shared queue. Workers are pinned to their own cores and sleep when there's
+nothing to do. By default two cores are left without a worker, one for the
+calling thread and one for the render thread.
+
+The thread that calls `Init` becomes worker 0. It doesn't run a worker loop,
+but `Wait` makes it execute jobs until the counter it waits on is done, which is
+how the main thread joins in on the work. When there's nothing it can run, the
+waiting thread sleeps until the counter is done or more jobs are queued.
+
+Long running work that nobody waits on within a frame, like pipeline compiles,
+cache saves or image decodes, goes to a separate background queue with
+`RunBackground`. Workers only pick it up once the other queues are empty, and
+`Wait` only helps with background jobs of the counter it waits on, so a frame
+critical wait never ends up running somebody else's long job.
+================================================================================
+*/
+class JobSystem {
+public:
+                    JobSystem();
+                    ~JobSystem();
+
+    void            Init(int numWorkers = -1);                                  // Starts the workers, -1 uses one per core not reserved for the calling and render threads.
+    void            Shutdown();                                                 // Stops the workers once they're idle.
+
+    void            Run(const Job *jobs, int count, JobCounter *counter = nullptr);  // Starts the jobs.
+    void            RunBackground(const Job *jobs, int count, JobCounter *counter = nullptr);    // Starts long running jobs at low priority.
+    void            RunAfter(JobCounter *dependency, const Job *jobs, int count,
+                             JobCounter *counter = nullptr);                    // Starts the jobs once the dependency is done.
+    void            Wait(JobCounter *counter);                                  // Executes jobs until the counter is done.
+
+    template<typename F>
+    void            ParallelFor(int count, int batchSize, const F &func);       // Calls func(begin, end) over [0, count) in batches, returns once all are done.
+
+    [[nodiscard]] int   NumThreads() const { return m_numThreads; }             // Gets the number of threads executing jobs, the calling thread included.
+    static int          WorkerIndex();                                          // Gets the index of the calling worker, -1 for other threads.
+    static int          ThreadSlot(int numThreads);                             // Gets the calling thread's slot among numThreads job threads plus a shared one.
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex              mutex;
+        std::deque<QueuedJob>   jobs;
+    };
+
+    WorkerQueue *               m_queues;                                       // One per thread, index 0 belongs to the thread that called Init.
+    WorkerQueue                 m_sharedQueue;                                  // Jobs submitted from outside the workers.
+    WorkerQueue                 m_backgroundQueue;                              // Low priority jobs, taken once the other queues are empty.
+    List<std::thread *>         m_threads;
+    int                         m_numThreads;
+
+    std::atomic<int>            m_numQueued;
+    std::atomic<bool>           m_running;
+    std::mutex                  m_sleepMutex;
+    std::condition_variable     m_sleepCv;                                      // Wakes up the sleeping workers.
+    std::condition_variable     m_waitCv;                                       // Wakes up the threads sleeping in Wait.
+    std::atomic<uint64_t>       m_numPushes;                                    // Incremented under m_sleepMutex whenever jobs are queued.
+
+    void            Start(const Job *jobs, int count, JobCounter *counter, bool background);
+    void            Push(const QueuedJob *jobs, int count);
+    bool            GetJob(int workerIndex, QueuedJob &job);
+    bool            GetBackgroundJob(const JobCounter *counter, QueuedJob &job);
+    void            Execute(const QueuedJob &job);
+    void            Finish(JobCounter *counter);
+    void            WorkerLoop(int workerIndex);
+};
+
+extern JobSystem jobSystem;
+
+/*
+================================================================================
+JobSystem::ParallelFor
+
+DESCRIPTION:
+Splits [0, count) into batches of `batchSize` and runs `func(begin, end)` for
+each of them as a job. The calling thread works on the batches too and returns
+once all of them are done, so `func` can safely reference locals.
+================================================================================
+*/
+template<typename F>
+inline void JobSystem::ParallelFor(int count, int batchSize, const F &func) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (batchSize < 1) {
+        batchSize = 1;
+    }
+
+    const int numBatches = (count + batchSize - 1) / batchSize;
+    if (numBatches == 1 || m_numThreads <= 1) {
+        func(0, count);
+        return;
+    }
+
+    struct Batch {
+        const F *       func;
+        int             begin;
+        int             end;
+    };
+
+    InlineList<Batch, 64> batches;
+    InlineList<Job, 64> jobs;
+    batches.SetSize(numBatches);
+    jobs.SetSize(numBatches);
+
+    for (int i = 0; i < numBatches; i++) {
+        batches[i].func = &func;
+        batches[i].begin = i * batchSize;
+        batches[i].end = std::min(count, (i + 1) * batchSize);
+
+        jobs[i].func = [](void *data) {
+            const auto * batch = static_cast<const Batch *>(data);
+            (*batch->func)(batch->begin, batch->end);
+        };
+        jobs[i].data = &batches[i];
+    }
+
+    JobCounter counter;
+    Run(jobs.Data(), numBatches, &counter);
+    Wait(&counter);
+}
+
+#endif //RELOAD_JOB_SYSTEM_H
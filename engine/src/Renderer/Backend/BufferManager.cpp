@@ -0,0 +1,414 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "BufferManager.h"
+
+#include <algorithm>
+#include "ConfigManager.h"
+#include "GpuTimeline.h"
+#include "StagingManager.h"
+#include "VulkanHelpers.h"
+
+BufferManager bufferManager;
+
+// Everything the shared buffers may be bound as.
+static const VkBufferUsageFlags SHARED_BUFFER_USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                                                      | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+                                                      | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+================================================================================
+BufferManager::BufferManager
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+BufferManager::BufferManager()
+        : m_ringBuffer(VK_NULL_HANDLE)
+        , m_ringAllocation(VK_NULL_HANDLE)
+        , m_ringData(nullptr)
+        , m_frameSize(0)
+        , m_uniformAlignment(UNIFORM_BUFFER_ALIGNMENT)
+        , m_frameStart(0)
+        , m_frameEnd(0)
+        , m_ringHead(0)
+        , m_numFailedDynamic(0)
+        , m_failedDynamicBytes(0) {}
+
+/*
+================================================================================
+BufferManager::~BufferManager
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+BufferManager::~BufferManager() = default;
+
+/*
+================================================================================
+BufferManager::Init
+
+DESCRIPTION:
+Creates the first static block and the persistently mapped dynamic ring.
+================================================================================
+*/
+void BufferManager::Init() {
+    CreateStaticBlock(STATIC_BUFFER_BLOCK_SIZE);
+
+    m_frameSize = static_cast<VkDeviceSize>(std::max(vkConfig.dynamicBufferSizeMB, 1u)) * 1024 * 1024;
+    m_uniformAlignment = std::max(UNIFORM_BUFFER_ALIGNMENT, vkContext.gpu.props.limits.minUniformBufferOffsetAlignment);
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = DynamicBufferSize();
+    bufferInfo.usage = SHARED_BUFFER_USAGE;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocationInfo = {};
+    VK_CHECK(vmaCreateBuffer(vmaAllocator, &bufferInfo, &allocInfo, &m_ringBuffer, &m_ringAllocation, &allocationInfo))
+    m_ringData = static_cast<char *>(allocationInfo.pMappedData);
+
+    StartFrame(0);
+}
+
+/*
+================================================================================
+BufferManager::Shutdown
+
+DESCRIPTION:
+Destroys the static blocks and the dynamic ring. Ranges still handed out are
+invalid from here on.
+================================================================================
+*/
+void BufferManager::Shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (int i = 0; i < m_blocks.Size(); i++) {
+        vmaDestroyBuffer(vmaAllocator, m_blocks[i]->buffer, m_blocks[i]->allocation);
+        delete m_blocks[i];
+    }
+    m_blocks.Clear();
+    m_retiredRanges.Clear();
+
+    vmaDestroyBuffer(vmaAllocator, m_ringBuffer, m_ringAllocation);
+    m_ringBuffer = VK_NULL_HANDLE;
+    m_ringAllocation = VK_NULL_HANDLE;
+    m_ringData = nullptr;
+}
+
+/*
+================================================================================
+BufferManager::StartFrame
+
+DESCRIPTION:
+Moves the dynamic allocations to the frame's region of the ring, and frees the
+static ranges the GPU finished with. Reports the dynamic allocations the
+previous frame ran out of space for, once per frame rather than on every one.
+================================================================================
+*/
+void BufferManager::StartFrame(uint32_t frame) {
+    const uint32_t numFailed = m_numFailedDynamic.exchange(0, std::memory_order_relaxed);
+    const VkDeviceSize failedBytes = m_failedDynamicBytes.exchange(0, std::memory_order_relaxed);
+    if (numFailed > 0) {
+        SDL_LogWarn(LOG_RENDER, "Out of dynamic buffer space, %u allocations of %llu bytes in total didn't fit the frame.",
+                    numFailed, static_cast<unsigned long long>(failedBytes));
+    }
+
+    m_frameStart = m_frameSize * frame;
+    m_frameEnd = m_frameStart + m_frameSize;
+    m_ringHead.store(m_frameStart, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CollectRetiredRanges();
+}
+
+/*
+================================================================================
+BufferManager::EndFrame
+
+DESCRIPTION:
+Flushes the dynamic data written this frame, in case the memory isn't host
+coherent. Called once the view is recorded, before the frame is submitted.
+================================================================================
+*/
+void BufferManager::EndFrame() {
+    const VkDeviceSize used = std::min(m_ringHead.load(std::memory_order_relaxed), m_frameEnd) - m_frameStart;
+    if (used > 0) {
+        vmaFlushAllocation(vmaAllocator, m_ringAllocation, m_frameStart, used);
+    }
+}
+
+/*
+================================================================================
+BufferManager::AllocStatic
+
+DESCRIPTION:
+Takes the first range that fits out of the static blocks. When none fits, a new
+block is created, of the size of the data if it's larger than a block.
+
+RETURNS:
+The device local range. Its contents are undefined until something is uploaded
+into it.
+================================================================================
+*/
+BufferAlloc BufferManager::AllocStatic(VkDeviceSize size, VkDeviceSize alignment) {
+    size = AlignUp(size, STATIC_BUFFER_ALIGNMENT);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    VkDeviceSize offset = 0;
+    int block = -1;
+
+    for (int i = 0; i < m_blocks.Size(); i++) {
+        if (AllocFromBlock(*m_blocks[i], size, alignment, offset)) {
+            block = i;
+            break;
+        }
+    }
+
+    if (block < 0) {
+        block = CreateStaticBlock(std::max(size, static_cast<VkDeviceSize>(STATIC_BUFFER_BLOCK_SIZE)));
+        AllocFromBlock(*m_blocks[block], size, alignment, offset);
+    }
+
+    BufferAlloc alloc;
+    alloc.buffer = m_blocks[block]->buffer;
+    alloc.offset = offset;
+    alloc.size = size;
+    alloc.block = block;
+
+    return alloc;
+}
+
+/*
+================================================================================
+BufferManager::UploadStatic
+
+DESCRIPTION:
+Allocates a static range and stages the data into it. The range is handed off
+to the graphics queue for vertex, index and uniform reads.
+
+RETURNS:
+The device local range.
+================================================================================
+*/
+BufferAlloc BufferManager::UploadStatic(const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+    BufferAlloc alloc = AllocStatic(size, alignment);
+
+    const auto * bytes = static_cast<const char *>(data);
+
+    stagingManager.StageChunks(static_cast<uint32_t>(size), 16, 1, [&](char *staged, uint32_t chunkOffset, uint32_t chunkSize,
+            VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+        memcpy(staged, bytes + chunkOffset, chunkSize);
+
+        VkBufferCopy copy = {};
+        copy.srcOffset = offset;
+        copy.dstOffset = alloc.offset + chunkOffset;
+        copy.size = chunkSize;
+        vkCmdCopyBuffer(commandBuffer, buffer, alloc.buffer, 1, &copy);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+        barrier.buffer = alloc.buffer;
+        barrier.offset = copy.dstOffset;
+        barrier.size = chunkSize;
+
+        stagingManager.HandOffBuffer(commandBuffer, barrier, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                                             | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                                                             | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    });
+
+    return alloc;
+}
+
+/*
+================================================================================
+BufferManager::FreeStatic
+
+DESCRIPTION:
+Gives the range back to its block once the GPU timeline reaches the value.
+================================================================================
+*/
+void BufferManager::FreeStatic(const BufferAlloc &alloc, uint64_t retireValue) {
+    if (!alloc.IsValid() || alloc.block < 0) {
+        return;
+    }
+
+    if (retireValue == 0) {
+        retireValue = gpuTimeline.PendingValue();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_retiredRanges.Push(RetiredRange{ alloc.block, FreeRange{ alloc.offset, alloc.size } }, retireValue);
+}
+
+/*
+================================================================================
+BufferManager::AllocDynamic
+
+DESCRIPTION:
+Bumps the head of the frame's region of the ring. Lock free, may be called from
+any thread while the frame is recorded.
+
+RETURNS:
+The mapped range, valid until the end of the frame. Invalid if the frame ran
+out of dynamic space, the caller has to skip whatever needed it.
+================================================================================
+*/
+BufferAlloc BufferManager::AllocDynamic(VkDeviceSize size, VkDeviceSize alignment) {
+    VkDeviceSize head = m_ringHead.load(std::memory_order_relaxed);
+    VkDeviceSize offset;
+
+    do {
+        offset = AlignUp(head, alignment);
+        if (offset + size > m_frameEnd) {
+            m_numFailedDynamic.fetch_add(1, std::memory_order_relaxed);
+            m_failedDynamicBytes.fetch_add(size, std::memory_order_relaxed);
+            return BufferAlloc();
+        }
+    } while (!m_ringHead.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    BufferAlloc alloc;
+    alloc.buffer = m_ringBuffer;
+    alloc.offset = offset;
+    alloc.size = size;
+    alloc.data = m_ringData + offset;
+
+    return alloc;
+}
+
+/*
+================================================================================
+BufferManager::CreateStaticBlock
+
+DESCRIPTION:
+Creates a device local buffer with a single free range covering all of it.
+Called with the mutex held.
+
+RETURNS:
+The index of the block.
+================================================================================
+*/
+int BufferManager::CreateStaticBlock(VkDeviceSize size) {
+    auto * block = new StaticBlock();
+    block->size = size;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = SHARED_BUFFER_USAGE | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VK_CHECK(vmaCreateBuffer(vmaAllocator, &bufferInfo, &allocInfo, &block->buffer, &block->allocation, nullptr))
+
+    block->freeRanges.Add(FreeRange{ 0, size });
+
+    return m_blocks.Add(block);
+}
+
+/*
+================================================================================
+BufferManager::AllocFromBlock
+
+DESCRIPTION:
+First fit over the free ranges of the block. The padding in front of an aligned
+range stays free.
+
+RETURNS:
+`true` and the offset of the range if it fits into the block.
+================================================================================
+*/
+bool BufferManager::AllocFromBlock(StaticBlock &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+    for (int i = 0; i < block.freeRanges.Size(); i++) {
+        FreeRange & range = block.freeRanges[i];
+
+        const VkDeviceSize aligned = AlignUp(range.offset, alignment);
+        const VkDeviceSize rangeEnd = range.offset + range.size;
+        if (aligned + size > rangeEnd) {
+            continue;
+        }
+
+        offset = aligned;
+
+        const FreeRange after = { aligned + size, rangeEnd - (aligned + size) };
+        range.size = aligned - range.offset;
+
+        if (range.size == 0 && after.size == 0) {
+            block.freeRanges.RemoveIndex(i);
+        } else if (range.size == 0) {
+            range = after;
+        } else if (after.size > 0) {
+            block.freeRanges.Insert(after, i + 1);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+================================================================================
+BufferManager::FreeToBlock
+
+DESCRIPTION:
+Puts the range back into the sorted free list of the block, merged with the
+free ranges right before and after it.
+================================================================================
+*/
+void BufferManager::FreeToBlock(StaticBlock &block, const FreeRange &range) {
+    List<FreeRange> & ranges = block.freeRanges;
+
+    int next = 0;
+    while (next < ranges.Size() && ranges[next].offset < range.offset) {
+        next++;
+    }
+
+    const bool mergePrev = next > 0 && ranges[next - 1].offset + ranges[next - 1].size == range.offset;
+    const bool mergeNext = next < ranges.Size() && range.offset + range.size == ranges[next].offset;
+
+    if (mergePrev && mergeNext) {
+        ranges[next - 1].size += range.size + ranges[next].size;
+        ranges.RemoveIndex(next);
+    } else if (mergePrev) {
+        ranges[next - 1].size += range.size;
+    } else if (mergeNext) {
+        ranges[next].offset = range.offset;
+        ranges[next].size += range.size;
+    } else {
+        ranges.Insert(range, next);
+    }
+}
+
+/*
+================================================================================
+BufferManager::CollectRetiredRanges
+
+DESCRIPTION:
+Frees the released ranges the GPU timeline passed. Called with the mutex held.
+================================================================================
+*/
+void BufferManager::CollectRetiredRanges() {
+    if (m_retiredRanges.NumPending() == 0) {
+        return;
+    }
+
+    m_retiredRanges.Collect(gpuTimeline.CompletedValue(), [this](const RetiredRange &retired) {
+        FreeToBlock(*m_blocks[retired.block], retired.range);
+    });
+}
@@ -0,0 +1,119 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_BUFFER_MANAGER_H
+#define RELOAD_BUFFER_MANAGER_H
+
+#include <atomic>
+#include <mutex>
+#include "RenderCommon.h"
+#include "RetireQueue.h"
+#include "VulkanCommon.h"
+
+// A range of one of the shared buffers. Bind `buffer` at `offset`.
+struct BufferAlloc {
+    VkBuffer            buffer = VK_NULL_HANDLE;
+    VkDeviceSize        offset = 0;
+    VkDeviceSize        size = 0;
+    int                 block = -1;                                             // Static block the range belongs to, -1 for the dynamic ring.
+    char *              data = nullptr;                                         // Mapped memory of dynamic ranges.
+
+    [[nodiscard]] bool  IsValid() const { return buffer != VK_NULL_HANDLE; }
+};
+
+/*
+================================================================================
+BufferManager
+
+DESCRIPTION:
+Hands out ranges of a few large buffers for vertex, index and uniform data, so
+meshes don't create buffers and memory of their own, and draws of different
+meshes bind the same buffer at different offsets.
+
+Static data lives in device local blocks of STATIC_BUFFER_BLOCK_SIZE, each with
+a free list of ranges sorted by offset, so freed neighbours merge back into one
+range. Data larger than a block gets a block of its own. Uploads go through the
+staging manager, which hands the range off to the graphics queue. A freed range
+is only reused once the GPU timeline passed the frames that could still read it.
+
+Dynamic data is written by the CPU every frame into a persistently mapped ring
+with one region per frame in flight, sized by dynamicBufferSizeMB of the config.
+Allocating is an atomic bump of the frame's offset, so the job workers recording
+the view can allocate concurrently. The region is reused when its frame comes
+around again, by which time the GPU is done with it.
+
+Uniform blocks are dynamic ranges aligned for dynamic uniform buffer offsets.
+The descriptor manager binds the whole ring once, so drawing with new uniforms
+is a copy into the ring and a bind with different offsets. The ring is padded by
+MAX_UBO_SIZE so a binding at the last offset of a frame stays inside the buffer.
+
+NOTE:
+AllocStatic, FreeStatic and AllocDynamic are thread safe. UploadStatic records
+into the staging manager, so it has the same restrictions.
+================================================================================
+*/
+class BufferManager {
+public:
+                    BufferManager();
+                    ~BufferManager();
+
+    void            Init();                                                     // Creates the first static block and the dynamic ring.
+    void            Shutdown();                                                 // Destroys all buffers. The GPU has to be done with them.
+
+    void            StartFrame(uint32_t frame);                                 // Starts the frame's dynamic region. The GPU has to be done with the frame.
+    void            EndFrame();                                                 // Flushes the dynamic data written this frame, before the submit.
+
+    BufferAlloc     AllocStatic(VkDeviceSize size, VkDeviceSize alignment = STATIC_BUFFER_ALIGNMENT);    // Gets a device local range.
+    BufferAlloc     UploadStatic(const void *data, VkDeviceSize size, VkDeviceSize alignment = STATIC_BUFFER_ALIGNMENT);    // Gets a device local range filled with the data.
+    void            FreeStatic(const BufferAlloc &alloc, uint64_t retireValue = 0);    // Frees the range once the GPU timeline reaches the value, 0 for the pending one.
+
+    BufferAlloc     AllocDynamic(VkDeviceSize size, VkDeviceSize alignment);    // Gets a mapped range valid for the current frame. Invalid if the frame is out of space.
+    BufferAlloc     AllocUniform(VkDeviceSize size) { return AllocDynamic(size, m_uniformAlignment); }    // Gets a dynamic range usable as a dynamic uniform buffer offset.
+
+    [[nodiscard]] VkBuffer      DynamicBuffer() const { return m_ringBuffer; }
+    [[nodiscard]] VkDeviceSize  DynamicBufferSize() const { return m_frameSize * MAX_FRAMES_IN_FLIGHT + MAX_UBO_SIZE; }
+    [[nodiscard]] VkDeviceSize  DynamicUsed() const { return m_ringHead.load(std::memory_order_relaxed) - m_frameStart; }
+
+private:
+    struct FreeRange {
+        VkDeviceSize        offset;
+        VkDeviceSize        size;
+    };
+
+    struct StaticBlock {
+        VkBuffer            buffer = VK_NULL_HANDLE;
+        VmaAllocation       allocation = VK_NULL_HANDLE;
+        VkDeviceSize        size = 0;
+        List<FreeRange>     freeRanges;                                         // Sorted by offset, never adjacent.
+    };
+
+    struct RetiredRange {
+        int                 block;
+        FreeRange           range;
+    };
+
+    int             CreateStaticBlock(VkDeviceSize size);                       // Returns the index of the new block.
+    static bool     AllocFromBlock(StaticBlock &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+    static void     FreeToBlock(StaticBlock &block, const FreeRange &range);
+    void            CollectRetiredRanges();                                     // Frees the ranges the GPU is done with.
+
+    std::mutex              m_mutex;                                            // Guards the static blocks and the retired ranges.
+    List<StaticBlock *>     m_blocks;
+    RetireQueue<RetiredRange> m_retiredRanges;                                  // Freed ranges the GPU may still read.
+
+    VkBuffer                m_ringBuffer;
+    VmaAllocation           m_ringAllocation;
+    char *                  m_ringData;
+    VkDeviceSize            m_frameSize;                                        // Size of each frame's region.
+    VkDeviceSize            m_uniformAlignment;                                 // UNIFORM_BUFFER_ALIGNMENT, or more if the device needs it.
+    VkDeviceSize            m_frameStart;                                       // Start of the current frame's region.
+    VkDeviceSize            m_frameEnd;
+    std::atomic<VkDeviceSize>   m_ringHead;                                     // Next free byte of the frame's region.
+    std::atomic<uint32_t>       m_numFailedDynamic;                             // Dynamic allocations that didn't fit the frame, logged by StartFrame.
+    std::atomic<VkDeviceSize>   m_failedDynamicBytes;
+};
+
+extern BufferManager bufferManager;
+
+#endif //RELOAD_BUFFER_MANAGER_H
@@ -0,0 +1,127 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "CommandPools.h"
+
+#include "VulkanHelpers.h"
+#include "ReloadLib/sys/JobSystem.h"
+
+/*
+================================================================================
+CommandPools::CommandPools
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+CommandPools::CommandPools() : m_pools(nullptr), m_numThreads(0) {}
+
+/*
+================================================================================
+CommandPools::~CommandPools
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+CommandPools::~CommandPools() = default;
+
+/*
+================================================================================
+CommandPools::Init
+
+DESCRIPTION:
+Creates a transient pool per job thread and frame in flight, plus the ones used
+by threads outside the job system. The buffers are allocated on demand.
+================================================================================
+*/
+void CommandPools::Init(uint32_t queueFamilyIdx, int numThreads) {
+    m_numThreads = numThreads + 1;
+    m_pools = new ThreadPool[static_cast<size_t>(m_numThreads) * MAX_FRAMES_IN_FLIGHT];
+
+    VkCommandPoolCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    createInfo.queueFamilyIndex = queueFamilyIdx;
+
+    for (int i = 0; i < m_numThreads * static_cast<int>(MAX_FRAMES_IN_FLIGHT); i++) {
+        VK_CHECK(vkCreateCommandPool(vkContext.device, &createInfo, nullptr, &m_pools[i].pool))
+    }
+}
+
+/*
+================================================================================
+CommandPools::Shutdown
+
+DESCRIPTION:
+Destroys the pools, which frees their buffers as well.
+================================================================================
+*/
+void CommandPools::Shutdown() {
+    if (m_pools == nullptr) {
+        return;
+    }
+
+    for (int i = 0; i < m_numThreads * static_cast<int>(MAX_FRAMES_IN_FLIGHT); i++) {
+        vkDestroyCommandPool(vkContext.device, m_pools[i].pool, nullptr);
+    }
+
+    delete[] m_pools;
+    m_pools = nullptr;
+    m_numThreads = 0;
+}
+
+/*
+================================================================================
+CommandPools::Reset
+
+DESCRIPTION:
+Resets the pools of all the threads for the frame. Resetting the whole pool is
+cheaper than resetting the buffers one by one, and keeps them allocated for the
+next time the frame comes around.
+================================================================================
+*/
+void CommandPools::Reset(uint32_t frame) {
+    for (int i = 0; i < m_numThreads; i++) {
+        ThreadPool & threadPool = m_pools[static_cast<uint32_t>(i) * MAX_FRAMES_IN_FLIGHT + frame];
+        if (threadPool.numUsed == 0) {
+            continue;
+        }
+
+        VK_CHECK(vkResetCommandPool(vkContext.device, threadPool.pool, 0))
+        threadPool.numUsed = 0;
+    }
+}
+
+/*
+================================================================================
+CommandPools::AllocSecondary
+
+DESCRIPTION:
+Hands out the next free secondary buffer of the calling thread's pool for the
+frame, allocating a new one when all of them are in use.
+
+RETURNS:
+A reset secondary command buffer, ready to begin recording.
+================================================================================
+*/
+VkCommandBuffer CommandPools::AllocSecondary(uint32_t frame) {
+    const int thread = JobSystem::ThreadSlot(m_numThreads - 1);
+
+    ThreadPool & threadPool = m_pools[static_cast<uint32_t>(thread) * MAX_FRAMES_IN_FLIGHT + frame];
+
+    if (threadPool.numUsed == threadPool.buffers.Size()) {
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocateInfo.commandPool = threadPool.pool;
+        allocateInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VK_CHECK(vkAllocateCommandBuffers(vkContext.device, &allocateInfo, &commandBuffer))
+        threadPool.buffers.Add(commandBuffer);
+    }
+
+    return threadPool.buffers[threadPool.numUsed++];
+}
@@ -0,0 +1,49 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_COMMAND_POOLS_H
+#define RELOAD_COMMAND_POOLS_H
+
+#include "RenderCommon.h"
+#include "VulkanCommon.h"
+
+/*
+================================================================================
+CommandPools
+
+DESCRIPTION:
+Secondary command buffers for recording on several threads at once. Command
+pools can't be used from two threads at the same time, so every job worker gets
+its own pool per frame in flight and only ever allocates from that one. The
+buffers of a frame are reset together with their pools once the GPU is done with
+the frame, and reused afterwards.
+
+NOTE:
+Threads that are not job workers share one extra pool, so only one of them may
+record at a time.
+================================================================================
+*/
+class CommandPools {
+public:
+                        CommandPools();
+                        ~CommandPools();
+
+    void                Init(uint32_t queueFamilyIdx, int numThreads);          // Creates the pools for the given number of job threads.
+    void                Shutdown();                                             // Destroys the pools and their buffers.
+
+    void                Reset(uint32_t frame);                                  // Resets the pools of the frame. The GPU has to be done with it.
+    VkCommandBuffer     AllocSecondary(uint32_t frame);                         // Gets a secondary buffer from the pool of the calling thread.
+
+private:
+    struct alignas(64) ThreadPool {
+        VkCommandPool           pool = VK_NULL_HANDLE;
+        List<VkCommandBuffer>   buffers;                                        // Allocated secondary buffers, reused across frames.
+        int                     numUsed = 0;                                    // Buffers handed out since the last reset.
+    };
+
+    ThreadPool *        m_pools;                                                // [thread * MAX_FRAMES_IN_FLIGHT + frame]
+    int                 m_numThreads;                                           // Job threads, plus one slot for the other threads.
+};
+
+#endif //RELOAD_COMMAND_POOLS_H
@@ -0,0 +1,213 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "DeferredDelete.h"
+
+#include "GpuTimeline.h"
+#include "VulkanMemory.h"
+
+DeferredDelete deferredDelete;
+
+// Objects taken out of the queue at a time, the clock is checked after each batch.
+static const int DEFERRED_DELETE_BATCH = 16;
+
+// Non-dispatchable handles are pointers on 64-bit platforms and plain integers
+// elsewhere, the C style cast handles both.
+template<typename T>
+static uint64_t ToHandle(T handle) { return (uint64_t)handle; }
+
+template<typename T>
+static T FromHandle(uint64_t handle) { return (T)handle; }
+
+/*
+================================================================================
+DeferredDelete::DeferredDelete
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+DeferredDelete::DeferredDelete() = default;
+
+/*
+================================================================================
+DeferredDelete::~DeferredDelete
+
+DESCRIPTION:
+The default destructor. Everything has to be flushed while the device exists.
+================================================================================
+*/
+DeferredDelete::~DeferredDelete() = default;
+
+/*
+================================================================================
+DeferredDelete::Release*
+
+DESCRIPTION:
+Queue the object for destruction once the GPU timeline reaches `retireValue`,
+0 stands for the value of the frame being recorded, see GpuTimeline::PendingValue.
+================================================================================
+*/
+void DeferredDelete::ReleaseBuffer(VkBuffer buffer, VmaAllocation allocation, uint64_t retireValue) {
+    Release(DEFERRED_BUFFER, ToHandle(buffer), ToHandle(allocation), retireValue);
+}
+
+void DeferredDelete::ReleaseImage(VkImage image, VmaAllocation allocation, uint64_t retireValue) {
+    Release(DEFERRED_IMAGE, ToHandle(image), ToHandle(allocation), retireValue);
+}
+
+void DeferredDelete::ReleaseImageView(VkImageView view, uint64_t retireValue) {
+    Release(DEFERRED_IMAGE_VIEW, ToHandle(view), 0, retireValue);
+}
+
+void DeferredDelete::ReleaseSampler(VkSampler sampler, uint64_t retireValue) {
+    Release(DEFERRED_SAMPLER, ToHandle(sampler), 0, retireValue);
+}
+
+void DeferredDelete::ReleaseFramebuffer(VkFramebuffer framebuffer, uint64_t retireValue) {
+    Release(DEFERRED_FRAMEBUFFER, ToHandle(framebuffer), 0, retireValue);
+}
+
+void DeferredDelete::ReleasePipeline(VkPipeline pipeline, uint64_t retireValue) {
+    Release(DEFERRED_PIPELINE, ToHandle(pipeline), 0, retireValue);
+}
+
+void DeferredDelete::ReleaseDescriptorSet(VkDescriptorPool pool, VkDescriptorSet set, uint64_t retireValue) {
+    Release(DEFERRED_DESCRIPTOR_SET, ToHandle(set), ToHandle(pool), retireValue);
+}
+
+void DeferredDelete::ReleaseAllocation(VmaAllocation allocation, uint64_t retireValue) {
+    Release(DEFERRED_ALLOCATION, ToHandle(allocation), 0, retireValue);
+}
+
+/*
+================================================================================
+DeferredDelete::Release
+
+DESCRIPTION:
+Appends the object to the queue. Null handles are ignored.
+================================================================================
+*/
+void DeferredDelete::Release(DeferredType type, uint64_t handle, uint64_t owner, uint64_t retireValue) {
+    if (handle == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Read under the lock, so the default values are in order as well.
+    if (retireValue == 0) {
+        retireValue = gpuTimeline.PendingValue();
+    }
+
+    m_objects.Push(DeferredObject{type, handle, owner}, retireValue);
+}
+
+/*
+================================================================================
+DeferredDelete::Collect
+
+DESCRIPTION:
+Destroys the objects at the front of the queue the GPU is done with, in batches
+taken out under the lock so the releasing threads aren't blocked by the actual
+destruction. Stops once the budget is used up, at least one batch is destroyed
+per call so the queue always drains.
+================================================================================
+*/
+void DeferredDelete::Collect(uint64_t budgetMicroSec) {
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t start = SDL_GetPerformanceCounter();
+    const uint64_t budget = budgetMicroSec * frequency / 1000000;
+
+    const uint64_t completed = gpuTimeline.CompletedValue();
+
+    DeferredObject batch[DEFERRED_DELETE_BATCH];
+    while (true) {
+        int numBatch = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_objects.Collect(completed, [&](const DeferredObject &object) {
+                batch[numBatch++] = object;
+            }, DEFERRED_DELETE_BATCH);
+        }
+
+        for (int i = 0; i < numBatch; i++) {
+            Destroy(batch[i]);
+        }
+
+        if (numBatch < DEFERRED_DELETE_BATCH || SDL_GetPerformanceCounter() - start >= budget) {
+            return;
+        }
+    }
+}
+
+/*
+================================================================================
+DeferredDelete::Flush
+
+DESCRIPTION:
+Waits until the GPU is done with everything submitted and destroys all the
+queued objects, used before the device goes away.
+================================================================================
+*/
+void DeferredDelete::Flush() {
+    gpuTimeline.Wait(gpuTimeline.SubmittedValue());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_objects.Flush(Destroy);
+}
+
+/*
+================================================================================
+DeferredDelete::NumPending
+
+RETURNS:
+The number of objects waiting to be destroyed.
+================================================================================
+*/
+int DeferredDelete::NumPending() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_objects.NumPending();
+}
+
+/*
+================================================================================
+DeferredDelete::Destroy
+
+DESCRIPTION:
+Destroys the object with the function matching its type.
+================================================================================
+*/
+void DeferredDelete::Destroy(const DeferredObject &object) {
+    switch (object.type) {
+        case DEFERRED_BUFFER:
+            vmaDestroyBuffer(vmaAllocator, FromHandle<VkBuffer>(object.handle), FromHandle<VmaAllocation>(object.owner));
+            break;
+        case DEFERRED_IMAGE:
+            vmaDestroyImage(vmaAllocator, FromHandle<VkImage>(object.handle), FromHandle<VmaAllocation>(object.owner));
+            break;
+        case DEFERRED_IMAGE_VIEW:
+            vkDestroyImageView(vkContext.device, FromHandle<VkImageView>(object.handle), nullptr);
+            break;
+        case DEFERRED_SAMPLER:
+            vkDestroySampler(vkContext.device, FromHandle<VkSampler>(object.handle), nullptr);
+            break;
+        case DEFERRED_FRAMEBUFFER:
+            vkDestroyFramebuffer(vkContext.device, FromHandle<VkFramebuffer>(object.handle), nullptr);
+            break;
+        case DEFERRED_PIPELINE:
+            vkDestroyPipeline(vkContext.device, FromHandle<VkPipeline>(object.handle), nullptr);
+            break;
+        case DEFERRED_DESCRIPTOR_SET: {
+            VkDescriptorSet set = FromHandle<VkDescriptorSet>(object.handle);
+            vkFreeDescriptorSets(vkContext.device, FromHandle<VkDescriptorPool>(object.owner), 1, &set);
+            break;
+        }
+        case DEFERRED_ALLOCATION:
+            vmaFreeMemory(vmaAllocator, FromHandle<VmaAllocation>(object.handle));
+            break;
+    }
+}
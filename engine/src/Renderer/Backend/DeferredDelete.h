@@ -0,0 +1,80 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_DEFERRED_DELETE_H
+#define RELOAD_DEFERRED_DELETE_H
+
+#include <mutex>
+#include "RenderCommon.h"
+#include "RetireQueue.h"
+#include "VulkanCommon.h"
+
+typedef enum {
+    DEFERRED_BUFFER,                                                            // VkBuffer and its VmaAllocation.
+    DEFERRED_IMAGE,                                                             // VkImage and its VmaAllocation.
+    DEFERRED_IMAGE_VIEW,
+    DEFERRED_SAMPLER,
+    DEFERRED_FRAMEBUFFER,
+    DEFERRED_PIPELINE,
+    DEFERRED_DESCRIPTOR_SET,                                                    // VkDescriptorSet and the VkDescriptorPool it came from.
+    DEFERRED_ALLOCATION                                                         // VmaAllocation without a resource bound to it.
+} DeferredType;
+
+// A released object waiting for the GPU timeline to reach its value.
+struct DeferredObject {
+    DeferredType        type;
+    uint64_t            handle;                                                 // The Vulkan handle, or the allocation.
+    uint64_t            owner;                                                  // Allocation of a buffer or image, pool of a descriptor set.
+};
+
+/*
+================================================================================
+DeferredDelete
+
+DESCRIPTION:
+Queue of Vulkan objects that were released while the GPU may still use them.
+Each object is tagged with a GPU timeline value and destroyed by `Collect` once
+the timeline reaches it. By default that's `GpuTimeline::PendingValue`, the
+value of the frame being recorded. It covers the frame's command buffers and
+everything in flight, submissions made in the middle of the frame signal lower
+values and don't retire the object.
+
+Collect runs once per frame on the render thread with a time budget, so
+releasing a whole level doesn't stall a single frame. Whatever doesn't fit the
+budget is picked up by the next frames.
+
+NOTE:
+Thread safe, objects may be released from any thread.
+================================================================================
+*/
+class DeferredDelete {
+public:
+                    DeferredDelete();
+                    ~DeferredDelete();
+
+    void            ReleaseBuffer(VkBuffer buffer, VmaAllocation allocation, uint64_t retireValue = 0);
+    void            ReleaseImage(VkImage image, VmaAllocation allocation, uint64_t retireValue = 0);
+    void            ReleaseImageView(VkImageView view, uint64_t retireValue = 0);
+    void            ReleaseSampler(VkSampler sampler, uint64_t retireValue = 0);
+    void            ReleaseFramebuffer(VkFramebuffer framebuffer, uint64_t retireValue = 0);
+    void            ReleasePipeline(VkPipeline pipeline, uint64_t retireValue = 0);
+    void            ReleaseDescriptorSet(VkDescriptorPool pool, VkDescriptorSet set, uint64_t retireValue = 0);
+    void            ReleaseAllocation(VmaAllocation allocation, uint64_t retireValue = 0);
+
+    void            Collect(uint64_t budgetMicroSec = DEFERRED_DELETE_BUDGET_USEC);  // Destroys the objects the GPU is done with, within the time budget.
+    void            Flush();                                                    // Waits for the GPU and destroys everything.
+
+    [[nodiscard]] int   NumPending();                                           // Gets the number of objects waiting to be destroyed.
+
+private:
+    void            Release(DeferredType type, uint64_t handle, uint64_t owner, uint64_t retireValue);
+    static void     Destroy(const DeferredObject &object);
+
+    std::mutex              m_mutex;                                            // Guards the queue.
+    RetireQueue<DeferredObject> m_objects;
+};
+
+extern DeferredDelete deferredDelete;
+
+#endif //RELOAD_DEFERRED_DELETE_H
@@ -0,0 +1,209 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Defragmenter.h"
+
+#include "DeferredDelete.h"
+#include "GpuTimeline.h"
+#include "ImageManager.h"
+#include "VulkanHelpers.h"
+
+Defragmenter defragmenter;
+
+/*
+================================================================================
+Defragmenter::Defragmenter
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+Defragmenter::Defragmenter()
+        : m_context(VK_NULL_HANDLE)
+        , m_passValue(0)
+        , m_idleFrames(0) {}
+
+/*
+================================================================================
+Defragmenter::~Defragmenter
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+Defragmenter::~Defragmenter() = default;
+
+/*
+================================================================================
+Defragmenter::Shutdown
+
+DESCRIPTION:
+Ends the running pass, if any, before the allocator goes away.
+================================================================================
+*/
+void Defragmenter::Shutdown() {
+    if (m_context != VK_NULL_HANDLE) {
+        EndPass();
+    }
+
+    m_images.Clear();
+    m_allocations.Clear();
+    m_released.Clear();
+    m_idleFrames = 0;
+}
+
+/*
+================================================================================
+Defragmenter::Update
+
+DESCRIPTION:
+Called once per frame with the frame's command buffer, outside of the render
+pass. The running pass is ended once the GPU is done with the frame it recorded
+its copies into. Otherwise, unless idle, the next pass is started.
+================================================================================
+*/
+void Defragmenter::Update(VkCommandBuffer commandBuffer) {
+    if (m_context != VK_NULL_HANDLE) {
+        if (!gpuTimeline.IsComplete(m_passValue)) {
+            return;
+        }
+
+        EndPass();
+    }
+
+    if (m_idleFrames > 0) {
+        m_idleFrames--;
+        return;
+    }
+
+    if (!BeginPass(commandBuffer)) {
+        m_idleFrames = DEFRAG_IDLE_FRAMES;
+    }
+}
+
+/*
+================================================================================
+Defragmenter::Release
+
+DESCRIPTION:
+Takes over the allocation of an image purged while the pass is running. A move
+planned for it is skipped, and the allocation is freed when the pass ends.
+================================================================================
+*/
+void Defragmenter::Release(VmaAllocation allocation) {
+    vmaSetAllocationUserData(vmaAllocator, allocation, nullptr);
+    m_released.Add(allocation);
+}
+
+/*
+================================================================================
+Defragmenter::BeginPass
+
+DESCRIPTION:
+Hands the allocations of the movable images to VMA, and records the copies of
+the moves it plans into the command buffer. The image of an allocation is kept
+in its user data.
+
+RETURNS:
+`false` if nothing was moved.
+================================================================================
+*/
+bool Defragmenter::BeginPass(VkCommandBuffer commandBuffer) {
+    {
+        std::lock_guard<std::mutex> lock(globalImages->m_mutex);
+
+        for (auto & imageMap : globalImages->m_images) {
+            Image * image = imageMap.value;
+            if (image->IsMovable()) {
+                m_images.Add(image);
+                m_allocations.Add(image->m_allocation);
+            }
+        }
+    }
+
+    if (m_images.Size() == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < m_images.Size(); i++) {
+        vmaSetAllocationUserData(vmaAllocator, m_allocations[i], m_images[i]);
+        m_images[i]->m_defragmenting = true;
+    }
+
+    VmaDefragmentationInfo2 info = {};
+    info.flags = VMA_DEFRAGMENTATION_FLAG_INCREMENTAL;
+    info.allocationCount = static_cast<uint32_t>(m_allocations.Size());
+    info.pAllocations = m_allocations.Data();
+    info.maxGpuBytesToMove = DEFRAG_BYTES_PER_PASS;
+    info.maxGpuAllocationsToMove = DEFRAG_MOVES_PER_PASS;
+
+    const VkResult result = vmaDefragmentationBegin(vmaAllocator, &info, nullptr, &m_context);
+    if (result < VK_SUCCESS || m_context == VK_NULL_HANDLE) {
+        SDL_LogWarn(LOG_RENDER, "Failed to start defragmentation: %s", VkErrorToString(result));
+        EndPass();
+        return false;
+    }
+
+    VmaDefragmentationPassMoveInfo moves[DEFRAG_MOVES_PER_PASS];
+    VmaDefragmentationPassInfo passInfo = {};
+    passInfo.moveCount = DEFRAG_MOVES_PER_PASS;
+    passInfo.pMoves = moves;
+
+    VK_CHECK(vmaBeginDefragmentationPass(vmaAllocator, m_context, &passInfo))
+
+    if (passInfo.moveCount == 0) {
+        EndPass();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < passInfo.moveCount; i++) {
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(vmaAllocator, moves[i].allocation, &allocationInfo);
+
+        auto * image = static_cast<Image *>(allocationInfo.pUserData);
+        if (image != nullptr) {
+            image->Move(commandBuffer, moves[i].memory, moves[i].offset);
+        }
+    }
+
+    // The copies are part of the frame, they're done with it.
+    m_passValue = gpuTimeline.PendingValue();
+
+    return true;
+}
+
+/*
+================================================================================
+Defragmenter::EndPass
+
+DESCRIPTION:
+Lets VMA commit the moves, which frees the old memory and re-points the
+allocations, then frees the allocations released during the pass. The GPU has
+to be done with the copies and the old images.
+================================================================================
+*/
+void Defragmenter::EndPass() {
+    if (m_context != VK_NULL_HANDLE) {
+        vmaEndDefragmentationPass(vmaAllocator, m_context);
+        vmaDefragmentationEnd(vmaAllocator, m_context);
+        m_context = VK_NULL_HANDLE;
+    }
+
+    for (int i = 0; i < m_images.Size(); i++) {
+        Image * image = m_images[i];
+        if (image->m_defragmenting) {
+            vmaSetAllocationUserData(vmaAllocator, image->m_allocation, nullptr);
+            image->m_defragmenting = false;
+        }
+    }
+
+    for (int i = 0; i < m_released.Size(); i++) {
+        deferredDelete.ReleaseAllocation(m_released[i]);
+    }
+
+    m_images.SetSize(0);
+    m_allocations.SetSize(0);
+    m_released.SetSize(0);
+    m_passValue = 0;
+}
@@ -0,0 +1,68 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_DEFRAGMENTER_H
+#define RELOAD_DEFRAGMENTER_H
+
+#include "RenderCommon.h"
+#include "VulkanCommon.h"
+#include "VulkanMemory.h"
+
+class Image;
+
+/*
+================================================================================
+Defragmenter
+
+DESCRIPTION:
+Compacts the device memory of the images a little at a time, so long sessions
+that keep loading and purging images don't end up with memory too fragmented to
+allocate from.
+
+Every pass asks VMA for a plan that moves at most DEFRAG_BYTES_PER_PASS of the
+movable images. The moved images are copied on the frame's command buffer ahead
+of its draws, and swap their handles and bindless slots right away. Frames in
+flight keep sampling the old images, which go through the deferred delete queue.
+The pass ends once the GPU timeline passes the frame with the copies. Only then
+does VMA free the old memory and re-point the allocations. A pass that finds
+nothing to move puts off the next one for DEFRAG_IDLE_FRAMES.
+
+VMA doesn't allow freeing the allocations of a running pass, so images purged in
+the meantime leave their allocation to the defragmenter, which frees it once the
+pass ends.
+
+NOTE:
+Only used from the render thread. The image registry is locked while the
+movable images are gathered, since images are created from any thread.
+================================================================================
+*/
+class Defragmenter {
+public:
+                    Defragmenter();
+                    ~Defragmenter();
+
+    void            Shutdown();                                                 // Ends the running pass. The GPU has to be done with it.
+
+    void            Update(VkCommandBuffer commandBuffer);                      // Ends the pass the GPU finished, or records the copies of the next one.
+    void            Release(VmaAllocation allocation);                          // Frees an allocation of the running pass once it ends.
+    void            Wake() { m_idleFrames = 0; }                                // Starts the next pass on the next update, e.g. after memory was freed.
+
+    [[nodiscard]] bool  IsRunning() const { return m_context != VK_NULL_HANDLE; }
+    [[nodiscard]] bool  IsIdle() const { return m_idleFrames > 0; }             // The last pass found nothing to move.
+
+private:
+    bool            BeginPass(VkCommandBuffer commandBuffer);                   // Returns false if there was nothing to move.
+    void            EndPass();
+
+    VmaDefragmentationContext   m_context;
+    List<Image *>               m_images;                                       // Images the pass may move.
+    List<VmaAllocation>         m_allocations;
+    List<VmaAllocation>         m_released;                                     // Purged while the pass was running.
+    uint64_t                    m_passValue;                                    // Timeline value of the frame with the copies.
+    int                         m_idleFrames;
+};
+
+extern Defragmenter defragmenter;
+
+#endif //RELOAD_DEFRAGMENTER_H
@@ -0,0 +1,429 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "DescriptorManager.h"
+
+#include <algorithm>
+#include "BufferManager.h"
+#include "GpuTimeline.h"
+#include "VulkanHelpers.h"
+
+DescriptorManager descriptorManager;
+
+static const uint32_t NUM_SAMPLER_REPEATS = 4;                                  // TR_REPEAT to TR_CLAMP_TO_ZERO_ALPHA.
+static const uint32_t MAX_ANISOTROPY = 8;
+
+/*
+================================================================================
+DescriptorManager::DescriptorManager
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+DescriptorManager::DescriptorManager()
+        : m_samplers{}
+        , m_bindlessLayout(VK_NULL_HANDLE)
+        , m_bindlessPool(VK_NULL_HANDLE)
+        , m_bindlessSet(VK_NULL_HANDLE)
+        , m_maxImages(0)
+        , m_uniformLayout(VK_NULL_HANDLE)
+        , m_uniformPool(VK_NULL_HANDLE)
+        , m_uniformSet(VK_NULL_HANDLE)
+        , m_numSlots(0) {}
+
+/*
+================================================================================
+DescriptorManager::~DescriptorManager
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+DescriptorManager::~DescriptorManager() = default;
+
+/*
+================================================================================
+DescriptorManager::Init
+
+DESCRIPTION:
+Creates the samplers and the bindless and uniform sets. The buffer manager has
+to be initialized first.
+================================================================================
+*/
+void DescriptorManager::Init() {
+    CreateSamplers();
+    CreateBindlessSet();
+    CreateUniformSet();
+
+    SDL_LogInfo(LOG_RENDER, "Bindless descriptor set with %u images.", m_maxImages);
+}
+
+/*
+================================================================================
+DescriptorManager::Shutdown
+
+DESCRIPTION:
+Destroys the bindless and uniform sets and the samplers. Destroying the pools
+frees their sets as well.
+================================================================================
+*/
+void DescriptorManager::Shutdown() {
+    vkDestroyDescriptorPool(vkContext.device, m_uniformPool, nullptr);
+    vkDestroyDescriptorSetLayout(vkContext.device, m_uniformLayout, nullptr);
+    m_uniformPool = VK_NULL_HANDLE;
+    m_uniformLayout = VK_NULL_HANDLE;
+    m_uniformSet = VK_NULL_HANDLE;
+
+    vkDestroyDescriptorPool(vkContext.device, m_bindlessPool, nullptr);
+    vkDestroyDescriptorSetLayout(vkContext.device, m_bindlessLayout, nullptr);
+    m_bindlessPool = VK_NULL_HANDLE;
+    m_bindlessLayout = VK_NULL_HANDLE;
+    m_bindlessSet = VK_NULL_HANDLE;
+
+    for (VkSampler & sampler : m_samplers) {
+        vkDestroySampler(vkContext.device, sampler, nullptr);
+        sampler = VK_NULL_HANDLE;
+    }
+
+    m_numSlots = 0;
+    m_freeSlots.Clear();
+    m_retiredSlots.Clear();
+}
+
+/*
+================================================================================
+DescriptorManager::RegisterImage
+
+DESCRIPTION:
+Takes a free slot of the bindless image array and writes the view into it.
+Slots released earlier are reused once the GPU is done with them, new slots are
+handed out while the array has room. If it's full, waits for the oldest
+released slot, but only once the frame retiring it was submitted, and never
+with the mutex held, so other threads keep registering and releasing.
+
+RETURNS:
+The bindless index of the image, BINDLESS_INVALID_INDEX if every slot is in use
+or retired by a frame that wasn't submitted yet.
+================================================================================
+*/
+uint32_t DescriptorManager::RegisterImage(VkImageView view, VkImageLayout layout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    uint32_t index;
+    for (;;) {
+        CollectRetiredSlots();
+
+        if (m_freeSlots.Size() > 0) {
+            index = m_freeSlots[m_freeSlots.Size() - 1];
+            m_freeSlots.SetSize(m_freeSlots.Size() - 1);
+            break;
+        }
+
+        if (m_numSlots < m_maxImages) {
+            index = m_numSlots++;
+            break;
+        }
+
+        // Waiting for a value that wasn't submitted would never return.
+        const uint64_t retireValue = m_retiredSlots.FrontValue();
+        if (retireValue == 0 || retireValue > gpuTimeline.SubmittedValue()) {
+            SDL_LogError(LOG_RENDER, "All %u bindless image slots are in use.", m_maxImages);
+            return BINDLESS_INVALID_INDEX;
+        }
+
+        lock.unlock();
+        gpuTimeline.Wait(retireValue);
+        lock.lock();
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_bindlessSet;
+    write.dstBinding = 0;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(vkContext.device, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+/*
+================================================================================
+DescriptorManager::ReleaseImage
+
+DESCRIPTION:
+Gives the slot back once the GPU timeline reaches the value. The descriptor is
+left as it is, the view may only be destroyed by then as well.
+================================================================================
+*/
+void DescriptorManager::ReleaseImage(uint32_t index, uint64_t retireValue) {
+    if (retireValue == 0) {
+        retireValue = gpuTimeline.PendingValue();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_retiredSlots.Push(index, retireValue);
+}
+
+/*
+================================================================================
+DescriptorManager::BindBindless
+
+DESCRIPTION:
+Binds the bindless set as set 0 of the layout. All the pipelines share a layout
+starting with it, so once per command buffer is enough.
+================================================================================
+*/
+void DescriptorManager::BindBindless(VkCommandBuffer commandBuffer, VkPipelineLayout layout) const {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &m_bindlessSet, 0, nullptr);
+}
+
+/*
+================================================================================
+DescriptorManager::BindUniforms
+
+DESCRIPTION:
+Binds the uniform set as set 1 of the layout, with the offsets of the UBO parms
+in the dynamic ring. Nothing is allocated or written, so it's cheap enough to
+call for every draw.
+================================================================================
+*/
+void DescriptorManager::BindUniforms(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const uint32_t offsets[MAX_UBO_PARMS]) const {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &m_uniformSet, MAX_UBO_PARMS, offsets);
+}
+
+/*
+================================================================================
+DescriptorManager::SamplerIndex
+
+RETURNS:
+The index into the sampler array of the bindless set for the modes. TF_DEFAULT
+samples linearly.
+================================================================================
+*/
+uint32_t DescriptorManager::SamplerIndex(TextureFilter filter, TextureRepeat repeat) {
+    const uint32_t filterIndex = filter == TF_NEAREST ? 1 : 0;
+    return filterIndex * NUM_SAMPLER_REPEATS + static_cast<uint32_t>(repeat);
+}
+
+/*
+================================================================================
+DescriptorManager::CreateSamplers
+
+DESCRIPTION:
+Creates the immutable samplers of the bindless set, laid out as SamplerIndex
+expects. Linear filtering is anisotropic where the device supports it.
+================================================================================
+*/
+void DescriptorManager::CreateSamplers() {
+    const bool anisotropy = vkContext.gpu.features.samplerAnisotropy == VK_TRUE;
+    const float maxAnisotropy = std::min(static_cast<float>(MAX_ANISOTROPY),
+                                         vkContext.gpu.props.limits.maxSamplerAnisotropy);
+
+    const TextureFilter filters[] = { TF_LINEAR, TF_NEAREST };
+    const TextureRepeat repeats[] = { TR_REPEAT, TR_CLAMP, TR_CLAMP_TO_ZERO, TR_CLAMP_TO_ZERO_ALPHA };
+
+    for (TextureFilter filter : filters) {
+        for (TextureRepeat repeat : repeats) {
+            VkSamplerCreateInfo createInfo = {};
+            createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+            createInfo.magFilter = filter == TF_NEAREST ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+            createInfo.minFilter = createInfo.magFilter;
+            createInfo.mipmapMode = filter == TF_NEAREST ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            createInfo.anisotropyEnable = (anisotropy && filter == TF_LINEAR) ? VK_TRUE : VK_FALSE;
+            createInfo.maxAnisotropy = createInfo.anisotropyEnable ? maxAnisotropy : 1.0f;
+            createInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+            VkSamplerAddressMode addressMode;
+            switch (repeat) {
+                case TR_CLAMP:
+                    addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                    break;
+                case TR_CLAMP_TO_ZERO:
+                    addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+                    createInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+                    break;
+                case TR_CLAMP_TO_ZERO_ALPHA:
+                    addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+                    createInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+                    break;
+                default:
+                    addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+                    break;
+            }
+
+            createInfo.addressModeU = addressMode;
+            createInfo.addressModeV = addressMode;
+            createInfo.addressModeW = addressMode;
+
+            VK_CHECK(vkCreateSampler(vkContext.device, &createInfo, nullptr, &m_samplers[SamplerIndex(filter, repeat)]))
+        }
+    }
+}
+
+/*
+================================================================================
+DescriptorManager::CreateBindlessSet
+
+DESCRIPTION:
+Creates the layout, pool and the one bindless set. Binding 0 is the partially
+bound image array, binding 1 the immutable samplers.
+================================================================================
+*/
+void DescriptorManager::CreateBindlessSet() {
+    const VkPhysicalDeviceDescriptorIndexingPropertiesEXT & props = vkContext.gpu.descriptorIndexingProps;
+    m_maxImages = std::min({
+            MAX_BINDLESS_IMAGES,
+            props.maxDescriptorSetUpdateAfterBindSampledImages,
+            props.maxPerStageDescriptorUpdateAfterBindSampledImages
+    });
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = m_maxImages;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[1].descriptorCount = NUM_BINDLESS_SAMPLERS;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+    bindings[1].pImmutableSamplers = m_samplers;
+
+    // Slots that no shader reads may stay empty, and be written while the set
+    // is bound or in use by the GPU.
+    const VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+            0
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = 2;
+    bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+
+    VK_CHECK(vkCreateDescriptorSetLayout(vkContext.device, &layoutInfo, nullptr, &m_bindlessLayout))
+
+    VkDescriptorPoolSize poolSizes[2] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    poolSizes[0].descriptorCount = m_maxImages;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    poolSizes[1].descriptorCount = NUM_BINDLESS_SAMPLERS;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    VK_CHECK(vkCreateDescriptorPool(vkContext.device, &poolInfo, nullptr, &m_bindlessPool))
+
+    VkDescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool = m_bindlessPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &m_bindlessLayout;
+
+    VK_CHECK(vkAllocateDescriptorSets(vkContext.device, &allocateInfo, &m_bindlessSet))
+}
+
+/*
+================================================================================
+DescriptorManager::CreateUniformSet
+
+DESCRIPTION:
+Creates the layout, pool and the one uniform set, with a dynamic uniform buffer
+of MAX_UBO_SIZE per UBO parm. All of them point at the start of the dynamic
+ring, the offsets of the bind pick the blocks.
+================================================================================
+*/
+void DescriptorManager::CreateUniformSet() {
+    VkDescriptorSetLayoutBinding bindings[MAX_UBO_PARMS] = {};
+    for (int i = 0; i < MAX_UBO_PARMS; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = MAX_UBO_PARMS;
+    layoutInfo.pBindings = bindings;
+
+    VK_CHECK(vkCreateDescriptorSetLayout(vkContext.device, &layoutInfo, nullptr, &m_uniformLayout))
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = MAX_UBO_PARMS;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    VK_CHECK(vkCreateDescriptorPool(vkContext.device, &poolInfo, nullptr, &m_uniformPool))
+
+    VkDescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool = m_uniformPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &m_uniformLayout;
+
+    VK_CHECK(vkAllocateDescriptorSets(vkContext.device, &allocateInfo, &m_uniformSet))
+
+    VkDescriptorBufferInfo bufferInfos[MAX_UBO_PARMS] = {};
+    VkWriteDescriptorSet writes[MAX_UBO_PARMS] = {};
+    for (int i = 0; i < MAX_UBO_PARMS; i++) {
+        bufferInfos[i].buffer = bufferManager.DynamicBuffer();
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = MAX_UBO_SIZE;
+
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_uniformSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+
+    vkUpdateDescriptorSets(vkContext.device, MAX_UBO_PARMS, writes, 0, nullptr);
+}
+
+/*
+================================================================================
+DescriptorManager::CollectRetiredSlots
+
+DESCRIPTION:
+Moves the released slots the GPU timeline passed to the free list. Called with
+the mutex held.
+================================================================================
+*/
+void DescriptorManager::CollectRetiredSlots() {
+    if (m_retiredSlots.NumPending() == 0) {
+        return;
+    }
+
+    m_retiredSlots.Collect(gpuTimeline.CompletedValue(), [this](uint32_t index) {
+        m_freeSlots.Add(index);
+    });
+}
@@ -0,0 +1,85 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_DESCRIPTOR_MANAGER_H
+#define RELOAD_DESCRIPTOR_MANAGER_H
+
+#include <mutex>
+#include "RenderCommon.h"
+#include "RetireQueue.h"
+#include "VulkanCommon.h"
+
+// Samplers of the bindless set, one per filter and repeat mode.
+static const uint32_t NUM_BINDLESS_SAMPLERS = 2 * 4;
+
+/*
+================================================================================
+DescriptorManager
+
+DESCRIPTION:
+Owns the descriptor sets of the renderer.
+
+All the sampled images live in one bindless set: a large array of sampled
+images, indexed by the bindless index of the image, and a small array of
+immutable samplers, one per filter and repeat mode. The set is bound once per
+command buffer and shaders pick their textures with indices from push constants
+or uniforms, so drawing a surface doesn't allocate or update any descriptors.
+An image takes a slot when it's allocated and gives it back when it's purged.
+The slot is only reused once the GPU timeline passed every frame that could
+still sample the old image.
+
+Uniforms go through one more set, bound as set 1, with a dynamic uniform buffer
+per UBO parm pointing at the dynamic ring of the buffer manager. The set never
+changes, every frame and every draw binds it with the offsets of its uniform
+blocks in the ring.
+
+NOTE:
+Requires VK_EXT_descriptor_indexing with update after bind, so slots can be
+written while command buffers using the set are recorded or executing.
+================================================================================
+*/
+class DescriptorManager {
+public:
+                    DescriptorManager();
+                    ~DescriptorManager();
+
+    void            Init();                                                     // Creates the samplers and the bindless and uniform sets.
+    void            Shutdown();                                                 // Destroys all pools and sets. The GPU has to be done with them.
+
+    uint32_t        RegisterImage(VkImageView view, VkImageLayout layout);      // Writes the view into a free slot. Returns its bindless index.
+    void            ReleaseImage(uint32_t index, uint64_t retireValue = 0);     // Frees the slot once the GPU timeline reaches the value, 0 for the pending one.
+    void            BindBindless(VkCommandBuffer commandBuffer, VkPipelineLayout layout) const;    // Binds the bindless set as set 0.
+    void            BindUniforms(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const uint32_t offsets[MAX_UBO_PARMS]) const;    // Binds the uniform set as set 1, at the ring offsets.
+
+    static uint32_t SamplerIndex(TextureFilter filter, TextureRepeat repeat);   // Gets the index of the sampler for the modes.
+
+    [[nodiscard]] VkDescriptorSetLayout BindlessLayout() const { return m_bindlessLayout; }
+    [[nodiscard]] VkDescriptorSetLayout UniformLayout() const { return m_uniformLayout; }
+    [[nodiscard]] uint32_t              MaxImages() const { return m_maxImages; }
+
+private:
+    void            CreateSamplers();
+    void            CreateBindlessSet();
+    void            CreateUniformSet();
+    void            CollectRetiredSlots();                                      // Moves the slots the GPU is done with to the free list.
+
+    VkSampler               m_samplers[NUM_BINDLESS_SAMPLERS];
+    VkDescriptorSetLayout   m_bindlessLayout;
+    VkDescriptorPool        m_bindlessPool;
+    VkDescriptorSet         m_bindlessSet;
+    uint32_t                m_maxImages;                                        // Size of the image array, clamped to the device limits.
+
+    VkDescriptorSetLayout   m_uniformLayout;
+    VkDescriptorPool        m_uniformPool;
+    VkDescriptorSet         m_uniformSet;                                       // Dynamic uniform buffers over the whole dynamic ring.
+
+    std::mutex              m_mutex;                                            // Guards the slots and the writes to the bindless set.
+    uint32_t                m_numSlots;                                         // Slots handed out at least once.
+    List<uint32_t>          m_freeSlots;
+    RetireQueue<uint32_t>   m_retiredSlots;                                     // Released slots the GPU may still sample.
+};
+
+extern DescriptorManager descriptorManager;
+
+#endif //RELOAD_DESCRIPTOR_MANAGER_H
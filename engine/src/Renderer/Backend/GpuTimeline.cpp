@@ -0,0 +1,227 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "GpuTimeline.h"
+
+#include "VulkanHelpers.h"
+
+GpuTimeline gpuTimeline;
+
+/*
+================================================================================
+GpuTimeline::GpuTimeline
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+GpuTimeline::GpuTimeline() : m_semaphore(VK_NULL_HANDLE), m_submitted(0), m_frameValue(0), m_lastFrame(0), m_completed(0) {}
+
+/*
+================================================================================
+GpuTimeline::~GpuTimeline
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+GpuTimeline::~GpuTimeline() = default;
+
+/*
+================================================================================
+GpuTimeline::Init
+
+DESCRIPTION:
+Creates the timeline semaphore at value 0, which counts as completed.
+================================================================================
+*/
+void GpuTimeline::Init() {
+    VkSemaphoreTypeCreateInfoKHR typeCreateInfo = {};
+    typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeCreateInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    createInfo.pNext = &typeCreateInfo;
+
+    VK_CHECK(vkCreateSemaphore(vkContext.device, &createInfo, nullptr, &m_semaphore))
+
+    m_submitted = 0;
+    m_frameValue = 0;
+    m_lastFrame = 0;
+    m_completed = 0;
+}
+
+/*
+================================================================================
+GpuTimeline::Shutdown
+
+DESCRIPTION:
+Waits until the GPU is done with everything submitted and destroys the
+semaphore.
+================================================================================
+*/
+void GpuTimeline::Shutdown() {
+    if (m_semaphore == VK_NULL_HANDLE) {
+        return;
+    }
+
+    Wait(SubmittedValue());
+
+    vkDestroySemaphore(vkContext.device, m_semaphore, nullptr);
+    m_semaphore = VK_NULL_HANDLE;
+}
+
+/*
+================================================================================
+GpuTimeline::BeginFrame
+
+DESCRIPTION:
+Reserves the value the frame's submission signals, TIMELINE_VALUES_PER_FRAME
+past the last submission. The values in between are handed out by `Advance`
+to the submissions made while the frame is recorded, which reach the queue
+before the frame does.
+
+RETURNS:
+The value of the frame.
+================================================================================
+*/
+uint64_t GpuTimeline::BeginFrame() {
+    assert(m_frameValue.load(std::memory_order_relaxed) <= SubmittedValue());
+
+    const uint64_t value = SubmittedValue() + TIMELINE_VALUES_PER_FRAME;
+    m_frameValue.store(value, std::memory_order_release);
+
+    return value;
+}
+
+/*
+================================================================================
+GpuTimeline::SubmitFrame
+
+DESCRIPTION:
+Marks the value reserved by `BeginFrame` as submitted. The frame's submission
+must be the next one made to the graphics queue.
+
+RETURNS:
+The value to signal.
+================================================================================
+*/
+uint64_t GpuTimeline::SubmitFrame() {
+    const uint64_t value = m_frameValue.load(std::memory_order_relaxed);
+    assert(value > SubmittedValue());
+
+    m_submitted.store(value, std::memory_order_release);
+    m_lastFrame.store(value, std::memory_order_release);
+
+    return value;
+}
+
+/*
+================================================================================
+GpuTimeline::Advance
+
+DESCRIPTION:
+Hands out the value the caller's submission has to signal. The submission must
+be the next one made to the graphics queue. Within a frame the value stays
+below the frame's own.
+
+RETURNS:
+The value to signal.
+================================================================================
+*/
+uint64_t GpuTimeline::Advance() {
+    const uint64_t value = m_submitted.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    // Only reaches the frame's value once TIMELINE_VALUES_PER_FRAME ran out.
+    assert(value != m_frameValue.load(std::memory_order_relaxed));
+
+    return value;
+}
+
+/*
+================================================================================
+GpuTimeline::PendingValue
+
+RETURNS:
+The value of the frame being recorded. Between frames, the value of the next
+submission.
+================================================================================
+*/
+uint64_t GpuTimeline::PendingValue() const {
+    const uint64_t submitted = SubmittedValue();
+    const uint64_t frameValue = m_frameValue.load(std::memory_order_acquire);
+
+    return frameValue > submitted ? frameValue : submitted + 1;
+}
+
+/*
+================================================================================
+GpuTimeline::CompletedValue
+
+RETURNS:
+The last value the GPU has finished, queried from the semaphore.
+================================================================================
+*/
+uint64_t GpuTimeline::CompletedValue() {
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValueKHR(vkContext.device, m_semaphore, &value))
+
+    // Another thread may have seen a newer value in the meantime.
+    uint64_t completed = m_completed.load(std::memory_order_relaxed);
+    while (completed < value && !m_completed.compare_exchange_weak(completed, value, std::memory_order_release)) {}
+
+    return std::max(completed, value);
+}
+
+/*
+================================================================================
+GpuTimeline::IsComplete
+
+DESCRIPTION:
+Only queries the semaphore when the value is newer than the last one seen as
+completed, so polling many retired objects costs a single query.
+
+RETURNS:
+`true` if the GPU has reached the value.
+================================================================================
+*/
+bool GpuTimeline::IsComplete(uint64_t value) {
+    if (value <= m_completed.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    return value <= CompletedValue();
+}
+
+/*
+================================================================================
+GpuTimeline::Wait
+
+DESCRIPTION:
+Blocks until the GPU has reached the value.
+
+NOTE:
+The value has to be submitted already, otherwise this never returns.
+================================================================================
+*/
+void GpuTimeline::Wait(uint64_t value) {
+    if (IsComplete(value)) {
+        return;
+    }
+
+    assert(value <= SubmittedValue());
+
+    VkSemaphoreWaitInfoKHR waitInfo = {};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_semaphore;
+    waitInfo.pValues = &value;
+
+    VK_CHECK(vkWaitSemaphoresKHR(vkContext.device, &waitInfo, UINT64_MAX))
+
+    uint64_t completed = m_completed.load(std::memory_order_relaxed);
+    while (completed < value && !m_completed.compare_exchange_weak(completed, value, std::memory_order_release)) {}
+}
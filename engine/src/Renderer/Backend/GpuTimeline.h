@@ -0,0 +1,65 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_GPU_TIMELINE_H
+#define RELOAD_GPU_TIMELINE_H
+
+#include <atomic>
+#include "RenderCommon.h"
+#include "VulkanCommon.h"
+
+/*
+================================================================================
+GpuTimeline
+
+DESCRIPTION:
+One timeline semaphore that counts the work done by the graphics queue. Every
+submission to the graphics queue signals the next value, so a value doubles as
+a point in time of the GPU: once it's completed, everything submitted up to it
+is done. Frames, staging segments and released resources simply remember the
+value they have to wait for, instead of each owning a fence that needs to be
+waited on and reset separately.
+
+The value of a frame is reserved by `BeginFrame`, before anything of it is
+recorded, and leaves room below it for the submissions made while the frame is
+recorded. Work released during the frame retires on the frame's value, so a
+staging flush submitted in the middle of the frame can't retire it early.
+
+NOTE:
+Values are only signaled on the graphics queue, in submission order, which keeps
+them monotonic. Submissions are made from one thread at a time, the queries are
+safe from any thread.
+================================================================================
+*/
+class GpuTimeline {
+public:
+                    GpuTimeline();
+                    ~GpuTimeline();
+
+    void            Init();                                                     // Creates the timeline semaphore.
+    void            Shutdown();                                                 // Waits for the GPU and destroys the semaphore.
+
+    uint64_t        BeginFrame();                                               // Reserves the value signaled by the submission of the frame.
+    uint64_t        SubmitFrame();                                              // Gets the frame's value for its submission.
+    uint64_t        Advance();                                                  // Reserves the value signaled by the next submission within the frame.
+    uint64_t        CompletedValue();                                           // Gets the last value the GPU finished.
+    bool            IsComplete(uint64_t value);                                 // Checks whether the value was reached, without waiting.
+    void            Wait(uint64_t value);                                       // Blocks until the value is reached.
+
+    [[nodiscard]] uint64_t      SubmittedValue() const { return m_submitted.load(std::memory_order_acquire); }       // Value of the last submission.
+    [[nodiscard]] uint64_t      PendingValue() const;                                                               // Value covering the work not submitted yet.
+    [[nodiscard]] uint64_t      LastFrameValue() const { return m_lastFrame.load(std::memory_order_acquire); }      // Value of the last submitted frame.
+    [[nodiscard]] VkSemaphore   Semaphore() const { return m_semaphore; }
+
+private:
+    VkSemaphore                 m_semaphore;
+    std::atomic<uint64_t>       m_submitted;                                    // Last value handed out to a submission.
+    std::atomic<uint64_t>       m_frameValue;                                   // Value of the frame being recorded, not above m_submitted between frames.
+    std::atomic<uint64_t>       m_lastFrame;                                    // Value of the last frame submitted.
+    std::atomic<uint64_t>       m_completed;                                    // Last value seen as completed, saves queries.
+};
+
+extern GpuTimeline gpuTimeline;
+
+#endif //RELOAD_GPU_TIMELINE_H
@@ -3,15 +3,15 @@
 //
 
 #include "Image.h"
+
+#include <algorithm>
 #include "VulkanCommon.h"
 #include "VulkanHelpers.h"
 #include "StagingManager.h"
-
-int						Image::m_garbageIndex = 0;
-List<VmaAllocation>     Image::m_allocationGarbage[MAX_FRAMES_IN_FLIGHT];
-List<VkImage>		    Image::m_imageGarbage[MAX_FRAMES_IN_FLIGHT];
-List<VkImageView>	    Image::m_viewGarbage[MAX_FRAMES_IN_FLIGHT];
-List<VkSampler>		    Image::m_samplerGarbage[MAX_FRAMES_IN_FLIGHT];
+#include "DeferredDelete.h"
+#include "DescriptorManager.h"
+#include "Defragmenter.h"
+#include "ImageManager.h"
 
 [[maybe_unused]] VkFormat RVk_GetFormatFromTextureFormat(const TextureFormat format) {
     switch ( format ) {
@@ -112,6 +112,7 @@ int BitsForFormat(TextureFormat format ) {
 Image::Image(std::string name)
         : m_refCount(0)
         , m_imgName(name)
+        , m_nameId(nameTable.Intern(m_imgName))
         , m_cubeFiles(CF_2D)
         , m_generatorFunction(nullptr)
         , m_usage(TD_DEFAULT)
@@ -124,7 +125,15 @@ Image::Image(std::string name)
         , m_sampler(VK_NULL_HANDLE)
         , m_image(VK_NULL_HANDLE)
         , m_view(VK_NULL_HANDLE)
-        , m_layout(VK_IMAGE_LAYOUT_GENERAL){}
+        , m_layout(VK_IMAGE_LAYOUT_GENERAL)
+        , m_bindlessIndex(BINDLESS_INVALID_INDEX)
+        , m_allocation(VK_NULL_HANDLE)
+        , m_allocSize(0)
+        , m_streamed(false)
+        , m_loadState(IMAGE_LOAD_READY)
+        , m_lastUsed(0)
+        , m_defragmenting(false)
+        , m_uploadId(0) {}
 
 Image::~Image() {
 
@@ -134,12 +143,41 @@ void Image::Alloc() {
     Purge();
     m_internalFormat = RVk_GetFormatFromTextureFormat(m_imgOpts.format);
 
+    VkImageCreateInfo imgInfo = {};
+    FillCreateInfo(imgInfo);
+
+    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
+    vmaAllocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    // IF depth
+    // vmaAllocCreateInfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VmaAllocationInfo allocationInfo = {};
+    VK_CHECK(vmaCreateImage(vmaAllocator, &imgInfo, &vmaAllocCreateInfo, &m_image, &m_allocation, &allocationInfo))
+    m_allocSize = allocationInfo.size;
+
+    m_view = CreateView(m_image);
+
+    // Sampled in the layout the upload or the render pass leaves it in.
+    m_bindlessIndex = descriptorManager.RegisterImage(m_view, (m_imgOpts.format == FMT_DEPTH)
+            ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+            : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+/*
+================================================================================
+Image::FillCreateInfo
+
+DESCRIPTION:
+Fills in the create info of the image from its options. Sampled color images can
+be copied from as well, so the defragmenter can move them.
+================================================================================
+*/
+void Image::FillCreateInfo(VkImageCreateInfo &imgInfo) const {
     VkImageUsageFlags usageFlags = VK_IMAGE_USAGE_SAMPLED_BIT;
     usageFlags |= (m_imgOpts.format == FMT_DEPTH)
                   ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-                  : VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                  : VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-    VkImageCreateInfo imgInfo = {};
     imgInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imgInfo.imageType = VK_IMAGE_TYPE_2D;
     imgInfo.format = m_internalFormat;
@@ -155,17 +193,21 @@ void Image::Alloc() {
     imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     imgInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imgInfo.flags = (m_imgOpts.texType == TEX_TYPE_CUBIC) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+}
 
-    VmaAllocationCreateInfo vmaAllocCreateInfo = {};
-    vmaAllocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-    // IF depth
-    // vmaAllocCreateInfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    VK_CHECK(vmaCreateImage(vmaAllocator, &imgInfo, &vmaAllocCreateInfo, &m_image, &m_allocation, nullptr))
+/*
+================================================================================
+Image::CreateView
 
+RETURNS:
+A view over all the levels and layers of the given image, which has to be
+created from the options of this one.
+================================================================================
+*/
+VkImageView Image::CreateView(VkImage image) const {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = m_image;
+    viewInfo.image = image;
     viewInfo.viewType = (m_imgOpts.texType == TEX_TYPE_CUBIC) ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = m_internalFormat;
     viewInfo.components = VK_GetComponentMappingFromTextureFormat(m_imgOpts.format, m_imgOpts.colorFormat);
@@ -177,25 +219,203 @@ void Image::Alloc() {
     viewInfo.subresourceRange.layerCount = m_imgOpts.texType == TEX_TYPE_CUBIC ? 6 : 1;
     viewInfo.subresourceRange.baseMipLevel = 0;
 
-    VK_CHECK(vkCreateImageView(vkContext.device, &viewInfo, nullptr, &m_view))
+    VkImageView view = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateImageView(vkContext.device, &viewInfo, nullptr, &view))
+
+    return view;
 }
 
+/*
+================================================================================
+Image::IsMovable
+
+RETURNS:
+`true` if the defragmenter may move the image. Only sampled color images are,
+and only once the GPU finished their last upload. On a transfer queue the copy
+into the image isn't ordered with the move on the graphics queue.
+================================================================================
+*/
+bool Image::IsMovable() const {
+    return m_image != VK_NULL_HANDLE
+           && m_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+           && m_imgOpts.format != FMT_DEPTH
+           && stagingManager.IsUploadDone(m_uploadId);
+}
+
+/*
+================================================================================
+Image::Move
+
+DESCRIPTION:
+Moves the image to the memory the defragmenter picked for its allocation. A new
+image is bound there and the old one copied into it on the command buffer, ahead
+of the draws of the frame. The image, view and bindless slot are swapped for new
+ones right away, so everything recorded from here on samples the new image. The
+old ones go through the deferred delete queue, as frames in flight still sample
+them. The allocation itself is re-pointed by VMA when the pass ends.
+================================================================================
+*/
+void Image::Move(VkCommandBuffer commandBuffer, VkDeviceMemory memory, VkDeviceSize offset) {
+    VkImageCreateInfo imgInfo = {};
+    FillCreateInfo(imgInfo);
+
+    VkImage image = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateImage(vkContext.device, &imgInfo, nullptr, &image))
+    VK_CHECK(vkBindImageMemory(vkContext.device, image, memory, offset))
+
+    VkImageMemoryBarrier barriers[2] = {};
+    for (VkImageMemoryBarrier & barrier : barriers) {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = imgInfo.mipLevels;
+        barrier.subresourceRange.layerCount = imgInfo.arrayLayers;
+    }
+
+    barriers[0].image = m_image;
+    barriers[0].oldLayout = m_layout;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[1].image = image;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[1].srcAccessMask = 0;
+    barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            2,
+            barriers);
+
+    VkImageCopy regions[MAX_IMAGE_LEVELS] = {};
+    const uint32_t numLevels = std::min(imgInfo.mipLevels, MAX_IMAGE_LEVELS);
+    for (uint32_t level = 0; level < numLevels; level++) {
+        VkImageCopy & region = regions[level];
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.mipLevel = level;
+        region.srcSubresource.layerCount = imgInfo.arrayLayers;
+        region.dstSubresource = region.srcSubresource;
+        region.extent.width = std::max(imgInfo.extent.width >> level, 1u);
+        region.extent.height = std::max(imgInfo.extent.height >> level, 1u);
+        region.extent.depth = 1;
+    }
+
+    vkCmdCopyImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, numLevels, regions);
+
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barriers[1]);
+
+    // The memory stays with the allocation, only the handles go. They retire
+    // with this frame, whose copy still reads them.
+    deferredDelete.ReleaseImageView(m_view);
+    deferredDelete.ReleaseImage(m_image, VK_NULL_HANDLE);
+    descriptorManager.ReleaseImage(m_bindlessIndex);
+
+    m_image = image;
+    m_view = CreateView(m_image);
+    m_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    m_bindlessIndex = descriptorManager.RegisterImage(m_view, m_layout);
+}
+
+/*
+================================================================================
+Image::Purge
+
+DESCRIPTION:
+Releases the Vulkan objects and the bindless slot of the image. They may still
+be used by work that was recorded but not submitted yet, so they go through the
+deferred delete queue. An allocation the running defragmentation pass may move
+can't be freed before the pass ends, so the defragmenter frees it then.
+================================================================================
+*/
 void Image::Purge() {
-    if (m_sampler != VK_NULL_HANDLE) {
-        m_samplerGarbage[m_garbageIndex].Add(m_sampler);
-        m_sampler = VK_NULL_HANDLE;
+    if (m_bindlessIndex != BINDLESS_INVALID_INDEX) {
+        descriptorManager.ReleaseImage(m_bindlessIndex);
+        m_bindlessIndex = BINDLESS_INVALID_INDEX;
+    }
+
+    deferredDelete.ReleaseSampler(m_sampler);
+    deferredDelete.ReleaseImageView(m_view);
+
+    if (m_defragmenting) {
+        deferredDelete.ReleaseImage(m_image, VK_NULL_HANDLE);
+        defragmenter.Release(m_allocation);
+        m_defragmenting = false;
+    } else {
+        deferredDelete.ReleaseImage(m_image, m_allocation);
     }
 
-    if ( m_image != VK_NULL_HANDLE ) {
-        m_allocationGarbage[m_garbageIndex].Add(m_allocation);
-        m_viewGarbage[m_garbageIndex].Add(m_view);
-        m_imageGarbage[m_garbageIndex].Add(m_image);
+    m_allocation = NULL;
+    m_allocSize = 0;
+    m_layout = VK_IMAGE_LAYOUT_GENERAL;
 
-        m_allocation = NULL;
+    m_sampler = VK_NULL_HANDLE;
+    m_view = VK_NULL_HANDLE;
+    m_image = VK_NULL_HANDLE;
+}
 
-        m_view = VK_NULL_HANDLE;
-        m_image = VK_NULL_HANDLE;
+/*
+================================================================================
+Image::Evict
+
+DESCRIPTION:
+Purges a streamed image to give its memory back. The image stays registered
+and is marked as evicted, so the image manager loads it again once it's used.
+================================================================================
+*/
+void Image::Evict() {
+    Purge();
+    m_loadState.store(IMAGE_LOAD_EVICTED, std::memory_order_release);
+}
+
+/*
+================================================================================
+Image::GetBindlessIndex
+
+RETURNS:
+The index of the image in the bindless image array. A streamed image that isn't
+loaded yet, was evicted or failed to load gets the default image's, so it can be
+drawn with right away.
+
+NOTE:
+Draws get their images' indices through here, so it marks the image as used by
+the frame being recorded. That keeps drawn images from being evicted, and loads
+evicted ones again.
+================================================================================
+*/
+uint32_t Image::GetBindlessIndex() const {
+    Touch();
+
+    if (m_streamed && GetLoadState() != IMAGE_LOAD_READY) {
+        const Image * placeholder = globalImages->m_defaultImage;
+        return (placeholder != nullptr && placeholder != this) ? placeholder->m_bindlessIndex : BINDLESS_INVALID_INDEX;
     }
+
+    return m_bindlessIndex;
 }
 
 void Image::SubImageUpload(int mipLevel, int x, int y, int z, int width, int height, const void * pic, int pixelPitch ) {
@@ -208,35 +428,11 @@ void Image::SubImageUpload(int mipLevel, int x, int y, int z, int width, int hei
 
     uint32_t size = static_cast<uint32_t>(width * height * BitsForFormat(m_imgOpts.format) / 8);
 
-    VkBuffer buffer;
-    VkCommandBuffer commandBuffer;
-    VkDeviceSize offset = 0;
-    char * data = stagingManager.Stage(size, 16, commandBuffer, buffer, offset);
+    // Large images are staged in bands of whole rows, compressed ones in rows of 4x4 blocks.
+    const uint32_t bandHeight = IsCompressed() ? 4 : 1;
+    const uint32_t bandSize = static_cast<uint32_t>(width * BitsForFormat(m_imgOpts.format) / 8) * bandHeight;
 
-    if (m_imgOpts.format == FMT_RGB565 ) {
-        char * imgData = (char *)pic;
-        for (uint32_t i = 0; i < size; i += 2 ) {
-            data[ i ] = imgData[i + 1];
-            data[ i + 1 ] = imgData[i];
-        }
-    } else {
-        memcpy(data, pic, size);
-    }
-
-    VkBufferImageCopy imgCopy = {};
-    imgCopy.bufferOffset = offset;
-    imgCopy.bufferRowLength = static_cast<uint32_t>(pixelPitch);
-    imgCopy.bufferImageHeight = static_cast<uint32_t>(height);
-    imgCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    imgCopy.imageSubresource.layerCount = 1;
-    imgCopy.imageSubresource.mipLevel = static_cast<uint32_t>(mipLevel);
-    imgCopy.imageSubresource.baseArrayLayer = static_cast<uint32_t>(z);
-    imgCopy.imageOffset.x = x;
-    imgCopy.imageOffset.y = y;
-    imgCopy.imageOffset.z = 0;
-    imgCopy.imageExtent.width = static_cast<uint32_t>(width);
-    imgCopy.imageExtent.height = static_cast<uint32_t>(height);
-    imgCopy.imageExtent.depth = 1;
+    const auto * imgData = static_cast<const char *>(pic);
 
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -249,30 +445,63 @@ void Image::SubImageUpload(int mipLevel, int x, int y, int z, int width, int hei
     barrier.subresourceRange.baseArrayLayer = static_cast<uint32_t>(z);
     barrier.subresourceRange.layerCount = 1;
 
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    m_uploadId = stagingManager.StageChunks(size, 16, bandSize, [&](char *data, uint32_t chunkOffset, uint32_t chunkSize,
+            VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+        if (m_imgOpts.format == FMT_RGB565 ) {
+            for (uint32_t i = 0; i < chunkSize; i += 2 ) {
+                data[ i ] = imgData[chunkOffset + i + 1];
+                data[ i + 1 ] = imgData[chunkOffset + i];
+            }
+        } else {
+            memcpy(data, imgData + chunkOffset, chunkSize);
+        }
 
-    vkCmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            0,
-            0,
-            nullptr,
-            0,
-            nullptr,
-            1,
-            &barrier);
+        const uint32_t firstRow = chunkOffset / bandSize * bandHeight;
+        const uint32_t numRows = chunkSize / bandSize * bandHeight;
+
+        VkBufferImageCopy imgCopy = {};
+        imgCopy.bufferOffset = offset;
+        imgCopy.bufferRowLength = static_cast<uint32_t>(pixelPitch);
+        imgCopy.bufferImageHeight = numRows;
+        imgCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imgCopy.imageSubresource.layerCount = 1;
+        imgCopy.imageSubresource.mipLevel = static_cast<uint32_t>(mipLevel);
+        imgCopy.imageSubresource.baseArrayLayer = static_cast<uint32_t>(z);
+        imgCopy.imageOffset.x = x;
+        imgCopy.imageOffset.y = y + static_cast<int>(firstRow);
+        imgCopy.imageOffset.z = 0;
+        imgCopy.imageExtent.width = static_cast<uint32_t>(width);
+        imgCopy.imageExtent.height = numRows;
+        imgCopy.imageExtent.depth = 1;
+
+        // The bands may end up in different segments, but they are all on the
+        // same queue, so the image stays in TRANSFER_DST until the last one.
+        if (chunkOffset == 0) {
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(
+                    commandBuffer,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr,
+                    1,
+                    &barrier);
+        }
 
-    vkCmdCopyBufferToImage(commandBuffer, buffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imgCopy);
+        vkCmdCopyBufferToImage(commandBuffer, buffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imgCopy);
 
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        if (chunkOffset + chunkSize == size) {
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            stagingManager.HandOffImage(commandBuffer, barrier);
+        }
+    });
 
     m_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
@@ -286,32 +515,3 @@ void Image::CreateFromSwapImage(VkImage image, VkImageView imageView,
 void Image::CreateSampler() {
 
 }
-
-void Image::EmptyGarbage() {
-    m_garbageIndex = (m_garbageIndex + 1) % static_cast<int>(MAX_FRAMES_IN_FLIGHT);
-
-    List<VmaAllocation> & allocationsToFree = m_allocationGarbage[m_garbageIndex];
-    List<VkImage> & imagesToFree = m_imageGarbage[m_garbageIndex];
-    List<VkImageView> & viewsToFree = m_viewGarbage[m_garbageIndex];
-    List<VkSampler> & samplersToFree = m_samplerGarbage[m_garbageIndex];
-
-    const int numAllocations = allocationsToFree.Size();
-    for ( int i = 0; i < numAllocations; ++i ) {
-        vmaDestroyImage(vmaAllocator, imagesToFree[i], allocationsToFree[i]);
-    }
-
-    const int numViews = viewsToFree.Size();
-    for ( int i = 0; i < numViews; ++i ) {
-        vkDestroyImageView(vkContext.device, viewsToFree[i], nullptr);
-    }
-
-    const int numSamplers = samplersToFree.Size();
-    for ( int i = 0; i < numSamplers; ++i ) {
-        vkDestroySampler(vkContext.device, samplersToFree[ i ], nullptr);
-    }
-
-    allocationsToFree.Clear();
-    imagesToFree.Clear();
-    viewsToFree.Clear();
-    samplersToFree.Clear();
-}
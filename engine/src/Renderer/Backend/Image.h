@@ -5,14 +5,27 @@
 #ifndef RELOAD_IMAGE_H
 #define RELOAD_IMAGE_H
 
+#include <atomic>
 #include "ReloadLib/RldLib.h"
+#include "ReloadLib/NameTable.h"
 #include "ReloadLib/Containers/List.h"
 #include "VulkanCommon.h"
 #include "RenderCommon.h"
 #include "VulkanMemory.h"
+#include "GpuTimeline.h"
 
 class ImageManager;
 
+// Progress of an image loaded from a file. Until it's ready, the default image is
+// sampled in its place.
+enum ImageLoadState {
+    IMAGE_LOAD_QUEUED,                                                          // Waiting for or being decoded on a job worker.
+    IMAGE_LOAD_UPLOADING,                                                       // Decoded, the copy to the GPU is in flight.
+    IMAGE_LOAD_READY,
+    IMAGE_LOAD_EVICTED,                                                         // Purged to stay under the memory budget, loaded again once used.
+    IMAGE_LOAD_FAILED                                                           // The file couldn't be decoded, the default image stays.
+};
+
 class Image{
 public:
     explicit        Image(std::string name);
@@ -23,12 +36,17 @@ public:
     void            SubImageUpload(int mipLevel, int x, int y, int z, int width, int height, const void * pic, int pixelPitch);
     void		    CreateFromSwapImage( VkImage image, VkImageView imageView, VkFormat format, const VkExtent2D & extent );
     void            CreateSampler();
+    void            Evict();                                                    // Purges the memory of a streamed image, it's loaded again on demand.
+    void            Move(VkCommandBuffer commandBuffer, VkDeviceMemory memory, VkDeviceSize offset);    // Copies the image to a new place in device memory.
+    void            Touch() const { m_lastUsed.store(gpuTimeline.PendingValue(), std::memory_order_relaxed); }    // Marks the image as used by the frame being recorded.
 
-    static void     EmptyGarbage();
 
     [[nodiscard]]
     bool		    IsCompressed() const { return (m_imgOpts.format == FMT_DXT1 || m_imgOpts.format == FMT_DXT5 ); }
 
+    [[nodiscard]]
+    NameId          GetNameId() const { return m_nameId; }
+
     [[nodiscard]]
     VkImage		    GetImage() const { return m_image; }
 
@@ -40,11 +58,40 @@ public:
 
     [[nodiscard]]
     VkSampler	    GetSampler() const { return m_sampler; }
+
+    [[nodiscard]]
+    uint32_t        GetBindlessIndex() const;                                   // Index into the bindless image array, the default image's until loaded.
+
+    [[nodiscard]]
+    ImageLoadState  GetLoadState() const { return m_loadState.load(std::memory_order_acquire); }
+
+    [[nodiscard]]
+    uint64_t        GetLastUsed() const { return m_lastUsed.load(std::memory_order_relaxed); }    // Timeline value of the last frame that used the image.
+
+    [[nodiscard]]
+    VkDeviceSize    GetAllocSize() const { return m_allocSize; }
+
+    [[nodiscard]]
+    uint64_t        GetUploadId() const { return m_uploadId; }                  // Staging upload id of the last upload, for StagingManager::IsUploadDone.
+
+    [[nodiscard]]
+    bool            IsEvictable() const { return m_streamed && GetLoadState() == IMAGE_LOAD_READY; }
+
+    [[nodiscard]]
+    bool            IsEvicted() const { return GetLoadState() == IMAGE_LOAD_EVICTED; }
+
+    [[nodiscard]]
+    bool            IsMovable() const;                                          // Sampled color image whose uploads the GPU finished.
 private:
     friend class ImageManager;
+    friend class Defragmenter;
+
+    void            FillCreateInfo(VkImageCreateInfo & imgInfo) const;
+    VkImageView     CreateView(VkImage image) const;
 
     int					m_refCount;
     std::string		    m_imgName;				                                // game path, including extension (except for cube maps), may be an image program
+    NameId              m_nameId;                                               // interned m_imgName, used as the registry key
     CubeFiles			m_cubeFiles;			                                // If this is a cube map, and if so, what kind
     void				(*m_generatorFunction)(Image *image);	        // NULL for files
     TextureUsage		m_usage;				                                // Used to determine the type of compression to use
@@ -64,15 +111,16 @@ private:
     VkImage				m_image;
     VkImageView			m_view;
     VkImageLayout		m_layout;
+    uint32_t            m_bindlessIndex;
 
-    static int				    m_garbageIndex;
-    static List<VkImage>		m_imageGarbage[MAX_FRAMES_IN_FLIGHT];
-    static List<VkImageView>	m_viewGarbage[MAX_FRAMES_IN_FLIGHT];
-    static List<VkSampler>	    m_samplerGarbage[MAX_FRAMES_IN_FLIGHT];
-
-    VmaAllocation		        m_allocation;
-    static List<VmaAllocation>  m_allocationGarbage[MAX_FRAMES_IN_FLIGHT];
+    VmaAllocation		m_allocation;
+    VkDeviceSize        m_allocSize;                                            // Device memory held by the image.
 
+    bool                m_streamed;                                             // Loaded from a file, so it can be evicted and loaded again.
+    std::atomic<ImageLoadState> m_loadState;                                    // Published with release once the upload is done.
+    mutable std::atomic<uint64_t>   m_lastUsed;                                 // Touched by the draws, which only see const images.
+    bool                m_defragmenting;                                        // The allocation is part of the running defragmentation pass.
+    uint64_t            m_uploadId;                                             // Staging upload id of the last upload, 0 for none.
 };
 
 #endif //RELOAD_IMAGE_H
@@ -0,0 +1,93 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "ImageLoader.h"
+
+#include "ReloadLib/FileSystem.h"
+#include "ReloadLib/sys/Heap.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_STDIO
+#define STBI_MALLOC(size)               Mem::Alloc(size)
+#define STBI_REALLOC(ptr, newSize)      Mem::Realloc(ptr, newSize)
+#define STBI_FREE(ptr)                  Mem::Free(ptr)
+
+#if defined(__GNUC__)
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wconversion"
+#   pragma GCC diagnostic ignored "-Wsign-conversion"
+#   pragma GCC diagnostic ignored "-Wunused-function"
+#   pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#   pragma GCC diagnostic ignored "-Wsign-compare"
+#   pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#endif
+#include "lib/stb/stb_image.h"
+#if defined(__GNUC__)
+#   pragma GCC diagnostic pop
+#endif
+
+/*
+================================================================================
+ImageLoader::LoadFromFile
+
+DESCRIPTION:
+Opens the asset, from the archive or the loose file, and decodes it to RGBA8.
+The view is dropped as soon as the pixels are decoded.
+
+RETURNS:
+`true` if the image was decoded.
+================================================================================
+*/
+bool ImageLoader::LoadFromFile(const char *path, ImageFileData &image) {
+    AssetFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    file.Advise(MAP_ADVICE_SEQUENTIAL);
+
+    if (!LoadFromMemory(file.Data(), image)) {
+        SDL_LogError(LOG_FILE, "Error decoding %s: %s.", path, stbi_failure_reason());
+        return false;
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+ImageLoader::LoadFromMemory
+
+DESCRIPTION:
+Decodes an encoded image to RGBA8.
+
+RETURNS:
+`true` if the image was decoded.
+================================================================================
+*/
+bool ImageLoader::LoadFromMemory(Span<const uint8_t> data, ImageFileData &image) {
+    image = ImageFileData{};
+
+    if (data.Empty() || data.Size() > static_cast<size_t>(INT_MAX)) {
+        return false;
+    }
+
+    image.pixels = stbi_load_from_memory(data.Data(), static_cast<int>(data.Size()),
+                                         &image.width, &image.height, &image.sourceChannels, STBI_rgb_alpha);
+
+    return image.pixels != nullptr;
+}
+
+/*
+================================================================================
+ImageLoader::Free
+
+DESCRIPTION:
+Frees the decoded pixels.
+================================================================================
+*/
+void ImageLoader::Free(ImageFileData &image) {
+    stbi_image_free(image.pixels);
+    image = ImageFileData{};
+}
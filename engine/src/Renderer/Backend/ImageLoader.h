@@ -0,0 +1,37 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_IMAGE_LOADER_H
+#define RELOAD_IMAGE_LOADER_H
+
+#include "Common.h"
+#include "ReloadLib/Containers/Span.h"
+
+// Decoded image, always 8 bits per channel RGBA.
+struct ImageFileData {
+    int             width = 0;
+    int             height = 0;
+    int             sourceChannels = 0;                                         // Number of channels stored in the file.
+    uint8_t *       pixels = nullptr;                                           // width * height * 4 bytes, owned by the loader.
+
+    [[nodiscard]] size_t SizeInBytes() const { return static_cast<size_t>(width) * static_cast<size_t>(height) * 4; }
+};
+
+/*
+================================================================================
+ImageLoader
+
+DESCRIPTION:
+Decodes image files through stb_image. Files are memory mapped and decoded
+straight from the mapping, so the only allocation is the decoded pixel buffer.
+================================================================================
+*/
+class ImageLoader {
+public:
+    static bool     LoadFromFile(const char *path, ImageFileData &image);       // Opens and decodes the asset. Returns `false` on failure.
+    static bool     LoadFromMemory(Span<const uint8_t> data, ImageFileData &image); // Decodes an encoded image. Returns `false` on failure.
+    static void     Free(ImageFileData &image);                                 // Frees the decoded pixels.
+};
+
+#endif //RELOAD_IMAGE_LOADER_H
@@ -3,7 +3,14 @@
 //
 
 #include "ImageManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include "GpuTimeline.h"
+#include "StagingManager.h"
+#include "ReloadLib/FileSystem.h"
 #include "ReloadLib/Extensions/Str.h"
+#include "ReloadLib/sys/Heap.h"
 
 ImageManager imageManager;
 ImageManager * globalImages = &imageManager;
@@ -11,16 +18,225 @@ ImageManager * globalImages = &imageManager;
 ImageManager::ImageManager() {
         m_insideLevelLoad = false;
         m_preloadingMapImages = false;
+        m_defaultImage = nullptr;
 }
 
 void ImageManager::Init() {
-    m_images.reserve(1024);
+    m_images.Reserve(1024);
 
-    // CreateIntrinsicImages();
+    // CreateIntrinsicImages() needs the backend, the render system calls it once it's up.
 }
 
 void ImageManager::Shutdown() {
-    m_images.clear();
+    // The reads still in flight hand their requests to the workers, which may
+    // still be decoding into requests owned by the manager.
+    asyncIO.Flush();
+    jobSystem.Wait(&m_loadCounter);
+
+    for (int i = 0; i < m_decoded.Size(); i++) {
+        ImageLoader::Free(m_decoded[i]->data);
+        delete m_decoded[i];
+    }
+
+    m_decoded.Clear();
+    m_uploads.Clear();
+    m_evicted.Clear();
+
+    // Purged while the backend is still up, it frees them when it shuts down.
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto & imageMap : m_images) {
+        imageMap.value->Purge();
+        delete imageMap.value;
+    }
+
+    m_images.Clear();
+    m_defaultImage = nullptr;
+}
+
+void ImageManager::CreateIntrinsicImages() {
+    // Grey grid, sampled in place of the images still loading.
+    static const int size = 16;
+    uint8_t pixels[size * size * 4];
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const uint8_t value = (x == 0 || y == 0) ? 255 : 64;
+            uint8_t * pixel = pixels + (y * size + x) * 4;
+            pixel[0] = value;
+            pixel[1] = value;
+            pixel[2] = value;
+            pixel[3] = 255;
+        }
+    }
+
+    ImageOpts opts;
+    opts.format = FMT_RGBA8;
+    opts.width = size;
+    opts.height = size;
+    opts.numLevels = 1;
+
+    m_defaultImage = ScratchImage("_default", opts);
+    m_defaultImage->SubImageUpload(0, 0, 0, 0, size, size, pixels, size);
+}
+
+Image *ImageManager::ImageFromFile(const char *name, TextureFilter filter, TextureRepeat repeat, TextureUsage usage) {
+    if (name == nullptr || name[0] == '\0' || strcmp(name, "default") == 0 || strcmp(name, "_default") == 0) {
+        return m_defaultImage;
+    }
+
+    const NameId nameId = nameTable.Intern(name);
+    if (nameId == NAME_NONE) {
+        spdlog::warn("Invalid image name \"{}\".", name);
+        return m_defaultImage;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Image * image = GetImage(nameId);
+    if (image != nullptr) {
+        // An evicted image is loaded again by the next update.
+        image->Touch();
+        return image;
+    }
+
+    image = new Image(name);
+    m_images.Set(image->GetNameId(), image);
+
+    image->m_streamed = true;
+    image->m_filter = filter;
+    image->m_repeat = repeat;
+    image->m_usage = usage;
+    image->Touch();
+
+    QueueLoad(image);
+
+    return image;
+}
+
+void ImageManager::QueueLoad(Image *image) {
+    image->m_loadState.store(IMAGE_LOAD_QUEUED, std::memory_order_release);
+
+    auto * request = new LoadRequest{image, ImageFileData{}, false, nullptr, 0};
+
+    // The file is read by the IO service, the job threads only decode it.
+    // Archived images are read as a range of the archive.
+    const AssetLocation location = fileSystem.Locate(image->m_imgName.c_str());
+
+    IoReadRequest read;
+    read.path = location.path;
+    read.offset = location.offset;
+    read.size = location.size;
+    read.priority = IO_PRIORITY_LOW;
+    read.callback = &ImageManager::ReadDone;
+    read.userData = request;
+    asyncIO.Read(read);
+}
+
+void ImageManager::ReadDone(IoResult &result) {
+    auto * request = static_cast<LoadRequest *>(result.userData);
+
+    if (result.status != IO_STATUS_COMPLETE) {
+        globalImages->FinishDecode(request);
+        return;
+    }
+
+    // Freed by the decode job.
+    request->encoded = result.data;
+    request->encodedSize = result.size;
+    result.data = nullptr;
+
+    Job job;
+    job.func = &ImageManager::DecodeJob;
+    job.data = request;
+    jobSystem.RunBackground(&job, 1, &globalImages->m_loadCounter);
+}
+
+void ImageManager::DecodeJob(void *data) {
+    auto * request = static_cast<LoadRequest *>(data);
+
+    request->decoded = ImageLoader::LoadFromMemory(Span<const uint8_t>(request->encoded, request->encodedSize), request->data);
+
+    Mem::Free(request->encoded);
+    request->encoded = nullptr;
+
+    globalImages->FinishDecode(request);
+}
+
+void ImageManager::FinishDecode(LoadRequest *request) {
+    std::lock_guard<std::mutex> lock(m_decodedMutex);
+    m_decoded.Add(request);
+}
+
+void ImageManager::Update() {
+    // Evicted images used again since are loaded again.
+    for (int i = m_evicted.Size() - 1; i >= 0; i--) {
+        const EvictedImage & evicted = m_evicted[i];
+        if (!evicted.image->IsEvicted()) {
+            m_evicted.RemoveIndex(i);
+        } else if (evicted.image->GetLastUsed() >= evicted.evictedValue) {
+            QueueLoad(evicted.image);
+            m_evicted.RemoveIndex(i);
+        }
+    }
+
+    // The images swap in for the default one once the GPU is done with their
+    // copies, which may run on the transfer queue.
+    for (int i = m_uploads.Size() - 1; i >= 0; i--) {
+        const PendingUpload & upload = m_uploads[i];
+        if (stagingManager.IsUploadDone(upload.uploadId)) {
+            upload.image->m_loadState.store(IMAGE_LOAD_READY, std::memory_order_release);
+            m_uploads.RemoveIndex(i);
+        }
+    }
+
+    List<LoadRequest *> requests;
+    {
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+
+        // Keep a burst of loads from stalling a single frame on the staging buffer.
+        size_t uploadBytes = 0;
+        int numRequests = 0;
+        while (numRequests < m_decoded.Size() && (numRequests == 0 || uploadBytes < IMAGE_UPLOAD_BYTES_PER_FRAME)) {
+            uploadBytes += m_decoded[numRequests]->data.SizeInBytes();
+            requests.Add(m_decoded[numRequests]);
+            numRequests++;
+        }
+
+        for (int i = numRequests - 1; i >= 0; i--) {
+            m_decoded.RemoveIndex(i);
+        }
+    }
+
+    for (int i = 0; i < requests.Size(); i++) {
+        UploadImage(requests[i]);
+    }
+}
+
+void ImageManager::UploadImage(LoadRequest *request) {
+    Image * image = request->image;
+
+    if (!request->decoded) {
+        spdlog::warn("Failed to load image \"{}\".", image->m_imgName);
+        image->m_loadState.store(IMAGE_LOAD_FAILED, std::memory_order_release);
+    } else {
+        const ImageFileData & data = request->data;
+
+        image->m_imgOpts = ImageOpts{};
+        image->m_imgOpts.format = FMT_RGBA8;
+        image->m_imgOpts.width = static_cast<uint32_t>(data.width);
+        image->m_imgOpts.height = static_cast<uint32_t>(data.height);
+        image->m_imgOpts.numLevels = 1;
+        image->Alloc();
+
+        image->SubImageUpload(0, 0, 0, 0, data.width, data.height, data.pixels, data.width);
+
+        image->m_loadState.store(IMAGE_LOAD_UPLOADING, std::memory_order_release);
+        m_uploads.Add(PendingUpload{image, image->GetUploadId()});
+    }
+
+    ImageLoader::Free(request->data);
+    delete request;
 }
 
 Image *ImageManager::ScratchImage(std::string name, const ImageOpts &opts) {
@@ -31,45 +247,104 @@ Image *ImageManager::ScratchImage(std::string name, const ImageOpts &opts) {
     Image * image = GetImage(name);
     if (image == nullptr) {
         image = AllocImage(name);
-    } else {
-        image->Purge();
+        if (image == nullptr) {
+            return nullptr;
+        }
     }
 
+    image->Purge();
+
     image->m_imgOpts = opts;
     image->Alloc();
 
     return image;
 }
 
-Image *ImageManager::GetImage(std::string name) const {
+Image *ImageManager::GetImage(std::string_view name) const {
     if (name.empty() || name == "default" || name == "_default") {
         return globalImages->m_defaultImage;
     }
 
-    Str::TrimExtension(name);
+    const NameId nameId = nameTable.Find(name);
+    if (nameId == NAME_NONE) {
+        return nullptr;
+    }
 
-    auto imageMap = m_images.find(name);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return GetImage(nameId);
+}
 
-    if (imageMap != m_images.end() && Str::CompareI(name, imageMap->second->m_imgName)) {
-        return imageMap->second;
-    }
+Image *ImageManager::GetImage(NameId nameId) const {
+    // Callers that may race ImageFromFile hold m_mutex.
+    Image * const * image = m_images.Find(nameId);
 
-    return nullptr;
+    return image != nullptr ? *image : nullptr;
 }
 
 void ImageManager::PurgeAllImages() {
-    for (auto imageMap : m_images) {
-        imageMap.second->Purge();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto & imageMap : m_images) {
+        imageMap.value->Purge();
     }
 }
 
+VkDeviceSize ImageManager::EvictImages(VkDeviceSize bytes) {
+    const uint64_t pendingValue = gpuTimeline.PendingValue();
+    // Nothing is drawn yet this frame, the images of the last one are the ones
+    // in use and would only be loaded again right away.
+    const uint64_t lastFrameValue = gpuTimeline.LastFrameValue();
+
+    List<Image *> candidates;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto & imageMap : m_images) {
+            Image * image = imageMap.value;
+            if (image->IsEvictable() && image->GetLastUsed() < lastFrameValue) {
+                candidates.Add(image);
+            }
+        }
+    }
+
+    std::sort(candidates.Data(), candidates.Data() + candidates.Size(), [](const Image *a, const Image *b) {
+        return a->GetLastUsed() < b->GetLastUsed();
+    });
+
+    VkDeviceSize freed = 0;
+    int numEvicted = 0;
+
+    for (int i = 0; i < candidates.Size() && freed < bytes; i++) {
+        freed += candidates[i]->GetAllocSize();
+        candidates[i]->Evict();
+        m_evicted.Add(EvictedImage{candidates[i], pendingValue});
+        numEvicted++;
+    }
+
+    if (numEvicted > 0) {
+        spdlog::info("Evicted {} images, {} KB freed.", numEvicted, freed / 1024);
+    }
+
+    return freed;
+}
+
 Image *ImageManager::AllocImage(std::string name) {
-    if (name.length() >= MAX_PATH) {
-        spdlog::error("Image name \"{}\" is too long\n", name);
+    const NameId nameId = nameTable.Intern(name);
+    if (nameId == NAME_NONE) {
+        spdlog::error("Invalid image name \"{}\".", name);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have registered it since the caller looked it up.
+    Image * image = GetImage(nameId);
+    if (image != nullptr) {
+        return image;
     }
 
-    Image * image = new Image(name);
-    m_images.insert({ name, image });
+    image = new Image(name);
+    m_images.Set(nameId, image);
 
     return image;
 }
@@ -5,8 +5,14 @@
 #ifndef RELOAD_IMAGE_MANAGER_H
 #define RELOAD_IMAGE_MANAGER_H
 
-#include <unordered_map>
+#include <mutex>
+#include <string_view>
 #include "Image.h"
+#include "ImageLoader.h"
+#include "ReloadLib/Containers/HashTable.h"
+#include "ReloadLib/NameTable.h"
+#include "ReloadLib/sys/AsyncIO.h"
+#include "ReloadLib/sys/JobSystem.h"
 
 class ImageManager {
 public:
@@ -23,14 +29,22 @@ public:
     // If the load fails for any reason, the image will be filled in with the default
     // grid pattern.
     // Will automatically execute image programs if needed.
-//    Image *			ImageFromFile( const char *name,
-//                                        textureFilter_t filter, textureRepeat_t repeat, textureUsage_t usage, cubeFiles_t cubeMap = CF_2D );
+    // The file is read by the IO service, decoded on the job workers and uploaded
+    // by the render thread, the image returned right away samples the default
+    // image until then. May be called from any thread.
+    Image *			ImageFromFile(const char *name, TextureFilter filter, TextureRepeat repeat, TextureUsage usage);
+
+    // uploads the images the workers decoded, publishes the uploads the GPU
+    // finished and loads evicted images again once they're used. Called by the
+    // render thread at the start of every frame.
+    void				Update();
 
     // These images are for internal renderer use.  Names should start with "_".
     Image *			ScratchImage(std::string name, const ImageOpts & opts );
 
-    // look for a loaded image, whatever the parameters
-    Image *			GetImage(std::string name) const;
+    // look for a loaded image, whatever the parameters. Doesn't allocate.
+    Image *			GetImage(std::string_view name) const;
+    Image *			GetImage(NameId nameId) const;
 
     // The callback will be issued immediately, and later if images are reloaded or vid_restart
     // The callback function should call one of the idImage::Generate* functions to fill in the data
@@ -39,6 +53,11 @@ public:
     // purges all the images before a vid_restart
     void				PurgeAllImages();
 
+    // evicts the streamed images unused the longest until at least the given
+    // number of bytes is freed. Images used by the last submitted frame or
+    // since are kept. Returns the bytes freed.
+    VkDeviceSize		EvictImages(VkDeviceSize bytes);
+
     // reloads all apropriate images after a vid_restart
 //    void				ReloadImages( bool all );
 
@@ -56,8 +75,10 @@ public:
 //    void				PrintMemInfo( MemInfo_t *mi );
 
     // built-in images
-//    void				CreateIntrinsicImages();
+    void				CreateIntrinsicImages();
 
+    // registers a new image, or returns the one already registered under the name.
+    // nullptr if the name can't be interned.
     Image *			AllocImage(std::string name);
 
     // the image has to be already loaded ( most straightforward way would be through a FindMaterial )
@@ -90,7 +111,40 @@ public:
 
     //--------------------------------------------------------
 
-    std::unordered_map<std::string, Image *> m_images;
+    // Keyed by the interned image name.
+    HashTable<NameId, Image *> m_images;
+    mutable std::mutex	m_mutex;					// guards m_images, images are created from any thread
+
+private:
+    struct LoadRequest {
+        Image *			image;
+        ImageFileData	data;
+        bool			decoded;
+        uint8_t *		encoded;					// the file as read, until it's decoded
+        size_t			encodedSize;
+    };
+
+    struct PendingUpload {
+        Image *			image;
+        uint64_t		uploadId;					// staging upload of the image's pixels
+    };
+
+    struct EvictedImage {
+        Image *			image;
+        uint64_t		evictedValue;				// used again once touched at or past this value
+    };
+
+    void				QueueLoad(Image * image);
+    void				UploadImage(LoadRequest * request);
+    static void			ReadDone(IoResult & result);
+    static void			DecodeJob(void * data);
+    void				FinishDecode(LoadRequest * request);
+
+    JobCounter			m_loadCounter;				// decode jobs in flight
+    std::mutex			m_decodedMutex;
+    List<LoadRequest *>	m_decoded;					// decoded by the workers, waiting for the render thread
+    List<PendingUpload>	m_uploads;
+    List<EvictedImage>	m_evicted;
 };
 
 extern ImageManager	* globalImages;
@@ -3,3 +3,75 @@
 //
 
 #include "Material.h"
+
+#include "Image.h"
+#include "ImageManager.h"
+
+/*
+================================================================================
+Material::Material
+
+DESCRIPTION:
+Creates a material without any images bound.
+================================================================================
+*/
+Material::Material(std::string name) : m_name(std::move(name)), m_images() {}
+
+/*
+================================================================================
+Material::SetImage
+
+DESCRIPTION:
+Binds the image to the parm, nullptr unbinds it.
+================================================================================
+*/
+void Material::SetImage(int parm, Image *image) {
+    assert(parm >= 0 && parm < MAX_IMAGE_PARMS);
+    m_images[parm] = image;
+}
+
+/*
+================================================================================
+Material::SetImageFromFile
+
+DESCRIPTION:
+Binds the image of the file to the parm. The file is read and decoded in the
+background by ImageManager::ImageFromFile, so this doesn't block and may be
+called from any thread. Images already registered under the name are shared.
+================================================================================
+*/
+void Material::SetImageFromFile(int parm, const char *name, TextureFilter filter, TextureRepeat repeat, TextureUsage usage) {
+    SetImage(parm, globalImages->ImageFromFile(name, filter, repeat, usage));
+}
+
+/*
+================================================================================
+Material::GetImage
+
+RETURNS:
+The image bound to the parm, nullptr if there is none.
+================================================================================
+*/
+Image * Material::GetImage(int parm) const {
+    assert(parm >= 0 && parm < MAX_IMAGE_PARMS);
+    return m_images[parm];
+}
+
+/*
+================================================================================
+Material::GetBindlessIndices
+
+DESCRIPTION:
+Fills the push constants with the bindless indices of the images. Unbound parms
+get the default image, so a shader sampling them never reads an empty slot.
+Called from the job workers recording the view.
+================================================================================
+*/
+void Material::GetBindlessIndices(DrawPushConstants &pushConstants) const {
+    const Image * defaultImage = globalImages->m_defaultImage;
+    const uint32_t defaultIndex = defaultImage != nullptr ? defaultImage->GetBindlessIndex() : BINDLESS_INVALID_INDEX;
+
+    for (int i = 0; i < MAX_IMAGE_PARMS; i++) {
+        pushConstants.images[i] = m_images[i] != nullptr ? m_images[i]->GetBindlessIndex() : defaultIndex;
+    }
+}
@@ -5,9 +5,44 @@
 #ifndef RELOAD_MATERIAL_H
 #define RELOAD_MATERIAL_H
 
+#include <string>
+#include "RenderCommon.h"
+
+class Image;
+
+/*
+================================================================================
+Material
+
+DESCRIPTION:
+What a surface is drawn with: the images bound to its parms. Draws push the
+bindless indices of the images, and the shaders of the surface's program index
+the bindless image array with them, so changing materials between draws costs
+no descriptor updates.
+
+Image files are loaded through the image manager's streaming path, the parm
+samples the default image until the file is read, decoded and uploaded.
+
+NOTE:
+The images are read by the job workers recording the view, so the parms must
+not change while a frame that draws the material is being recorded.
+================================================================================
+*/
 class Material {
+public:
+    explicit        Material(std::string name);
 
-};
+    void            SetImage(int parm, Image *image);                           // Binds the image to the parm, nullptr unbinds it.
+    void            SetImageFromFile(int parm, const char *name, TextureFilter filter = TF_DEFAULT,
+                                     TextureRepeat repeat = TR_REPEAT, TextureUsage usage = TD_DEFAULT);    // Binds the image file to the parm, loaded in the background.
+    void            GetBindlessIndices(DrawPushConstants &pushConstants) const; // Fills the image indices, the default image's for unbound parms.
 
+    [[nodiscard]] Image *               GetImage(int parm) const;
+    [[nodiscard]] const std::string &   GetName() const { return m_name; }
+
+private:
+    std::string     m_name;
+    Image *         m_images[MAX_IMAGE_PARMS];
+};
 
 #endif //RELOAD_MATERIAL_H
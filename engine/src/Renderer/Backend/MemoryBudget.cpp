@@ -0,0 +1,217 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "MemoryBudget.h"
+
+#include <algorithm>
+#include "ConfigManager.h"
+#include "Defragmenter.h"
+#include "GpuTimeline.h"
+
+MemoryBudget memoryBudget;
+
+/*
+================================================================================
+MemoryBudget::MemoryBudget
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+MemoryBudget::MemoryBudget()
+        : m_budgets{}
+        , m_deviceLocalHeaps(0)
+        , m_cap(0)
+        , m_overcommit(0)
+        , m_evictionValue(0)
+        , m_compacting(false)
+        , m_overBudget(false) {}
+
+/*
+================================================================================
+MemoryBudget::~MemoryBudget
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+MemoryBudget::~MemoryBudget() = default;
+
+/*
+================================================================================
+MemoryBudget::Init
+
+DESCRIPTION:
+Finds the device local heaps of the GPU and fetches their first budgets. Called
+once the VMA allocator is created.
+================================================================================
+*/
+void MemoryBudget::Init() {
+    const VkPhysicalDeviceMemoryProperties & memProps = vkContext.gpu.memProps;
+
+    m_deviceLocalHeaps = 0;
+    for (uint32_t i = 0; i < memProps.memoryHeapCount; i++) {
+        if (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            m_deviceLocalHeaps |= 1u << i;
+        }
+    }
+
+    m_cap = static_cast<VkDeviceSize>(vkConfig.deviceLocalMemoryMB) * 1024 * 1024;
+    m_overcommit = 0;
+    m_evictionValue = 0;
+    m_compacting = false;
+    m_overBudget = false;
+
+    vmaGetBudget(vmaAllocator, m_budgets);
+
+    SDL_LogInfo(LOG_RENDER, "Device local memory budget %llu MB%s.",
+                static_cast<unsigned long long>(Budget() / (1024 * 1024)),
+                vkContext.gpu.memoryBudget ? "" : ", estimated without VK_EXT_memory_budget");
+}
+
+/*
+================================================================================
+MemoryBudget::Update
+
+DESCRIPTION:
+Moves VMA to the next frame, which refreshes the budgets from the driver, and
+works out how much the device local heaps are over their targets.
+================================================================================
+*/
+void MemoryBudget::Update() {
+    vmaSetCurrentFrameIndex(vmaAllocator, static_cast<uint32_t>(gpuTimeline.PendingValue()));
+    vmaGetBudget(vmaAllocator, m_budgets);
+
+    m_overcommit = 0;
+
+    // The usage doesn't drop until the last eviction is freed and its blocks
+    // are emptied, don't count it twice.
+    if (m_evictionValue != 0) {
+        if (!gpuTimeline.IsComplete(m_evictionValue)) {
+            return;
+        }
+
+        m_evictionValue = 0;
+        m_compacting = true;
+        defragmenter.Wake();
+        return;
+    }
+
+    if (m_compacting) {
+        if (!defragmenter.IsIdle()) {
+            return;
+        }
+        m_compacting = false;
+    }
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+        if ((m_deviceLocalHeaps & (1u << i)) == 0) {
+            continue;
+        }
+
+        const VkDeviceSize budget = HeapBudget(i);
+        const VkDeviceSize usage = HeapUsage(i);
+
+        if (usage > budget / 100 * MEMORY_BUDGET_EVICT_PERCENT) {
+            m_overcommit += usage - budget / 100 * MEMORY_BUDGET_TARGET_PERCENT;
+        }
+    }
+
+    const bool overBudget = m_overcommit > 0;
+    if (overBudget != m_overBudget) {
+        if (overBudget) {
+            SDL_LogWarn(LOG_RENDER, "Device local memory over budget, %llu MB of %llu MB used.",
+                        static_cast<unsigned long long>(Usage() / (1024 * 1024)),
+                        static_cast<unsigned long long>(Budget() / (1024 * 1024)));
+        } else {
+            SDL_LogInfo(LOG_RENDER, "Device local memory back under budget.");
+        }
+        m_overBudget = overBudget;
+    }
+}
+
+/*
+================================================================================
+MemoryBudget::Evicted
+
+DESCRIPTION:
+Holds back the overcommit until the GPU timeline passes the frames that may
+still use the evicted memory, and the defragmenter compacted the blocks.
+================================================================================
+*/
+void MemoryBudget::Evicted(VkDeviceSize bytes) {
+    if (bytes > 0) {
+        m_evictionValue = gpuTimeline.PendingValue();
+    }
+}
+
+/*
+================================================================================
+MemoryBudget::Usage
+
+RETURNS:
+The usage of the device local heaps, as of the last update.
+================================================================================
+*/
+VkDeviceSize MemoryBudget::Usage() const {
+    VkDeviceSize usage = 0;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+        if (m_deviceLocalHeaps & (1u << i)) {
+            usage += HeapUsage(i);
+        }
+    }
+
+    return usage;
+}
+
+/*
+================================================================================
+MemoryBudget::Budget
+
+RETURNS:
+The budget of the device local heaps with the cap applied, as of the last update.
+================================================================================
+*/
+VkDeviceSize MemoryBudget::Budget() const {
+    VkDeviceSize budget = 0;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+        if (m_deviceLocalHeaps & (1u << i)) {
+            budget += HeapBudget(i);
+        }
+    }
+
+    return budget;
+}
+
+/*
+================================================================================
+MemoryBudget::HeapUsage
+
+DESCRIPTION:
+The free space in the blocks counts as used, the driver can't hand it to anyone
+else. Evicting leaves holes in the blocks, the defragmenter packs the remaining
+images together, and VMA gives the blocks that end up empty back to the heap.
+
+RETURNS:
+The bytes of the heap's blocks, or what the driver reports if that's more, like
+the swapchain and pipelines.
+================================================================================
+*/
+VkDeviceSize MemoryBudget::HeapUsage(uint32_t heap) const {
+    const VmaBudget & budget = m_budgets[heap];
+
+    return std::max(budget.usage, budget.blockBytes);
+}
+
+/*
+================================================================================
+MemoryBudget::HeapBudget
+
+RETURNS:
+The budget of the heap, lowered to the cap of the config.
+================================================================================
+*/
+VkDeviceSize MemoryBudget::HeapBudget(uint32_t heap) const {
+    return m_cap > 0 ? std::min(m_budgets[heap].budget, m_cap) : m_budgets[heap].budget;
+}
@@ -0,0 +1,66 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_MEMORY_BUDGET_H
+#define RELOAD_MEMORY_BUDGET_H
+
+#include "RenderCommon.h"
+#include "VulkanCommon.h"
+#include "VulkanMemory.h"
+
+/*
+================================================================================
+MemoryBudget
+
+DESCRIPTION:
+Watches the usage of the device local heaps against their budget, so the
+renderer can give memory back before the driver starts paging.
+
+The budget of a heap is what VMA reports for it, fetched from VK_EXT_memory_budget
+when the device supports it and estimated from the heap size otherwise, capped
+by deviceLocalMemoryMB of the config. The usage counts the memory blocks VMA
+holds, that's what the driver pages. Once it goes over
+MEMORY_BUDGET_EVICT_PERCENT of the budget, the overcommit is what has to be
+freed to get back down to MEMORY_BUDGET_TARGET_PERCENT. The gap between the two
+keeps the eviction from kicking in every frame.
+
+Evicted memory only goes back to its block once the deferred delete queue frees
+it, and the block only goes back to the heap once the defragmenter moved the
+rest of its images out. So no more overcommit is reported until the GPU is past
+the last eviction and the defragmenter, woken up by then, has nothing left to
+move.
+
+NOTE:
+Only used from the render thread.
+================================================================================
+*/
+class MemoryBudget {
+public:
+                    MemoryBudget();
+                    ~MemoryBudget();
+
+    void            Init();                                                     // Finds the device local heaps and applies the configured cap.
+    void            Update();                                                   // Fetches the budgets. Called once per frame.
+    void            Evicted(VkDeviceSize bytes);                                // Notes the memory released to pay off the overcommit.
+
+    [[nodiscard]] VkDeviceSize  Overcommit() const { return m_overcommit; }     // Bytes to free to get back under the target.
+    [[nodiscard]] VkDeviceSize  Usage() const;                                  // Usage of the device local heaps, as measured against the budget.
+    [[nodiscard]] VkDeviceSize  Budget() const;                                 // Budget of the device local heaps, with the cap applied.
+
+private:
+    [[nodiscard]] VkDeviceSize  HeapUsage(uint32_t heap) const;
+    [[nodiscard]] VkDeviceSize  HeapBudget(uint32_t heap) const;
+
+    VmaBudget               m_budgets[VK_MAX_MEMORY_HEAPS];
+    uint32_t                m_deviceLocalHeaps;                                 // Bit per device local heap.
+    VkDeviceSize            m_cap;                                              // Per heap, 0 for none.
+    VkDeviceSize            m_overcommit;
+    uint64_t                m_evictionValue;                                    // Timeline value after which the last eviction is freed.
+    bool                    m_compacting;                                       // Waiting for the defragmenter to free the blocks of the last eviction.
+    bool                    m_overBudget;                                       // Logs only when the state changes.
+};
+
+extern MemoryBudget memoryBudget;
+
+#endif //RELOAD_MEMORY_BUDGET_H
@@ -0,0 +1,235 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "PipelineCache.h"
+
+#include <filesystem>
+#include "ConfigManager.h"
+#include "VulkanHelpers.h"
+#include "ReloadLib/File.h"
+
+PipelineCache pipelineCache;
+
+namespace fs = std::filesystem;
+
+// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, at the start of the cache data.
+struct PipelineCacheHeader {
+    uint32_t            headerSize;
+    uint32_t            headerVersion;
+    uint32_t            vendorID;
+    uint32_t            deviceID;
+    uint8_t             pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+/*
+================================================================================
+PipelineCache::PipelineCache
+
+DESCRIPTION:
+The default constructor.
+================================================================================
+*/
+PipelineCache::PipelineCache() : m_savedSize(0), m_lastSaveTime(0) {}
+
+/*
+================================================================================
+PipelineCache::~PipelineCache
+
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+PipelineCache::~PipelineCache() = default;
+
+/*
+================================================================================
+PipelineCache::Init
+
+DESCRIPTION:
+Loads the saved cache from the preference directory and creates the pipeline
+cache with it. Missing, oversized or foreign data is ignored and the cache
+starts empty.
+================================================================================
+*/
+void PipelineCache::Init() {
+    m_path.clear();
+    m_savedSize = 0;
+    m_lastSaveTime = SDL_GetTicks();
+
+    char * prefPath = SDL_GetPrefPath(vkConfig.engineName, vkConfig.programName);
+    if (prefPath != nullptr) {
+        m_path = std::string(prefPath) + "pipeline.cache";
+        SDL_free(prefPath);
+    } else {
+        SDL_LogWarn(LOG_RENDER, "No preference directory, the pipeline cache won't be saved: %s", SDL_GetError());
+    }
+
+    MappedFile file;
+    std::error_code error;
+    if (!m_path.empty() && fs::exists(m_path, error) && file.Open(m_path.c_str())) {
+        if (!IsValid(file.Data().Data(), file.Size())) {
+            SDL_LogInfo(LOG_RENDER, "Discarding the pipeline cache, it was created for another GPU or driver.");
+            file.Close();
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (file.IsOpen()) {
+        pipelineCacheCreateInfo.initialDataSize = file.Size();
+        pipelineCacheCreateInfo.pInitialData = file.Data().Data();
+        m_savedSize = file.Size();
+    }
+
+    VK_CHECK(vkCreatePipelineCache(
+            vkContext.device,
+            &pipelineCacheCreateInfo,
+            nullptr,
+            &vkContext.pipelineCache))
+
+    if (m_savedSize > 0) {
+        SDL_LogInfo(LOG_RENDER, "Loaded %zu KB of pipeline cache.", m_savedSize / 1024);
+    }
+}
+
+/*
+================================================================================
+PipelineCache::Shutdown
+
+DESCRIPTION:
+Waits for a periodic save still in progress, saves the final state of the cache
+and destroys it.
+================================================================================
+*/
+void PipelineCache::Shutdown() {
+    jobSystem.Wait(&m_saveCounter);
+
+    if (!m_path.empty() && FetchData()) {
+        SaveJob(this);
+    }
+
+    vkDestroyPipelineCache(vkContext.device, vkContext.pipelineCache, nullptr);
+    vkContext.pipelineCache = VK_NULL_HANDLE;
+
+    m_saveData.Clear();
+}
+
+/*
+================================================================================
+PipelineCache::Update
+
+DESCRIPTION:
+Every PIPELINE_CACHE_SAVE_INTERVAL_MS checks whether the cache grew since it was
+last saved and if so hands a copy of it to a job that writes it to disk.
+================================================================================
+*/
+void PipelineCache::Update() {
+    if (m_path.empty() || !m_saveCounter.IsDone()) {
+        return;
+    }
+
+    const uint32_t now = SDL_GetTicks();
+    if (now - m_lastSaveTime < PIPELINE_CACHE_SAVE_INTERVAL_MS) {
+        return;
+    }
+    m_lastSaveTime = now;
+
+    if (!FetchData()) {
+        return;
+    }
+
+    Job job;
+    job.func = &PipelineCache::SaveJob;
+    job.data = this;
+    jobSystem.RunBackground(&job, 1, &m_saveCounter);
+}
+
+/*
+================================================================================
+PipelineCache::IsValid
+
+DESCRIPTION:
+Checks the size and the version one header of the saved data against the
+properties of the selected GPU.
+
+RETURNS:
+`true` if the data can be given to the driver.
+================================================================================
+*/
+bool PipelineCache::IsValid(const uint8_t *data, size_t size) const {
+    if (size < sizeof(PipelineCacheHeader) || size > PIPELINE_CACHE_MAX_SIZE) {
+        return false;
+    }
+
+    PipelineCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    const VkPhysicalDeviceProperties & props = vkContext.gpu.props;
+
+    return header.headerSize >= sizeof(PipelineCacheHeader)
+        && header.headerSize <= size
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == props.vendorID
+        && header.deviceID == props.deviceID
+        && memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/*
+================================================================================
+PipelineCache::FetchData
+
+DESCRIPTION:
+Copies the current cache data into m_saveData, unless it didn't grow since the
+last save or is over the size cap.
+
+RETURNS:
+`true` if there is new data to save.
+================================================================================
+*/
+bool PipelineCache::FetchData() {
+    size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(vkContext.device, vkContext.pipelineCache, &size, nullptr))
+
+    if (size == m_savedSize) {
+        return false;
+    }
+
+    if (size > PIPELINE_CACHE_MAX_SIZE) {
+        SDL_LogWarn(LOG_RENDER, "The pipeline cache is %zu MB, not saving it.", size / 1024 / 1024);
+        m_savedSize = size;
+        return false;
+    }
+
+    m_saveData.SetSize(static_cast<int>(size));
+
+    // The cache can grow in between the two calls, the driver then returns
+    // VK_INCOMPLETE with as much as fits, which is still a valid cache.
+    const VkResult result = vkGetPipelineCacheData(vkContext.device, vkContext.pipelineCache, &size, m_saveData.Data());
+    if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+        SDL_LogWarn(LOG_RENDER, "Couldn't get the pipeline cache data.");
+        return false;
+    }
+
+    m_saveData.SetSize(static_cast<int>(size));
+    m_savedSize = size;
+    return true;
+}
+
+/*
+================================================================================
+PipelineCache::SaveJob
+
+DESCRIPTION:
+Writes the fetched cache data to the preference directory.
+================================================================================
+*/
+void PipelineCache::SaveJob(void *data) {
+    auto * cache = static_cast<PipelineCache *>(data);
+
+    const auto size = static_cast<size_t>(cache->m_saveData.Size());
+    if (!WriteFileAtomically(cache->m_path.c_str(), cache->m_saveData.Data(), size)) {
+        SDL_LogWarn(LOG_RENDER, "Couldn't write the pipeline cache to %s.", cache->m_path.c_str());
+    }
+}
@@ -0,0 +1,54 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_PIPELINE_CACHE_H
+#define RELOAD_PIPELINE_CACHE_H
+
+#include <string>
+#include "RenderCommon.h"
+#include "VulkanCommon.h"
+#include "ReloadLib/sys/JobSystem.h"
+
+/*
+================================================================================
+PipelineCache
+
+DESCRIPTION:
+Keeps `vkContext.pipelineCache` on disk between runs, in the user's preference
+directory. On startup the saved data is only handed to the driver when its
+header matches the vendor, device and pipeline cache UUID of the selected GPU,
+so a driver update or another GPU starts with an empty cache instead of feeding
+the driver foreign data.
+
+The cache is saved on shutdown and every PIPELINE_CACHE_SAVE_INTERVAL_MS while
+it keeps growing, so a crash doesn't lose the pipelines compiled so far. The
+data is fetched on the render thread and written by a job, to a temporary file
+that is renamed over the old one, so the file on disk is always complete.
+Caches larger than PIPELINE_CACHE_MAX_SIZE are neither loaded nor saved.
+================================================================================
+*/
+class PipelineCache {
+public:
+                    PipelineCache();
+                    ~PipelineCache();
+
+    void            Init();                                                     // Creates the pipeline cache from the saved data, if it's valid.
+    void            Shutdown();                                                 // Saves and destroys the pipeline cache.
+    void            Update();                                                   // Saves the cache periodically, called once per frame.
+
+private:
+    bool            IsValid(const uint8_t *data, size_t size) const;            // Checks the header against the selected GPU.
+    bool            FetchData();                                                // Copies the cache data into m_saveData.
+    static void     SaveJob(void *data);                                        // Writes m_saveData to the file.
+
+    std::string     m_path;                                                     // Empty when there's no preference directory.
+    size_t          m_savedSize;                                                // Size of the data last saved or loaded.
+    uint32_t        m_lastSaveTime;                                             // SDL ticks of the last periodic check.
+    List<uint8_t>   m_saveData;                                                 // Owned by the save job while it runs.
+    JobCounter      m_saveCounter;
+};
+
+extern PipelineCache pipelineCache;
+
+#endif //RELOAD_PIPELINE_CACHE_H
@@ -4,10 +4,20 @@
 #include "Windowing/Window.h"
 #include "VulkanHelpers.h"
 #include "StagingManager.h"
+#include "GpuTimeline.h"
+#include "DeferredDelete.h"
+#include "PipelineCache.h"
+#include "DescriptorManager.h"
+#include "BufferManager.h"
+#include "MemoryBudget.h"
+#include "Defragmenter.h"
+#include "RenderPipelineManager.h"
 #include "Image.h"
 #include "ImageManager.h"
+#include "Material.h"
 #include "RenderState.h"
 #include "RenderLog.h"
+#include "ReloadLib/sys/JobSystem.h"
 
 extern VmaAllocation        vmaAllocation;
 extern VmaAllocationInfo	vmaAllocationInfo;
@@ -20,9 +30,20 @@ const char * VK_LAYER_KHRONOS_VALIDATION_NAME = "VK_LAYER_KHRONOS_validation";
 static VkDebugReportCallbackEXT s_debugReportCallback = VK_NULL_HANDLE;
 
 static ExtList g_debugExtensions({VK_EXT_DEBUG_REPORT_EXTENSION_NAME });
-static ExtList g_deviceExtensions({VK_KHR_SWAPCHAIN_EXTENSION_NAME });
+// Timeline semaphores are core in 1.2, the engine targets 1.1 so it needs the
+// extension.
+static ExtList g_deviceExtensions({
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+    VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+    VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+});
 static ExtList g_validationLayers({VK_LAYER_KHRONOS_VALIDATION_NAME });
 
+static const int DRAW_SURFS_PER_BATCH = 256;                                    // Surfaces recorded into one secondary command buffer.
+static const float POLYGON_OFFSET_SCALE = -1.0f;                                // Slope factor of GLS_POLYGON_OFFSET surfaces.
+static const float POLYGON_OFFSET_BIAS = -2.0f;                                 // Constant factor of GLS_POLYGON_OFFSET surfaces.
+
 // Internal Helpers
 
 /*
@@ -160,23 +181,6 @@ static void DestroyDebugReportCallback(VkInstance instance) {
     func(instance, s_debugReportCallback, nullptr);
 }
 
-/*
-================================================================================
-CreatePipelineCache
-DESCRIPTION:
-Creates a pipline cache.
-================================================================================
-*/
-static void CreatePipelineCache() {
-    VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    VK_CHECK(vkCreatePipelineCache(
-            vkContext.device,
-            &pipelineCacheCreateInfo,
-            nullptr,
-            &vkContext.pipelineCache))
-}
-
 /*
 ================================================================================
 ChooseSupportedFormat
@@ -265,6 +269,7 @@ Clears and resets all the values.
 void RenderBackend::Clear() {
     m_counter = 0;
     m_currentFrame = 0;
+    m_viewDef = nullptr;
 
     vkInstance = VK_NULL_HANDLE;
 
@@ -274,6 +279,7 @@ void RenderBackend::Clear() {
     m_swapchain = VK_NULL_HANDLE;
     m_swapchainFormat = VK_FORMAT_UNDEFINED;
     m_currentSwapIdx = 0;
+    m_numSwapchainImages = 0;
 
     m_currentImage = VK_NULL_HANDLE;
     m_currentImageView = VK_NULL_HANDLE;
@@ -283,8 +289,8 @@ void RenderBackend::Clear() {
     std::fill(m_swapchainViews.begin(), m_swapchainViews.end(), nullptr);
     std::fill(m_frameBuffers.begin(), m_frameBuffers.end(), nullptr);
     std::fill(m_commandBuffers.begin(), m_commandBuffers.end(), nullptr);
-    std::fill(m_inFlightFences.begin(), m_inFlightFences.end(), nullptr);
-    std::fill(m_commandBufferRecorded.begin(), m_commandBufferRecorded.end(), false);
+    std::fill(m_frameValues.begin(), m_frameValues.end(), 0);
+    std::fill(m_swapImageValues.begin(), m_swapImageValues.end(), 0);
     std::fill(m_imgAvailableSemaphores.begin(), m_imgAvailableSemaphores.end(), nullptr);
     std::fill(m_renderCompleteSemaphores.begin(), m_renderCompleteSemaphores.end(), nullptr);
     std::fill(m_queryIndex.begin(), m_queryIndex.end(), 0);
@@ -305,6 +311,8 @@ Initializes the render backend.
 ================================================================================
 */
 void RenderBackend::Init() {
+    Mem::InitFrameArenas(MAX_FRAMES_IN_FLIGHT, FRAME_MEMORY_SIZE);
+
     windowManager.EnumerateDisplays();
     windowManager.CreateSDLWindow();
 
@@ -314,6 +322,7 @@ void RenderBackend::Init() {
     CreateSurface();
     SelectBestGpu();
     CreateLogicalDeviceAndQueues();
+    gpuTimeline.Init();
     CreateQueryPool();
     CreateCommandPool();
     CreateCommandBuffer();
@@ -338,21 +347,29 @@ void RenderBackend::Init() {
     funcs.vkCmdCopyBuffer = vkCmdCopyBuffer;
     funcs.vkGetBufferMemoryRequirements2KHR = vkGetBufferMemoryRequirements2KHR;
     funcs.vkGetImageMemoryRequirements2KHR = vkGetImageMemoryRequirements2KHR;
+    funcs.vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2;
 
     VmaAllocatorCreateInfo vmaInfo = {};
     vmaInfo.physicalDevice = vkContext.gpu.device;
     vmaInfo.device = vkContext.device;
     vmaInfo.instance = vkInstance;
     vmaInfo.pVulkanFunctions = &funcs;
+    if (vkContext.gpu.memoryBudget) {
+        vmaInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
 //    createInfo.preferredSmallHeapBlockSize = vkConfig.uploadBufferSizeMB * 1024 * 1024;
 //    createInfo.preferredLargeHeapBlockSize = vkConfig.deviceLocalMemoryMB * 1024 * 1024;
     vmaCreateAllocator(&vmaInfo, &vmaAllocator);
 
+    memoryBudget.Init();
     stagingManager.Init();
+    bufferManager.Init();
     CreateSwapchain();
     CreateRenderTargets();
     CreateRenderPass();
-    CreatePipelineCache();
+    pipelineCache.Init();
+    descriptorManager.Init();
+    renderPipelineManager.Init();
     CreateFrameBuffers();
     CreateSyncObjects();
 }
@@ -366,21 +383,31 @@ Shuts down the render backend.
 ================================================================================
 */
 void RenderBackend::Shutdown() {
+    // Nothing below may still be in use by the GPU.
+    gpuTimeline.Wait(gpuTimeline.SubmittedValue());
+
+    defragmenter.Shutdown();
     DestroySyncObjects();
     DestroyFrameBuffers();
 
-    vkDestroyPipelineCache(vkContext.device, vkContext.pipelineCache, nullptr);
+    renderPipelineManager.Shutdown();
+    descriptorManager.Shutdown();
+    pipelineCache.Shutdown();
     vkDestroyRenderPass(vkContext.device, vkContext.renderPass, nullptr);
 
     DestroyRenderTargets();
     DestroySwapchain();
 
     stagingManager.Shutdown();
+    bufferManager.Shutdown();
+    deferredDelete.Flush();
 
     vmaDestroyAllocator(vmaAllocator);
     vkFreeCommandBuffers(vkContext.device, m_commandPool, MAX_FRAMES_IN_FLIGHT, m_commandBuffers.data());
     vkDestroyCommandPool(vkContext.device, m_commandPool, nullptr);
+    m_secondaryPools.Shutdown();
     DestroyQueryPool();
+    gpuTimeline.Shutdown();
 
     if (vkConfig.enableDebugLayer) {
         DestroyDebugReportCallback(vkInstance);
@@ -394,6 +421,8 @@ void RenderBackend::Shutdown() {
     Clear();
 
     windowManager.DestroyWindow();
+
+    Mem::ShutdownFrameArenas();
 }
 
 /*
@@ -621,6 +650,45 @@ GPU RenderBackend::GetDeviceInfo(VkPhysicalDevice device) {
     vkGetPhysicalDeviceProperties(gpu.device, &gpu.props);
     vkGetPhysicalDeviceFeatures(gpu.device, &gpu.features);
 
+    // Descriptor indexing, for the bindless image array. Only queried when the
+    // extension is there, its structures are invalid otherwise.
+    ExtList descriptorIndexingExt({ VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME });
+    if (CheckExtSupport(gpu, descriptorIndexingExt)) {
+        gpu.descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        gpu.descriptorIndexingProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &gpu.descriptorIndexingFeatures;
+        vkGetPhysicalDeviceFeatures2(gpu.device, &features2);
+
+        VkPhysicalDeviceProperties2 props2 = {};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props2.pNext = &gpu.descriptorIndexingProps;
+        vkGetPhysicalDeviceProperties2(gpu.device, &props2);
+
+        // The GPU info is copied around, don't keep pointers into it.
+        gpu.descriptorIndexingFeatures.pNext = nullptr;
+        gpu.descriptorIndexingProps.pNext = nullptr;
+    }
+
+    // Timeline semaphores, frames and released resources are retired on one.
+    ExtList timelineSemaphoreExt({ VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME });
+    if (CheckExtSupport(gpu, timelineSemaphoreExt)) {
+        gpu.timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &gpu.timelineSemaphoreFeatures;
+        vkGetPhysicalDeviceFeatures2(gpu.device, &features2);
+
+        gpu.timelineSemaphoreFeatures.pNext = nullptr;
+    }
+
+    // Optional, the memory budget is estimated from the heap sizes without it.
+    ExtList memoryBudgetExt({ VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+    gpu.memoryBudget = CheckExtSupport(gpu, memoryBudgetExt);
+
     if (gpu.props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
         gpu.score += 1000;
     }
@@ -635,7 +703,8 @@ GPU RenderBackend::GetDeviceInfo(VkPhysicalDevice device) {
 RenderBackend::SelectBestGpu
 
 DESCRIPTION:
-Selects the best graphics device available on the system.
+Selects the best graphics device available on the system. Devices without the
+features the renderer can't do without are skipped.
 ================================================================================
 */
 void RenderBackend::SelectBestGpu() {
@@ -652,12 +721,30 @@ void RenderBackend::SelectBestGpu() {
     for (VkPhysicalDevice &device : devices) {
         GPU gpu = GetDeviceInfo(device);
 
+        if (!gpu.timelineSemaphoreFeatures.timelineSemaphore) {
+            SDL_LogInfo(LOG_VIDEO, "Skipping %s, it doesn't support timeline semaphores.", gpu.props.deviceName);
+            continue;
+        }
+
+        const VkPhysicalDeviceDescriptorIndexingFeaturesEXT & indexing = gpu.descriptorIndexingFeatures;
+        if (!indexing.shaderSampledImageArrayNonUniformIndexing || !indexing.runtimeDescriptorArray
+            || !indexing.descriptorBindingPartiallyBound || !indexing.descriptorBindingSampledImageUpdateAfterBind
+            || !indexing.descriptorBindingUpdateUnusedWhilePending) {
+            SDL_LogInfo(LOG_VIDEO, "Skipping %s, it doesn't support descriptor indexing for bindless images.", gpu.props.deviceName);
+            continue;
+        }
+
         if (gpu.score >= bestScore) {
             bestScore = gpu.score;
             bestGpu = gpu;
         }
     }
 
+    if (bestScore < 0) {
+        Log_GpuCritical("No GPU supports the required features.");
+        exit(1);
+    }
+
 #ifdef RLD_DEBUG
     Log_PhysicalDeviceInfo(bestGpu);
 #endif
@@ -667,6 +754,10 @@ void RenderBackend::SelectBestGpu() {
         exit(1);
     }
 
+    if (bestGpu.memoryBudget) {
+        m_deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
     if (bestGpu.surfaceFormats.empty()) {
         Log_GpuCritical("GPU doesn't support surface formats.");
         exit(1);
@@ -677,6 +768,9 @@ void RenderBackend::SelectBestGpu() {
         exit(1);
     }
 
+    // The queue families below are recorded on the selected GPU.
+    vkContext.gpu = bestGpu;
+
     // Find graphics queue family
     size_t numQueueFamilyProps = bestGpu.queueFamilyProps.size();
 
@@ -713,8 +807,10 @@ void RenderBackend::SelectBestGpu() {
             continue;
         }
 
-        // Check for transfer support.
-        if (bestGpu.queueFamilyProps[i].queueFlags & VK_QUEUE_TRANSFER_BIT) {
+        // Check for transfer support. Only families without graphics and
+        // compute are used, those map to the dedicated DMA engines.
+        const VkQueueFlags flags = bestGpu.queueFamilyProps[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
             vkContext.transferFamilyIdx = static_cast<int>(i);
             vkContext.gpu.supportedQueues |= VK_QUEUE_TRANSFER_BIT;
             continue;
@@ -733,8 +829,6 @@ void RenderBackend::SelectBestGpu() {
     if (vkContext.transferFamilyIdx < 0) {
         Log_GpuWarn("GPU doesn't support transfer queue family");
     }
-
-    vkContext.gpu = bestGpu;
 }
 
 /*
@@ -797,8 +891,23 @@ void RenderBackend::CreateLogicalDeviceAndQueues() {
         deviceFeatures.textureCompressionETC2 = VK_TRUE;
     }
 
+    // Supported, SelectBestGpu skips the devices without it.
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    timelineFeatures.pNext = &indexingFeatures;
+
     VkDeviceCreateInfo deviceInfo = {};
     deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext = &timelineFeatures;
     deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
     deviceInfo.pQueueCreateInfos = queueInfos.data();
     deviceInfo.pEnabledFeatures = &deviceFeatures;
@@ -900,10 +1009,16 @@ void RenderBackend::CreateSwapchain() {
     VkPresentModeKHR presentMode = ChoosePresentMode(gpu.presentModes);
     VkExtent2D extent = ChooseSurfaceExtent(gpu.surfaceCaps);
 
+    // A max image count of 0 means there is no limit.
+    uint32_t minImageCount = std::max(MAX_FRAMES_IN_FLIGHT, gpu.surfaceCaps.minImageCount);
+    if (gpu.surfaceCaps.maxImageCount > 0) {
+        minImageCount = std::min(minImageCount, gpu.surfaceCaps.maxImageCount);
+    }
+
     VkSwapchainCreateInfoKHR info = {};
     info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     info.surface = m_surface;
-    info.minImageCount = MAX_FRAMES_IN_FLIGHT;
+    info.minImageCount = minImageCount;
     info.imageFormat = surfaceFormat.format;
     info.imageColorSpace = surfaceFormat.colorSpace;
     info.imageExtent = extent;
@@ -941,10 +1056,12 @@ void RenderBackend::CreateSwapchain() {
     uint32_t numImages = 0;
     VK_CHECK(vkGetSwapchainImagesKHR(vkContext.device, m_swapchain, &numImages, nullptr))
     VK_VALIDATE(numImages > 0, "vkGetSwapchainImagesKHR returned a zero image count.")
+    VK_VALIDATE(numImages <= MAX_SWAPCHAIN_IMAGES, "vkGetSwapchainImagesKHR returned more than MAX_SWAPCHAIN_IMAGES images.")
 
     VK_CHECK(vkGetSwapchainImagesKHR(vkContext.device, m_swapchain, &numImages, m_swapchainImages.data()))
+    m_numSwapchainImages = numImages;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i ) {
+    for (uint32_t i = 0; i < m_numSwapchainImages; ++i ) {
         VkImageViewCreateInfo imageViewCreateInfo = {};
         imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         imageViewCreateInfo.image = m_swapchainImages[i];
@@ -974,7 +1091,7 @@ Destroys the swap chain.
 ================================================================================
 */
 void RenderBackend::DestroySwapchain() {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32_t i = 0; i < m_numSwapchainImages; i++) {
         vkDestroyImageView(vkContext.device, m_swapchainViews[i], nullptr);
     }
 
@@ -1014,7 +1131,7 @@ void RenderBackend::CreateFrameBuffers() {
     frameBufferCreateInfo.height = m_swapchainExtent.height;
     frameBufferCreateInfo.layers = 1;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i ) {
+    for (uint32_t i = 0; i < m_numSwapchainImages; ++i ) {
         attachments[0] = m_swapchainViews[i];
         VK_CHECK(vkCreateFramebuffer(
                 vkContext.device,
@@ -1033,8 +1150,9 @@ Destroys frame buffers.
 ================================================================================
 */
 void RenderBackend::DestroyFrameBuffers() {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyFramebuffer(vkContext.device, m_frameBuffers[i], nullptr);
+    for (uint32_t i = 0; i < m_numSwapchainImages; i++) {
+        deferredDelete.ReleaseFramebuffer(m_frameBuffers[i]);
+        m_frameBuffers[i] = VK_NULL_HANDLE;
     }
 }
 
@@ -1044,31 +1162,18 @@ void RenderBackend::DestroyFrameBuffers() {
 RenderBackend::CreateSyncObjects
 
 DESCRIPTION:
-Creates the required semaphores and fences.
+Creates the binary semaphores the swap chain needs for acquiring and presenting
+the images. Frame pacing runs on the GPU timeline, which needs no fences.
 ================================================================================
 */
 void RenderBackend::CreateSyncObjects() {
-    // Create semaphores:
-//    VkSemaphoreTypeCreateInfo timelineCreateInfo = {};
-//    timelineCreateInfo.sType            = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
-//    timelineCreateInfo.pNext            = VK_NULL_HANDLE;
-//    timelineCreateInfo.semaphoreType    = VK_SEMAPHORE_TYPE_TIMELINE;
-//    timelineCreateInfo.initialValue     = 0;
-
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-//    semaphoreInfo.pNext = &timelineCreateInfo;
     semaphoreInfo.flags  = 0;
 
-    // Create fences
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ ) {
         VK_CHECK(vkCreateSemaphore(vkContext.device, &semaphoreInfo, nullptr, &m_imgAvailableSemaphores[i]))
         VK_CHECK(vkCreateSemaphore(vkContext.device, &semaphoreInfo, nullptr, &m_renderCompleteSemaphores[i]))
-        VK_CHECK(vkCreateFence(vkContext.device, &fenceInfo, nullptr, &m_inFlightFences[i]))
     }
 }
 
@@ -1077,7 +1182,7 @@ void RenderBackend::CreateSyncObjects() {
 RenderBackend::DestroySyncObjects
 
 DESCRIPTION:
-Destroys the semaphores and fences.
+Destroys the semaphores.
 ================================================================================
 */
 void RenderBackend::DestroySyncObjects() {
@@ -1085,7 +1190,6 @@ void RenderBackend::DestroySyncObjects() {
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i ) {
         vkDestroySemaphore(vkContext.device, m_imgAvailableSemaphores[i], nullptr);
         vkDestroySemaphore(vkContext.device, m_renderCompleteSemaphores[i], nullptr);
-        vkDestroyFence(vkContext.device, m_inFlightFences[i], nullptr);
     }
 }
 
@@ -1127,7 +1231,8 @@ void RenderBackend::DestroyQueryPool() {
 RenderBackend::CreateCommandPool
 
 DESCRIPTION:
-Creates the command pool.
+Creates the command pool of the primary buffers and the per thread pools of the
+secondary buffers.
 ================================================================================
 */
 void RenderBackend::CreateCommandPool() {
@@ -1137,6 +1242,8 @@ void RenderBackend::CreateCommandPool() {
     createInfo.queueFamilyIndex = static_cast<uint32_t>(vkContext.graphicsFamilyIdx);
 
     VK_CHECK(vkCreateCommandPool(vkContext.device, &createInfo, nullptr, &m_commandPool))
+
+    m_secondaryPools.Init(createInfo.queueFamilyIndex, jobSystem.NumThreads());
 }
 
 /*
@@ -1378,6 +1485,7 @@ Clears the view/screen with the specified color.
 ================================================================================
 */
 void RenderBackend::ClearView(
+        VkCommandBuffer commandBuffer,
         bool isColor,
         bool isDepth,
         bool isStencil,
@@ -1390,7 +1498,6 @@ void RenderBackend::ClearView(
     uint32_t numAttachments = 0;
     VkClearAttachment attachments[2];
     memset(attachments, 0, sizeof(attachments));
-    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentFrame];
 
     if (isColor) {
         VkClearAttachment & attachment = attachments[numAttachments++];
@@ -1432,6 +1539,9 @@ Starts the frame drawing logic on the screen.
 ================================================================================
 */
 void RenderBackend::StartFrame() {
+    // Reserved before anything of the frame is recorded or released.
+    gpuTimeline.BeginFrame();
+
     VK_CHECK(vkAcquireNextImageKHR(
             vkContext.device,
             m_swapchain,
@@ -1440,8 +1550,24 @@ void RenderBackend::StartFrame() {
             VK_NULL_HANDLE,
             &m_currentSwapIdx));
 
-    Image::EmptyGarbage();
+    // With fewer images than frames in flight, the image may still be rendered
+    // to by an older frame.
+    gpuTimeline.Wait(m_swapImageValues[m_currentSwapIdx]);
+
+    deferredDelete.Collect();
+    pipelineCache.Update();
     stagingManager.Flush();
+    m_secondaryPools.Reset(m_currentFrame);
+    bufferManager.StartFrame(m_currentFrame);
+
+    // Stay under the memory budget by dropping the images unused the longest.
+    memoryBudget.Update();
+    if (memoryBudget.Overcommit() > 0) {
+        memoryBudget.Evicted(globalImages->EvictImages(memoryBudget.Overcommit()));
+    }
+
+    // Upload the images the workers decoded, and swap in the finished ones.
+    globalImages->Update();
 
     VkQueryPool queryPool = m_queryPools[m_currentFrame];
     std::array<uint64_t, NUM_TIMESTAMP_QUERIES> & results = m_queryResults[m_currentFrame];
@@ -1473,6 +1599,10 @@ void RenderBackend::StartFrame() {
     VK_CHECK(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
 
     vkCmdResetQueryPool(commandBuffer, queryPool, 0, NUM_TIMESTAMP_QUERIES);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, m_queryIndex[m_currentFrame]++);
+
+    // Image moves are copied ahead of the draws that sample the moved images.
+    defragmenter.Update(commandBuffer);
 
     VkRenderPassBeginInfo renderPassBeginInfo = {};
     renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -1480,8 +1610,9 @@ void RenderBackend::StartFrame() {
     renderPassBeginInfo.framebuffer = m_frameBuffers[m_currentSwapIdx];
     renderPassBeginInfo.renderArea.extent = m_swapchainExtent;
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, m_queryIndex[m_currentFrame]++);
+    // The render pass is recorded in secondary buffers by DrawView, the primary
+    // buffer only executes them.
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 }
 
 /*
@@ -1495,8 +1626,11 @@ Ends the frame drawing logic and submits the result to the queue.
 void RenderBackend::EndFrame() {
     VkCommandBuffer commandBuffer = m_commandBuffers[m_currentFrame];
 
-    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPools[ m_currentFrame ], m_queryIndex[ m_currentFrame ]++);
+    // The view is recorded, nothing writes dynamic data for this frame anymore.
+    bufferManager.EndFrame();
+
     vkCmdEndRenderPass(commandBuffer);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPools[ m_currentFrame ], m_queryIndex[ m_currentFrame ]++);
 
     // Transition our swap image to present.
     // Do this instead of having the renderpass do the transition
@@ -1524,31 +1658,45 @@ void RenderBackend::EndFrame() {
             0, 0, nullptr, 0, nullptr, 1, &barrier);
 
     VK_CHECK(vkEndCommandBuffer(commandBuffer))
-    m_commandBufferRecorded[ m_currentFrame ] = true;
 
     VkSemaphore * waitSemaphore = &m_imgAvailableSemaphores[m_currentFrame];
-    VkSemaphore * signalSemaphore = &m_renderCompleteSemaphores[m_currentFrame];
+    VkSemaphore * renderCompleteSemaphore = &m_renderCompleteSemaphores[m_currentFrame];
 
     VkPipelineStageFlags dstStageMask = {
             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
     };
 
+    // The binary semaphore goes to the presentation engine, the timeline value
+    // retires the frame. The value of the binary semaphore is ignored.
+    const uint64_t frameValue = gpuTimeline.SubmitFrame();
+    VkSemaphore signalSemaphores[2] = { *renderCompleteSemaphore, gpuTimeline.Semaphore() };
+    uint64_t signalValues[2] = { 0, frameValue };
+
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
     submitInfo.waitSemaphoreCount = 1;
     submitInfo.pWaitSemaphores = waitSemaphore;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphore;
+    submitInfo.signalSemaphoreCount = 2;
+    submitInfo.pSignalSemaphores = signalSemaphores;
     submitInfo.pWaitDstStageMask = &dstStageMask;
 
-    VK_CHECK(vkQueueSubmit(vkContext.graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]));
+    VK_CHECK(vkQueueSubmit(vkContext.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    m_frameValues[m_currentFrame] = frameValue;
+    m_swapImageValues[m_currentSwapIdx] = frameValue;
 
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphore;
+    presentInfo.pWaitSemaphores = renderCompleteSemaphore;
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &m_swapchain;
     presentInfo.pImageIndices = &m_currentSwapIdx;
@@ -1561,20 +1709,35 @@ void RenderBackend::EndFrame() {
 
 /*
 ================================================================================
-RenderBackend::Execute
+RenderBackend::ExecuteCommands
 
 DESCRIPTION:
-Executes the render commands.
+Executes the render commands of a frame. Runs on the render thread, the command
+list ends with RC_SWAP_BUFFERS which submits and presents the frame.
 ================================================================================
 */
-
-void RenderBackend::Execute() {
+void RenderBackend::ExecuteCommands(const RenderCommand *commands, int numCommands) {
     StartFrame();
 
-    //TODO: Add loop and a list of commands to execute.
-    DrawView();
+    for (int i = 0; i < numCommands; i++) {
+        const RenderCommand & command = commands[i];
+
+        switch (command.type) {
+            case RC_DRAW_VIEW:
+                m_viewDef = command.viewDef;
+                DrawView();
+                break;
+            case RC_SWAP_BUFFERS:
+                EndFrame();
+                SwapBuffers();
+                break;
+            case RC_NOP:
+                break;
+        }
+    }
 
-    EndFrame();
+    // The view lives in the frame memory of the frontend.
+    m_viewDef = nullptr;
 }
 
 /*
@@ -1587,13 +1750,7 @@ Draws the view onto the screen.
 */
 
 void RenderBackend::DrawView() {
-    // TODO: Set proper viewport and scissor settings.
-//    // set the window clipping
-//    Viewport( m_viewDef->viewport.x1,
-//                 m_viewDef->viewport.y1,
-//                 m_viewDef->viewport.x2 + 1 - m_viewDef->viewport.x1,
-//                 m_viewDef->viewport.y2 + 1 - m_viewDef->viewport.y1 );
-//
+    // The viewport and scissor are set by every batch, see RecordViewBatch.
 //    // the scissor may be smaller than the viewport for subviews
 //    Scissor( m_viewDef->viewport.x1 + m_viewDef->scissor.x1,
 //                m_viewDef->viewport.y1 + m_viewDef->scissor.y1,
@@ -1607,17 +1764,154 @@ void RenderBackend::DrawView() {
 //    // Clear the depth buffer and clear the stencil to 128 for stencil shadows as well as gui masking
 //    ClearView( false, true, true, STENCIL_SHADOW_TEST_VALUE, 0.0f, 0.0f, 0.0f, 0.0f );
 
-    int left, top;
-    SDL_GetWindowPosition(window.handle, &left, &top);
+    // The first batch clears the view, the rest draw the surfaces.
+    const int numSurfs = m_viewDef->drawSurfs.Size();
+    const int numBatches = 1 + (numSurfs + DRAW_SURFS_PER_BATCH - 1) / DRAW_SURFS_PER_BATCH;
+
+    // Not in frame memory, the frontend resets its arena while the backend runs.
+    m_secondaryBuffers.SetSize(numBatches);
+    VkCommandBuffer * secondaryBuffers = m_secondaryBuffers.Data();
+
+    jobSystem.ParallelFor(numBatches, 1, [&](int begin, int end) {
+        for (int batch = begin; batch < end; batch++) {
+            secondaryBuffers[batch] = RecordViewBatch(batch);
+        }
+    });
+
+    // Executed in batch order, so the frame doesn't depend on which thread
+    // recorded which batch.
+    vkCmdExecuteCommands(m_commandBuffers[m_currentFrame], static_cast<uint32_t>(numBatches), secondaryBuffers);
+
+    m_pc.c_surfaces += numSurfs;
+}
+
+/*
+================================================================================
+RenderBackend::RecordViewBatch
+
+DESCRIPTION:
+Records a batch of the view into a secondary command buffer taken from the pool
+of the calling thread. Batch 0 clears the view, batch `n` draws the surfaces
+[(n - 1) * DRAW_SURFS_PER_BATCH, n * DRAW_SURFS_PER_BATCH).
+
+RETURNS:
+The recorded secondary command buffer.
+================================================================================
+*/
+VkCommandBuffer RenderBackend::RecordViewBatch(int batch) {
+    VkCommandBuffer commandBuffer = m_secondaryPools.AllocSecondary(m_currentFrame);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = vkContext.renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = m_frameBuffers[m_currentSwapIdx];
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo))
+
+    // Dynamic state isn't inherited, every secondary buffer sets its own. The
+    // viewport was taken by the frontend, the window is only touched there.
+    const ScreenRect & viewport = m_viewDef->viewport;
+    const int width = viewport.x2 + 1 - viewport.x1;
+    const int height = viewport.y2 + 1 - viewport.y1;
+
+    Viewport(commandBuffer, viewport.x1, viewport.y1, width, height);
+    Scissor(commandBuffer, viewport.x1, viewport.y1, width, height);
+
+    // Textures are indexed out of the bindless set, it's the only set most
+    // draws need.
+    descriptorManager.BindBindless(commandBuffer, renderPipelineManager.PipelineLayout());
+
+    if (batch == 0) {
+        // Clear depth and stencil buffer.
+//        ClearView(commandBuffer, false, true, true, STENCIL_SHADOW_TEST_VALUE, 0.0f, 0.0f, 0.0f, 0.0f);
+
+        // Clear color buffer.
+        ClearView(commandBuffer, true, false, false, STENCIL_SHADOW_TEST_VALUE, 0.0f, 0.0f, 0.0f, 0.0f);
+    } else {
+        const int first = (batch - 1) * DRAW_SURFS_PER_BATCH;
+        const int last = std::min(first + DRAW_SURFS_PER_BATCH, m_viewDef->drawSurfs.Size());
+
+        for (int i = first; i < last; i++) {
+            DrawSurf(commandBuffer, m_viewDef->drawSurfs[i]);
+        }
+    }
+
+    VK_CHECK(vkEndCommandBuffer(commandBuffer))
+
+    return commandBuffer;
+}
+
+/*
+================================================================================
+RenderBackend::DrawSurf
 
-    Viewport(left, top, window.width, window.height);
-    Scissor(left, top, window.width, window.height);
+DESCRIPTION:
+Records the draw of a surface: binds its pipeline and uniforms, pushes the
+bindless indices of its material's images and draws its index range, or its
+vertices in order when it has no indices. Called from the job workers, so it
+may only touch the given command buffer and read-only frame data.
+================================================================================
+*/
+void RenderBackend::DrawSurf(VkCommandBuffer commandBuffer, const DrawSurface *surf) {
+    // Skipped until the program has a pipeline for the render pass.
+    if (!renderPipelineManager.BindPipeline(commandBuffer, surf->program, surf->stateBits, vkContext.renderPass)) {
+        return;
+    }
+
+    // Depth bias is dynamic, so polygon offset doesn't double the pipelines.
+    if (surf->stateBits & GLS_POLYGON_OFFSET) {
+        vkCmdSetDepthBias(commandBuffer, POLYGON_OFFSET_BIAS, 0.0f, POLYGON_OFFSET_SCALE);
+    }
+
+    // The uniform blocks are copied into the frame's ring, and the one uniform
+    // set is bound at their offsets. Parms without data keep offset 0.
+    uint32_t offsets[MAX_UBO_PARMS] = {};
+
+    for (int i = 0; i < MAX_UBO_PARMS; i++) {
+        if (surf->uniformSizes[i] == 0) {
+            continue;
+        }
+
+        const uint32_t size = std::min(surf->uniformSizes[i], MAX_UBO_SIZE);
+        const BufferAlloc alloc = bufferManager.AllocUniform(size);
+        if (!alloc.IsValid()) {
+            return;
+        }
+
+        memcpy(alloc.data, surf->uniforms[i], size);
+        offsets[i] = static_cast<uint32_t>(alloc.offset);
+    }
 
-    // Clear depth and stencil buffer.
-//    ClearView(false, true, true, STENCIL_SHADOW_TEST_VALUE, 0.0f, 0.0f, 0.0f, 0.0f);
+    // Bound for every draw, even without uniforms: a program reading set 1
+    // must never see it unbound, or see the blocks of the previous surface.
+    descriptorManager.BindUniforms(commandBuffer, renderPipelineManager.PipelineLayout(), offsets);
 
-    // Clear color buffer.
-    ClearView(true, false, false, STENCIL_SHADOW_TEST_VALUE, 0.0f, 0.0f, 0.0f, 0.0f);
+    // Surfaces without a material sample the default image through every parm.
+    static const Material defaultMaterial("_default");
+    const Material * material = surf->material != nullptr ? surf->material : &defaultMaterial;
+
+    DrawPushConstants pushConstants;
+    material->GetBindlessIndices(pushConstants);
+
+    vkCmdPushConstants(commandBuffer, renderPipelineManager.PipelineLayout(),
+                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+    if (surf->vertexBuffer != VK_NULL_HANDLE) {
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &surf->vertexBuffer, &surf->vertexOffset);
+    }
+
+    if (surf->indexBuffer != VK_NULL_HANDLE) {
+        vkCmdBindIndexBuffer(commandBuffer, surf->indexBuffer, surf->indexOffset, VK_INDEX_TYPE_UINT16);
+        vkCmdDrawIndexed(commandBuffer, surf->numIndexes, 1, 0, 0, 0);
+    } else {
+        vkCmdDraw(commandBuffer, surf->numVerts, 1, 0, 0);
+    }
 }
 
 /*
@@ -1628,8 +1922,7 @@ DESCRIPTION:
 Updates the Scissors/Clipping rectangle transformation parameters.
 ================================================================================
 */
-void RenderBackend::Scissor(int x /* left*/, int y /* bottom */, int w, int h) {
-    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentFrame];
+void RenderBackend::Scissor(VkCommandBuffer commandBuffer, int x /* left*/, int y /* bottom */, int w, int h) {
     VkRect2D scissor;
     scissor.offset.x = x;
     scissor.offset.y = y;
@@ -1646,8 +1939,7 @@ DESCRIPTION:
 Updates the viewport transformation parameters.
 ================================================================================
 */
-void RenderBackend::Viewport(int x /* left */, int y /* bottom */, int w, int h) {
-    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentFrame];
+void RenderBackend::Viewport(VkCommandBuffer commandBuffer, int x /* left */, int y /* bottom */, int w, int h) {
     VkViewport viewport;
     viewport.x = static_cast<float>(x);
     viewport.y = static_cast<float>(y);
@@ -1663,19 +1955,12 @@ void RenderBackend::Viewport(int x /* left */, int y /* bottom */, int w, int h)
 RenderBackend::SwapBuffers
 
 DESCRIPTION:
-Swaps the front and back buffers.
+Swaps the front and back buffers. EndFrame already moved on to the next frame,
+this paces the CPU by waiting until the GPU is done with the last submit of that
+frame, so its command buffers and semaphores can be reused. A frame that was
+never submitted has value 0, which is always complete.
 ================================================================================
 */
 void RenderBackend::SwapBuffers() {
-    m_counter++;
-    m_currentFrame = m_counter % MAX_FRAMES_IN_FLIGHT;
-
-    if (m_commandBufferRecorded[m_currentFrame] == false) {
-        return;
-    }
-
-    VK_CHECK(vkWaitForFences(vkContext.device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX))
-
-    VK_CHECK(vkResetFences(vkContext.device, 1, &m_inFlightFences[m_currentFrame]))
-    m_commandBufferRecorded[m_currentFrame] = false;
+    gpuTimeline.Wait(m_frameValues[m_currentFrame]);
 }
@@ -3,6 +3,7 @@
 
 #include "RenderCommon.h"
 #include "VulkanCommon.h"
+#include "CommandPools.h"
 #include "ReloadLib/Containers/Array.h"
 
 struct BackEndCounters {
@@ -40,6 +41,7 @@ public:
     void        EndFrame();                                                     // Ends the frame drawing logic and submits the result to the queue.
     void        SwapBuffers();                                                  // Swaps the front and back buffers.
     void        ClearView(
+                    VkCommandBuffer commandBuffer,
                     bool isColor,
                     bool isDepth,
                     bool isStencil,
@@ -53,10 +55,10 @@ public:
 //
 //    void		DepthBoundsTest( const float zmin, const float zmax );
 //    void		PolygonOffset( float scale, float bias );
-    void        Execute();                                                      // Executes the render commands.
+    void        ExecuteCommands(const RenderCommand *commands, int numCommands);   // Executes the render commands of a frame.
     void        DrawView();                                                     // Draws the view onto the screen.
-    void		Scissor(int x /* left*/, int y /* bottom */, int w, int h);     // Updates the Scissors/Clipping rectangle transformation parameters.
-    void		Viewport(int x /* left */, int y /* bottom */, int w, int h);   // Updates the viewport transformation parameters.
+    void		Scissor(VkCommandBuffer commandBuffer, int x /* left*/, int y /* bottom */, int w, int h);     // Updates the Scissors/Clipping rectangle transformation parameters.
+    void		Viewport(VkCommandBuffer commandBuffer, int x /* left */, int y /* bottom */, int w, int h);   // Updates the viewport transformation parameters.
 //    inline void	Scissor( const idScreenRect & rect ) { GL_Scissor( rect.x1, rect.y1, rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1 ); }
 //    inline void	Viewport( const idScreenRect & rect ) { GL_Viewport( rect.x1, rect.y1, rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1 ); }
 //
@@ -79,8 +81,8 @@ private:
     void        CreateFrameBuffers();                                           // Creates frame buffers.
     void        DestroyFrameBuffers();                                          // Destroys frame buffers.
 
-    void        CreateSyncObjects();                                            // Create semaphores for image acquisition and rendering completion, and fences.
-    void        DestroySyncObjects();                                           // Destroys the semaphores and fences.
+    void        CreateSyncObjects();                                            // Create semaphores for image acquisition and rendering completion.
+    void        DestroySyncObjects();                                           // Destroys the semaphores.
 
     void        CreateQueryPool();                                              // Creates the query pool.
     void        DestroyQueryPool();                                             // Destroys the query pool.
@@ -93,6 +95,9 @@ private:
 
     void		CreateRenderPass();                                             // Creates a render pass.
 
+    VkCommandBuffer RecordViewBatch(int batch);                                 // Records a batch of the view into a secondary command buffer.
+    void        DrawSurf(VkCommandBuffer commandBuffer, const DrawSurface *surf);   // Records the draw of a surface.
+
     void        ClearContext();                                                 // Clears the vulkan context and resets its  values.
     void        Clear();                                                        // Clears and resets all the values.
 
@@ -105,6 +110,8 @@ private:
     VkSurfaceKHR					m_surface;
     VkPresentModeKHR				m_presentMode;
     VkCommandPool					m_commandPool;
+    CommandPools                    m_secondaryPools;                           // Per thread pools for recording the view in parallel.
+    List<VkCommandBuffer>           m_secondaryBuffers;                         // Recorded batches of the current view, in execution order.
 
     std::vector<const char *>	m_deviceExtensions;
     std::vector<const char *>	m_validationLayers;
@@ -118,22 +125,21 @@ private:
     VkImage             m_currentImage;
     VkImageView	        m_currentImageView;
 
-    std::array<VkImage, MAX_FRAMES_IN_FLIGHT>           m_swapchainImages;
-    std::array<VkImageView, MAX_FRAMES_IN_FLIGHT>       m_swapchainViews;
-    std::array<VkFramebuffer, MAX_FRAMES_IN_FLIGHT>     m_frameBuffers;
+    uint32_t            m_numSwapchainImages;
+
+    std::array<VkImage, MAX_SWAPCHAIN_IMAGES>           m_swapchainImages;
+    std::array<VkImageView, MAX_SWAPCHAIN_IMAGES>       m_swapchainViews;
+    std::array<VkFramebuffer, MAX_SWAPCHAIN_IMAGES>     m_frameBuffers;
+    std::array<uint64_t, MAX_SWAPCHAIN_IMAGES>          m_swapImageValues;      // Timeline value of the last frame rendered to each image.
 
     std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT>   m_commandBuffers;
-    std::array<VkFence, MAX_FRAMES_IN_FLIGHT>			m_commandBufferFences;
-    std::array<bool, MAX_FRAMES_IN_FLIGHT>        	    m_commandBufferRecorded;
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT>          m_frameValues;          // Timeline value signaled by the last submit of each frame.
 
     std::array<uint32_t, MAX_FRAMES_IN_FLIGHT>          m_queryIndex;
     std::array<std::array<uint64_t, NUM_TIMESTAMP_QUERIES>, MAX_FRAMES_IN_FLIGHT> m_queryResults;
     std::array<VkQueryPool, MAX_FRAMES_IN_FLIGHT>       m_queryPools;
     std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT>       m_imgAvailableSemaphores;
     std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT>       m_renderCompleteSemaphores;
-    std::array<VkFence, MAX_FRAMES_IN_FLIGHT>           m_inFlightFences;
-
-    std::array<VkFence, MAX_FRAMES_IN_FLIGHT>                m_imagesInFlight;
 };
 
 #endif // RELOAD_RENDER_BACKEND_H
\ No newline at end of file
@@ -6,11 +6,15 @@
 #define RELOAD_RENDER_COMMON_H
 
 #include "Common.h"
+#include "ReloadLib/Containers/List.h"
 
 // everything that is needed by the backend needs
 // to be double buffered to allow it to run in
 // parallel on a dual cpu machine
 static const uint32_t MAX_FRAMES_IN_FLIGHT	= 2;
+// upper bound of the images the presentation engine may hand out, usually one
+// more than the frames in flight
+static const uint32_t MAX_SWAPCHAIN_IMAGES	= 8;
 
 static const int MAX_DESC_SETS				= 16384;
 static const int MAX_DESC_UNIFORM_BUFFERS	= 8192;
@@ -21,6 +25,54 @@ static const int MAX_IMAGE_PARMS			= 16;
 static const int MAX_UBO_PARMS				= 2;
 static const int NUM_TIMESTAMP_QUERIES		= 16;
 
+// slots of the bindless image array, clamped to the device limits
+static const uint32_t MAX_BINDLESS_IMAGES	= 16384;
+static const uint32_t BINDLESS_INVALID_INDEX	= 0xFFFFFFFF;
+// mip levels of the largest image, 16k by 16k
+static const uint32_t MAX_IMAGE_LEVELS		= 15;
+
+// device local blocks static geometry is suballocated from. the per-frame share
+// of the mapped ring for dynamic data comes from the config
+static const uint64_t STATIC_BUFFER_BLOCK_SIZE	= 32 * 1024 * 1024;
+static const uint64_t STATIC_BUFFER_ALIGNMENT	= 16;
+
+// uniform blocks live in the dynamic ring and are bound at dynamic offsets of
+// this alignment. each of the MAX_UBO_PARMS bindings spans MAX_UBO_SIZE bytes
+static const uint64_t UNIFORM_BUFFER_ALIGNMENT	= 256;
+static const uint32_t MAX_UBO_SIZE				= 4096;
+
+// push constants every program may use, the minimum the spec guarantees
+static const uint32_t PUSH_CONSTANTS_SIZE		= 128;
+
+// images are evicted once a device local heap goes over the first share of its
+// budget, until it's back down to the second
+static const uint64_t MEMORY_BUDGET_EVICT_PERCENT	= 95;
+static const uint64_t MEMORY_BUDGET_TARGET_PERCENT	= 90;
+
+// each defragmentation pass moves at most this much, and one that finds nothing
+// to move puts off the next for a while
+static const uint64_t DEFRAG_BYTES_PER_PASS	= 4 * 1024 * 1024;
+static const uint32_t DEFRAG_MOVES_PER_PASS	= 64;
+static const int DEFRAG_IDLE_FRAMES			= 600;
+
+// decoded images uploaded per frame, at least one is
+static const size_t IMAGE_UPLOAD_BYTES_PER_FRAME	= 32 * 1024 * 1024;
+
+// size of each of the per-frame linear arenas used for frame temporaries
+static const size_t FRAME_MEMORY_SIZE		= 16 * 1024 * 1024;
+
+// timeline values a frame reserves, the ones below its own are signaled by the
+// submissions made while it's recorded, like staging flushes
+static const uint64_t TIMELINE_VALUES_PER_FRAME	= 1 << 20;
+
+// time per frame the render thread spends destroying released vulkan objects
+static const uint64_t DEFERRED_DELETE_BUDGET_USEC	= 500;
+
+// the pipeline cache is saved this often while it keeps growing, and never
+// loaded or saved past the size cap
+static const uint32_t PIPELINE_CACHE_SAVE_INTERVAL_MS	= 60 * 1000;
+static const size_t PIPELINE_CACHE_MAX_SIZE			= 64 * 1024 * 1024;
+
 typedef enum {
     TEX_TYPE_DISABLED,
     TEX_TYPE_2D,
@@ -146,6 +198,54 @@ struct ImageOpts {
     bool				    readback = false;		                            // 360 specific - cpu reads back from this texture, so allocate with cached memory
 };
 
+// Vertex input of a pipeline.
+typedef enum {
+    VERTEX_LAYOUT_NONE,			// no vertex buffers, the vertices are generated by the shader
+    VERTEX_LAYOUT_DRAW_VERT,	// DrawVert
+    NUM_VERTEX_LAYOUTS
+} VertexLayout;
+
+struct DrawVert {
+    float				xyz[3];
+    float				st[2];
+    uint8_t				normal[4];			// packed to 0..255, w unused
+    uint8_t				color[4];
+};
+
+// index of a vertex of the surface's vertex range
+typedef uint16_t TriIndex;
+
+// pushed for every draw. the shaders index the bindless image array with them
+struct DrawPushConstants {
+    uint32_t            images[MAX_IMAGE_PARMS];                                // bindless indices of the material's images
+};
+
+static_assert(sizeof(DrawPushConstants) <= PUSH_CONSTANTS_SIZE, "DrawPushConstants don't fit the push constants.");
+
+class Material;
+
+struct DrawSurface {
+    uint64_t            sort = 0;                                               // material sort key, surfaces are drawn in ascending order
+    const Material *    material = nullptr;
+    int                 program = -1;                                           // index from RenderPipelineManager::FindProgram
+    uint64_t            stateBits = 0;                                          // GLS_* state bits of RenderState.h
+    const void *        uniforms[MAX_UBO_PARMS] = {};                           // vertex and fragment parms, copied into the ring when drawn
+    uint32_t            uniformSizes[MAX_UBO_PARMS] = {};                       // at most MAX_UBO_SIZE bytes each
+    VkBuffer            vertexBuffer = VK_NULL_HANDLE;                          // DrawVert, none for VERTEX_LAYOUT_NONE programs
+    VkDeviceSize        vertexOffset = 0;
+    VkBuffer            indexBuffer = VK_NULL_HANDLE;                           // TriIndex, none draws numVerts vertices in order
+    VkDeviceSize        indexOffset = 0;
+    uint32_t            numVerts = 0;
+    uint32_t            numIndexes = 0;
+};
+
+struct ScreenRect {
+    int                 x1 = 0;                                                 // inclusive, in real pixels
+    int                 y1 = 0;
+    int                 x2 = 0;
+    int                 y2 = 0;
+};
+
 struct ViewDefiniton {
     // specified in the call to DrawScene()
 //    renderView_t		renderView;
@@ -176,7 +276,7 @@ struct ViewDefiniton {
 //    int					numClipPlanes;			// mirrors will often use a single clip plane
 //    idPlane				clipPlanes[MAX_CLIP_PLANES];		// in world space, the positive side
 //    // of the plane is the visible side
-//    idScreenRect		viewport;				// in real pixels and proper Y flip
+    ScreenRect          viewport;                                               // in real pixels, snapshot of the window size taken by the frontend
 //
 //    idScreenRect		scissor;
 //    // for scissor clipping, local inside renderView viewport
@@ -187,11 +287,10 @@ struct ViewDefiniton {
 //    viewDef_t *			superView;				// never go into an infinite subview loop
 //    const drawSurf_t *	subviewSurface;
 //
-//    // drawSurfs are the visible surfaces of the viewEntities, sorted
-//    // by the material sort parameter
-//    drawSurf_t **		drawSurfs;				// we don't use an idList for this, because
-//    int					numDrawSurfs;			// it is allocated in frame temporary memory
-//    int					maxDrawSurfs;			// may be resized
+//
+    // drawSurfs are the visible surfaces of the viewEntities, sorted
+    // by the material sort parameter
+    List<DrawSurface *, FrameAllocator> drawSurfs;                              // allocated in frame temporary memory
 //
 //    viewLight_t	*		viewLights;			// chain of all viewLights effecting view
 //    viewEntity_t *		viewEntitys;			// chain of all viewEntities effecting view, including off screen ones casting shadows
@@ -209,4 +308,16 @@ struct ViewDefiniton {
 //    bool *				connectedAreas;
 };
 
+typedef enum {
+    RC_NOP,
+    RC_DRAW_VIEW,               // draws the view of the command
+    RC_SWAP_BUFFERS             // submits and presents the frame, always the last command
+} RenderCommandType;
+
+// commands queued by the frontend and executed by the backend on the render thread
+struct RenderCommand {
+    RenderCommandType       type = RC_NOP;
+    const ViewDefiniton *   viewDef = nullptr;                                  // RC_DRAW_VIEW, in frame temporary memory
+};
+
 #endif //RELOAD_RENDERCOMMON_H
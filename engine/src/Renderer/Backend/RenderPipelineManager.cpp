@@ -4,6 +4,132 @@
 
 #include "RenderPipelineManager.h"
 
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include "ConfigManager.h"
+#include "DescriptorManager.h"
+#include "RenderProgram.h"
+#include "RenderState.h"
+#include "VulkanHelpers.h"
+#include "ReloadLib/File.h"
+
+RenderPipelineManager renderPipelineManager;
+
+// Programs the renderer itself draws with, loaded with the pipeline layout. The
+// SPIR-V is compiled from the GLSL next to it by the build.
+struct BuiltinProgram {
+    const char *        name;
+    const char *        vertexPath;
+    const char *        fragmentPath;
+    VertexLayout        vertexLayout;
+};
+
+static const BuiltinProgram BUILTIN_PROGRAMS[] = {
+    { "default", "shaders/default.vert.spv", "shaders/default.frag.spv", VERTEX_LAYOUT_DRAW_VERT }
+};
+
+static const char * MANIFEST_HEADER = "# Reload pipeline manifest, one `program stateBits` per line.\n";
+
+/*
+================================================================================
+GetSrcBlendFactor, GetDstBlendFactor
+
+RETURNS:
+The Vulkan blend factor of the GLS_SRCBLEND_* or GLS_DSTBLEND_* bits.
+================================================================================
+*/
+static VkBlendFactor GetSrcBlendFactor(uint64_t stateBits) {
+    switch (stateBits & GLS_SRCBLEND_BITS) {
+        case GLS_SRCBLEND_ZERO:                 return VK_BLEND_FACTOR_ZERO;
+        case GLS_SRCBLEND_DST_COLOR:            return VK_BLEND_FACTOR_DST_COLOR;
+        case GLS_SRCBLEND_ONE_MINUS_DST_COLOR:  return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+        case GLS_SRCBLEND_SRC_ALPHA:            return VK_BLEND_FACTOR_SRC_ALPHA;
+        case GLS_SRCBLEND_ONE_MINUS_SRC_ALPHA:  return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        case GLS_SRCBLEND_DST_ALPHA:            return VK_BLEND_FACTOR_DST_ALPHA;
+        case GLS_SRCBLEND_ONE_MINUS_DST_ALPHA:  return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+        default:                                return VK_BLEND_FACTOR_ONE;
+    }
+}
+
+static VkBlendFactor GetDstBlendFactor(uint64_t stateBits) {
+    switch (stateBits & GLS_DSTBLEND_BITS) {
+        case GLS_DSTBLEND_ONE:                  return VK_BLEND_FACTOR_ONE;
+        case GLS_DSTBLEND_SRC_COLOR:            return VK_BLEND_FACTOR_SRC_COLOR;
+        case GLS_DSTBLEND_ONE_MINUS_SRC_COLOR:  return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+        case GLS_DSTBLEND_SRC_ALPHA:            return VK_BLEND_FACTOR_SRC_ALPHA;
+        case GLS_DSTBLEND_ONE_MINUS_SRC_ALPHA:  return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        case GLS_DSTBLEND_DST_ALPHA:            return VK_BLEND_FACTOR_DST_ALPHA;
+        case GLS_DSTBLEND_ONE_MINUS_DST_ALPHA:  return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+        default:                                return VK_BLEND_FACTOR_ZERO;
+    }
+}
+
+/*
+================================================================================
+GetBlendOp
+
+RETURNS:
+The Vulkan blend operation of the GLS_BLENDOP_* bits.
+================================================================================
+*/
+static VkBlendOp GetBlendOp(uint64_t stateBits) {
+    switch (stateBits & GLS_BLENDOP_BITS) {
+        case GLS_BLENDOP_SUB:   return VK_BLEND_OP_SUBTRACT;
+        case GLS_BLENDOP_MIN:   return VK_BLEND_OP_MIN;
+        case GLS_BLENDOP_MAX:   return VK_BLEND_OP_MAX;
+        default:                return VK_BLEND_OP_ADD;
+    }
+}
+
+/*
+================================================================================
+GetDepthCompareOp
+
+RETURNS:
+The Vulkan compare operation of the GLS_DEPTHFUNC_* bits.
+================================================================================
+*/
+static VkCompareOp GetDepthCompareOp(uint64_t stateBits) {
+    switch (stateBits & GLS_DEPTHFUNC_BITS) {
+        case GLS_DEPTHFUNC_ALWAYS:  return VK_COMPARE_OP_ALWAYS;
+        case GLS_DEPTHFUNC_GREATER: return VK_COMPARE_OP_GREATER_OR_EQUAL;
+        case GLS_DEPTHFUNC_EQUAL:   return VK_COMPARE_OP_EQUAL;
+        default:                    return VK_COMPARE_OP_LESS_OR_EQUAL;
+    }
+}
+
+/*
+================================================================================
+GetStencilOpState
+
+RETURNS:
+The stencil state of the GLS_STENCIL_* bits, the same for both faces.
+================================================================================
+*/
+static VkStencilOpState GetStencilOpState(uint64_t stateBits) {
+    static const VkCompareOp compareOps[] = {
+            VK_COMPARE_OP_ALWAYS, VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL, VK_COMPARE_OP_GREATER,
+            VK_COMPARE_OP_GREATER_OR_EQUAL, VK_COMPARE_OP_EQUAL, VK_COMPARE_OP_NOT_EQUAL, VK_COMPARE_OP_NEVER
+    };
+    static const VkStencilOp stencilOps[] = {
+            VK_STENCIL_OP_KEEP, VK_STENCIL_OP_ZERO, VK_STENCIL_OP_REPLACE, VK_STENCIL_OP_INCREMENT_AND_CLAMP,
+            VK_STENCIL_OP_DECREMENT_AND_CLAMP, VK_STENCIL_OP_INVERT, VK_STENCIL_OP_INCREMENT_AND_WRAP,
+            VK_STENCIL_OP_DECREMENT_AND_WRAP
+    };
+
+    VkStencilOpState state = {};
+    state.compareOp = compareOps[(stateBits & GLS_STENCIL_FUNC_BITS) >> 36];
+    state.failOp = stencilOps[(stateBits & GLS_STENCIL_OP_FAIL_BITS) >> 39];
+    state.depthFailOp = stencilOps[(stateBits & GLS_STENCIL_OP_ZFAIL_BITS) >> 42];
+    state.passOp = stencilOps[(stateBits & GLS_STENCIL_OP_PASS_BITS) >> 45];
+    state.reference = static_cast<uint32_t>((stateBits & GLS_STENCIL_FUNC_REF_BITS) >> GLS_STENCIL_FUNC_REF_SHIFT);
+    state.compareMask = static_cast<uint32_t>((stateBits & GLS_STENCIL_FUNC_MASK_BITS) >> GLS_STENCIL_FUNC_MASK_SHIFT);
+    state.writeMask = 0xFF;
+
+    return state;
+}
+
 /*
 ================================================================================
 RenderPipelineManager::RenderPipelineManager
@@ -12,21 +138,57 @@ DESCRIPTION:
 The default constructor.
 ================================================================================
 */
-RenderPipelineManager::RenderPipelineManager()
-    : m_counter(0)
-    , m_currentData(0){}
+RenderPipelineManager::RenderPipelineManager() : m_pipelineLayout(VK_NULL_HANDLE), m_recording(false) {}
+
+/*
+================================================================================
+RenderPipelineManager::~RenderPipelineManager
 
+DESCRIPTION:
+The default destructor.
+================================================================================
+*/
+RenderPipelineManager::~RenderPipelineManager() = default;
 
 /*
 ================================================================================
 RenderPipelineManager::Init
 
 DESCRIPTION:
-Initializes the rendering pipeline.
+Creates the pipeline layout shared by all the programs: the bindless set as set
+0, the uniform set as set 1 and the push constants. Then loads the built-in
+programs, so they're known before any manifest or material refers to them.
 ================================================================================
 */
 void RenderPipelineManager::Init() {
+    m_recording = vkConfig.recordPipelines;
+    if (m_recording) {
+        SDL_LogInfo(LOG_RENDER, "Recording the pipelines used into the manifest.");
+    }
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = PUSH_CONSTANTS_SIZE;
+
+    // Set 0 holds the bindless images, set 1 the uniform blocks.
+    const VkDescriptorSetLayout setLayouts[2] = {
+            descriptorManager.BindlessLayout(),
+            descriptorManager.UniformLayout()
+    };
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = 2;
+    layoutCreateInfo.pSetLayouts = setLayouts;
+    layoutCreateInfo.pushConstantRangeCount = 1;
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
+    VK_CHECK(vkCreatePipelineLayout(vkContext.device, &layoutCreateInfo, nullptr, &m_pipelineLayout))
+
+    for (const BuiltinProgram & builtin : BUILTIN_PROGRAMS) {
+        LoadProgram(builtin.name, builtin.vertexPath, builtin.fragmentPath, builtin.vertexLayout);
+    }
 }
 
 /*
@@ -34,35 +196,99 @@ void RenderPipelineManager::Init() {
 RenderPipelineManager::Shutdown
 
 DESCRIPTION:
-Shuts down the rendering pipeline.
+Waits for the compiles in flight and destroys all the pipelines, the programs
+and the layout. The GPU has to be done with them.
 ================================================================================
 */
 void RenderPipelineManager::Shutdown() {
+    jobSystem.Wait(&m_compileCounter);
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    for (auto & entry : m_renderProgs) {
+        vkDestroyPipeline(vkContext.device, entry.value->pipeline.load(), nullptr);
+        delete entry.value;
+    }
+    m_renderProgs.Clear();
+
+    for (int i = 0; i < m_programs.Size(); i++) {
+        PipelineProgram * program = m_programs[i];
+        vkDestroyPipeline(vkContext.device, program->fallback, nullptr);
+        vkDestroyShaderModule(vkContext.device, program->vertexShader, nullptr);
+        vkDestroyShaderModule(vkContext.device, program->fragmentShader, nullptr);
+        delete program;
+    }
+    m_programs.Clear();
+    m_programIndices.Clear();
 
+    vkDestroyPipelineLayout(vkContext.device, m_pipelineLayout, nullptr);
+    m_pipelineLayout = VK_NULL_HANDLE;
 }
 
 /*
 ================================================================================
-RenderPipelineManager::StartFrame
+RenderPipelineManager::LoadProgram
 
 DESCRIPTION:
-Starts the frame drawing logic on the screen.
+Loads the SPIR-V shaders of the program and compiles its fallback pipeline,
+GLS_DEFAULT on the main render pass, right away. Programs are loaded at load
+time, so this is the only place that compiles on the calling thread.
+
+RETURNS:
+The index of the program, or -1 if the shaders couldn't be loaded.
 ================================================================================
 */
-void RenderPipelineManager::StartFrame() {
+int RenderPipelineManager::LoadProgram(const char *name, const char *vertexPath, const char *fragmentPath,
+                                       VertexLayout vertexLayout) {
+    const int existing = FindProgram(name);
+    if (existing >= 0) {
+        return existing;
+    }
+
+    auto * program = new PipelineProgram();
+    program->name = name;
+    program->vertexLayout = vertexLayout;
+    program->vertexShader = RenderProgram::LoadShaderModule(vertexPath);
+    program->fragmentShader = RenderProgram::LoadShaderModule(fragmentPath);
 
+    if (program->vertexShader == VK_NULL_HANDLE || program->fragmentShader == VK_NULL_HANDLE) {
+        SDL_LogError(LOG_RENDER, "Couldn't load the shaders of program %s.", name);
+        vkDestroyShaderModule(vkContext.device, program->vertexShader, nullptr);
+        vkDestroyShaderModule(vkContext.device, program->fragmentShader, nullptr);
+        delete program;
+        return -1;
+    }
+
+    int index;
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        index = m_programs.Add(program);
+        m_programIndices.Set(program->name, index);
+    }
+
+    PipelineKey key;
+    key.program = index;
+    key.stateBits = GLS_DEFAULT;
+    key.renderPass = vkContext.renderPass;
+    key.vertexLayout = vertexLayout;
+    program->fallback = Compile(key);
+
+    return index;
 }
 
 /*
 ================================================================================
-RenderPipelineManager::Submit
+RenderPipelineManager::FindProgram
 
-DESCRIPTION:
-Commits the command buffer to execute.
+RETURNS:
+The index of the program, or -1 if it isn't loaded.
 ================================================================================
 */
-void RenderPipelineManager::Submit(uint64_t stateBits, VkCommandBuffer cmdBuffer) {
+int RenderPipelineManager::FindProgram(std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
 
+    const int * index = m_programIndices.Find(name);
+    return index != nullptr ? *index : -1;
 }
 
 /*
@@ -70,11 +296,481 @@ void RenderPipelineManager::Submit(uint64_t stateBits, VkCommandBuffer cmdBuffer
 RenderPipelineManager::GetPipeline
 
 DESCRIPTION:
-Gets the rendering pipeline.
+Looks up the pipeline of the program for the state bits and render pass. On a
+miss the pipeline is registered and its compile started in the background.
+Safe to call from any thread, never blocks on a compile.
+
 RETURNS:
-The rendering pipeline.
+The pipeline, the fallback of the program while it's not ready, or
+VK_NULL_HANDLE if there is neither.
 ================================================================================
 */
-VkPipeline RenderPipelineManager::GetPipeline() {
-    return nullptr;
+VkPipeline RenderPipelineManager::GetPipeline(int program, uint64_t stateBits, VkRenderPass renderPass) {
+    PipelineKey key;
+    key.program = program;
+    key.stateBits = stateBits;
+    key.renderPass = renderPass;
+
+    const PipelineProgram * pipelineProgram;
+    RenderProg * renderProg = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        if (program < 0 || program >= m_programs.Size()) {
+            return VK_NULL_HANDLE;
+        }
+
+        pipelineProgram = m_programs[program];
+        key.vertexLayout = pipelineProgram->vertexLayout;
+
+        RenderProg ** found = m_renderProgs.Find(key);
+        if (found != nullptr) {
+            renderProg = *found;
+        }
+    }
+
+    if (renderProg == nullptr) {
+        bool inserted;
+        renderProg = Register(key, inserted);
+
+        if (inserted) {
+            Job job;
+            job.func = &RenderPipelineManager::CompileJob;
+            job.data = renderProg;
+            jobSystem.RunBackground(&job, 1, &m_compileCounter);
+        }
+    }
+
+    if (m_recording && !renderProg->used.load(std::memory_order_relaxed)) {
+        renderProg->used.store(true, std::memory_order_relaxed);
+    }
+
+    if (renderProg->status.load(std::memory_order_acquire) == PIPELINE_READY) {
+        return renderProg->pipeline.load(std::memory_order_relaxed);
+    }
+
+    // The fallback is built for the main render pass only.
+    return renderPass == vkContext.renderPass ? pipelineProgram->fallback : VK_NULL_HANDLE;
+}
+
+/*
+================================================================================
+RenderPipelineManager::BindPipeline
+
+DESCRIPTION:
+Binds the pipeline GetPipeline picks for the state.
+
+RETURNS:
+`false` if there is no pipeline to draw with yet, the draw has to be skipped.
+================================================================================
+*/
+bool RenderPipelineManager::BindPipeline(VkCommandBuffer commandBuffer, int program, uint64_t stateBits,
+                                         VkRenderPass renderPass) {
+    VkPipeline pipeline = GetPipeline(program, stateBits, renderPass);
+    if (pipeline == VK_NULL_HANDLE) {
+        return false;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    return true;
+}
+
+/*
+================================================================================
+RenderPipelineManager::NumPipelines
+
+RETURNS:
+The number of registered pipelines, compiled or not.
+================================================================================
+*/
+int RenderPipelineManager::NumPipelines() {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_renderProgs.Size();
+}
+
+/*
+================================================================================
+RenderPipelineManager::PrecompileManifest
+
+DESCRIPTION:
+Registers every pipeline of the manifest for the main render pass and compiles
+the ones not registered yet in parallel on the job system. Blocks until all of
+them are done, so it belongs in the load phase of a level, before the first
+frame draws with them. The programs have to be loaded before, lines of programs
+that aren't loaded are skipped, and so are the pipelines that fail to compile.
+
+While recording the pipelines of the manifest count as used, so saving doesn't
+drop what earlier sessions recorded.
+
+RETURNS:
+The number of pipelines compiled and ready, 0 if the manifest doesn't exist.
+================================================================================
+*/
+int RenderPipelineManager::PrecompileManifest(const char *path) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        SDL_LogInfo(LOG_RENDER, "No pipeline manifest %s.", path);
+        return 0;
+    }
+
+    file.Advise(MAP_ADVICE_SEQUENTIAL);
+
+    const uint64_t start = SDL_GetPerformanceCounter();
+    const Span<const uint8_t> data = file.Data();
+    const auto * text = reinterpret_cast<const char *>(data.Data());
+    const char * end = text + data.Size();
+
+    List<Job> jobs;
+    List<RenderProg *> compiled;
+    int numSkipped = 0;
+
+    while (text < end) {
+        const char * lineEnd = std::find(text, end, '\n');
+        std::string_view line(text, static_cast<size_t>(lineEnd - text));
+        text = lineEnd < end ? lineEnd + 1 : end;
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const size_t separator = line.find(' ');
+        if (separator == std::string_view::npos) {
+            numSkipped++;
+            continue;
+        }
+
+        const int program = FindProgram(line.substr(0, separator));
+        uint64_t stateBits = 0;
+        const char * bitsBegin = line.data() + separator + 1;
+        const char * bitsEnd = line.data() + line.size();
+        if (program < 0 || std::from_chars(bitsBegin, bitsEnd, stateBits, 16).ec != std::errc()) {
+            numSkipped++;
+            continue;
+        }
+
+        PipelineKey key;
+        key.program = program;
+        key.stateBits = stateBits;
+        key.renderPass = vkContext.renderPass;
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            key.vertexLayout = m_programs[program]->vertexLayout;
+        }
+
+        bool inserted;
+        RenderProg * renderProg = Register(key, inserted);
+        if (m_recording) {
+            renderProg->used.store(true, std::memory_order_relaxed);
+        }
+
+        if (inserted) {
+            Job job;
+            job.func = &RenderPipelineManager::CompileJob;
+            job.data = renderProg;
+            jobs.Add(job);
+            compiled.Add(renderProg);
+        }
+    }
+
+    file.Close();
+
+    JobCounter counter;
+    jobSystem.RunBackground(jobs.Data(), jobs.Size(), &counter);
+    jobSystem.Wait(&counter);
+
+    int numReady = 0;
+    for (int i = 0; i < compiled.Size(); i++) {
+        if (compiled[i]->status.load(std::memory_order_acquire) == PIPELINE_READY) {
+            numReady++;
+        }
+    }
+
+    const double msec = static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0
+                        / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_LogInfo(LOG_RENDER, "Precompiled %d pipelines of %s in %.1f ms, skipped %d lines.",
+                numReady, path, msec, numSkipped);
+
+    if (numReady < compiled.Size()) {
+        SDL_LogWarn(LOG_RENDER, "%d pipelines of %s failed to compile.", compiled.Size() - numReady, path);
+    }
+
+    return numReady;
+}
+
+/*
+================================================================================
+RenderPipelineManager::SaveManifest
+
+DESCRIPTION:
+Writes the pipelines of the main render pass that were used while recording,
+sorted by program name and state bits so the file diffs well.
+
+RETURNS:
+`false` if the file couldn't be written.
+================================================================================
+*/
+bool RenderPipelineManager::SaveManifest(const char *path) const {
+    struct ManifestEntry {
+        const std::string * program;
+        uint64_t            stateBits;
+    };
+
+    List<ManifestEntry> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        for (auto & entry : m_renderProgs) {
+            const RenderProg * renderProg = entry.value;
+            if (renderProg->used.load(std::memory_order_relaxed) && renderProg->key.renderPass == vkContext.renderPass) {
+                entries.Add(ManifestEntry{ &m_programs[renderProg->key.program]->name, renderProg->key.stateBits });
+            }
+        }
+    }
+
+    std::sort(entries.Data(), entries.Data() + entries.Size(), [](const ManifestEntry &a, const ManifestEntry &b) {
+        const int order = a.program->compare(*b.program);
+        return order != 0 ? order < 0 : a.stateBits < b.stateBits;
+    });
+
+    std::string text = MANIFEST_HEADER;
+    for (int i = 0; i < entries.Size(); i++) {
+        char stateBits[17];
+        snprintf(stateBits, sizeof(stateBits), "%016llx", static_cast<unsigned long long>(entries[i].stateBits));
+
+        text += *entries[i].program;
+        text += ' ';
+        text += stateBits;
+        text += '\n';
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    if (!WriteFileAtomically(path, text.data(), text.size())) {
+        SDL_LogWarn(LOG_RENDER, "Couldn't write the pipeline manifest %s.", path);
+        return false;
+    }
+
+    SDL_LogInfo(LOG_RENDER, "Recorded %d pipelines into %s.", entries.Size(), path);
+    return true;
+}
+
+/*
+================================================================================
+RenderPipelineManager::ClearRecording
+
+DESCRIPTION:
+Unmarks all the pipelines, so the next manifest only gets the ones used after.
+================================================================================
+*/
+void RenderPipelineManager::ClearRecording() {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    for (auto & entry : m_renderProgs) {
+        entry.value->used.store(false, std::memory_order_relaxed);
+    }
+}
+
+/*
+================================================================================
+RenderPipelineManager::Register
+
+DESCRIPTION:
+Adds the pipeline under the exclusive lock. Another thread may have added it
+since the shared lookup, then that one is returned.
+
+RETURNS:
+The registered pipeline.
+================================================================================
+*/
+RenderProg *RenderPipelineManager::Register(const PipelineKey &key, bool &inserted) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    RenderProg ** found = m_renderProgs.Find(key);
+    if (found != nullptr) {
+        inserted = false;
+        return *found;
+    }
+
+    auto * renderProg = new RenderProg();
+    renderProg->key = key;
+    m_renderProgs.Set(key, renderProg);
+
+    inserted = true;
+    return renderProg;
+}
+
+/*
+================================================================================
+RenderPipelineManager::CompileJob
+
+DESCRIPTION:
+Compiles a registered pipeline on a job worker and publishes it.
+================================================================================
+*/
+void RenderPipelineManager::CompileJob(void *data) {
+    auto * renderProg = static_cast<RenderProg *>(data);
+
+    VkPipeline pipeline = renderPipelineManager.Compile(renderProg->key);
+
+    renderProg->pipeline.store(pipeline, std::memory_order_relaxed);
+    renderProg->status.store(pipeline != VK_NULL_HANDLE ? PIPELINE_READY : PIPELINE_FAILED, std::memory_order_release);
+}
+
+/*
+================================================================================
+RenderPipelineManager::Compile
+
+DESCRIPTION:
+Translates the state bits into the fixed function state and creates the
+pipeline through the pipeline cache. Viewport, scissor and depth bias are
+dynamic, so they don't multiply the number of pipelines.
+
+RETURNS:
+The pipeline, or VK_NULL_HANDLE if the driver failed to create it.
+================================================================================
+*/
+VkPipeline RenderPipelineManager::Compile(const PipelineKey &key) const {
+    const PipelineProgram * program;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        program = m_programs[key.program];
+    }
+
+    const uint64_t stateBits = key.stateBits;
+
+    // Shaders
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = program->vertexShader;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = program->fragmentShader;
+    stages[1].pName = "main";
+
+    // Vertex input
+    VkVertexInputBindingDescription binding = {};
+    VkVertexInputAttributeDescription attributes[4] = {};
+
+    VkPipelineVertexInputStateCreateInfo vertexInputState = {};
+    vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    if (key.vertexLayout == VERTEX_LAYOUT_DRAW_VERT) {
+        binding.binding = 0;
+        binding.stride = sizeof(DrawVert);
+        binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        attributes[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(DrawVert, xyz) };
+        attributes[1] = { 1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(DrawVert, st) };
+        attributes[2] = { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(DrawVert, normal) };
+        attributes[3] = { 3, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(DrawVert, color) };
+
+        vertexInputState.vertexBindingDescriptionCount = 1;
+        vertexInputState.pVertexBindingDescriptions = &binding;
+        vertexInputState.vertexAttributeDescriptionCount = 4;
+        vertexInputState.pVertexAttributeDescriptions = attributes;
+    }
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+    inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    // Rasterization
+    VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+    rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizationState.polygonMode = (stateBits & GLS_POLYMODE_LINE) ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+    rasterizationState.depthBiasEnable = (stateBits & GLS_POLYGON_OFFSET) ? VK_TRUE : VK_FALSE;
+    rasterizationState.frontFace = (stateBits & GLS_MIRROR_VIEW) ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizationState.lineWidth = 1.0f;
+
+    switch (stateBits & GLS_CULL_BITS) {
+        case GLS_CULL_TWOSIDED:     rasterizationState.cullMode = VK_CULL_MODE_NONE; break;
+        case GLS_CULL_BACKSIDED:    rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT; break;
+        default:                    rasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT; break;
+    }
+
+    // Blending
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.srcColorBlendFactor = GetSrcBlendFactor(stateBits);
+    blendAttachment.dstColorBlendFactor = GetDstBlendFactor(stateBits);
+    blendAttachment.colorBlendOp = GetBlendOp(stateBits);
+    blendAttachment.srcAlphaBlendFactor = blendAttachment.srcColorBlendFactor;
+    blendAttachment.dstAlphaBlendFactor = blendAttachment.dstColorBlendFactor;
+    blendAttachment.alphaBlendOp = blendAttachment.colorBlendOp;
+    blendAttachment.blendEnable = (blendAttachment.srcColorBlendFactor != VK_BLEND_FACTOR_ONE
+                                   || blendAttachment.dstColorBlendFactor != VK_BLEND_FACTOR_ZERO) ? VK_TRUE : VK_FALSE;
+
+    blendAttachment.colorWriteMask |= (stateBits & GLS_REDMASK) ? 0 : VK_COLOR_COMPONENT_R_BIT;
+    blendAttachment.colorWriteMask |= (stateBits & GLS_GREENMASK) ? 0 : VK_COLOR_COMPONENT_G_BIT;
+    blendAttachment.colorWriteMask |= (stateBits & GLS_BLUEMASK) ? 0 : VK_COLOR_COMPONENT_B_BIT;
+    blendAttachment.colorWriteMask |= (stateBits & GLS_ALPHAMASK) ? 0 : VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+    colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendState.attachmentCount = 1;
+    colorBlendState.pAttachments = &blendAttachment;
+
+    // Depth and stencil
+    VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+    depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilState.depthTestEnable = VK_TRUE;
+    depthStencilState.depthWriteEnable = (stateBits & GLS_DEPTHMASK) ? VK_FALSE : VK_TRUE;
+    depthStencilState.depthCompareOp = GetDepthCompareOp(stateBits);
+    depthStencilState.stencilTestEnable = (stateBits & GLS_STENCIL_BITS) ? VK_TRUE : VK_FALSE;
+    depthStencilState.front = GetStencilOpState(stateBits);
+    depthStencilState.back = depthStencilState.front;
+    depthStencilState.minDepthBounds = 0.0f;
+    depthStencilState.maxDepthBounds = 1.0f;
+
+    // Multisampling
+    VkPipelineMultisampleStateCreateInfo multisampleState = {};
+    multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleState.rasterizationSamples = vkContext.sampleCount;
+    if (vkContext.superSampling) {
+        multisampleState.sampleShadingEnable = VK_TRUE;
+        multisampleState.minSampleShading = 1.0f;
+    }
+
+    // Dynamic state
+    const VkDynamicState dynamicStates[] = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR,
+            VK_DYNAMIC_STATE_DEPTH_BIAS
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(dynamicStates[0]);
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkGraphicsPipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount = 2;
+    createInfo.pStages = stages;
+    createInfo.pVertexInputState = &vertexInputState;
+    createInfo.pInputAssemblyState = &inputAssemblyState;
+    createInfo.pViewportState = &viewportState;
+    createInfo.pRasterizationState = &rasterizationState;
+    createInfo.pMultisampleState = &multisampleState;
+    createInfo.pDepthStencilState = &depthStencilState;
+    createInfo.pColorBlendState = &colorBlendState;
+    createInfo.pDynamicState = &dynamicState;
+    createInfo.layout = m_pipelineLayout;
+    createInfo.renderPass = key.renderPass;
+    createInfo.subpass = 0;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    const VkResult result = vkCreateGraphicsPipelines(vkContext.device, vkContext.pipelineCache, 1, &createInfo, nullptr, &pipeline);
+
+    if (result != VK_SUCCESS) {
+        SDL_LogError(LOG_RENDER, "Couldn't create a pipeline of program %s for state bits 0x%llx: %s",
+                     program->name.c_str(), static_cast<unsigned long long>(stateBits), VkErrorToString(result));
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
 }
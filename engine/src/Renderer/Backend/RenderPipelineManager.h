@@ -5,32 +5,123 @@
 #ifndef RELOAD_RENDER_PIPELINE_MANAGER_H
 #define RELOAD_RENDER_PIPELINE_MANAGER_H
 
+#include <atomic>
+#include <shared_mutex>
+#include <string>
 #include "Common.h"
 #include "VulkanCommon.h"
+#include "ReloadLib/Hash.h"
+#include "ReloadLib/Containers/HashTable.h"
+#include "ReloadLib/sys/JobSystem.h"
 
+// Everything a pipeline is built from.
+struct PipelineKey {
+    int             program = -1;
+    uint64_t        stateBits = 0;
+    VkRenderPass    renderPass = VK_NULL_HANDLE;
+    VertexLayout    vertexLayout = VERTEX_LAYOUT_NONE;
+};
+
+struct PipelineKeyHashTraits {
+    static inline uint32_t  GetHash(const PipelineKey &key) {
+        uint64_t hash = Hash::FNV_OFFSET_BASIS_64;
+        hash = (hash ^ static_cast<uint64_t>(key.program)) * Hash::FNV_PRIME_64;
+        hash = (hash ^ key.stateBits) * Hash::FNV_PRIME_64;
+        hash = (hash ^ (uint64_t)key.renderPass) * Hash::FNV_PRIME_64;
+        hash = (hash ^ static_cast<uint64_t>(key.vertexLayout)) * Hash::FNV_PRIME_64;
+        return Hash::Int(hash);
+    }
+
+    static inline bool      Equals(const PipelineKey &a, const PipelineKey &b) {
+        return a.program == b.program && a.stateBits == b.stateBits
+            && a.renderPass == b.renderPass && a.vertexLayout == b.vertexLayout;
+    }
+};
+
+typedef enum {
+    PIPELINE_COMPILING,
+    PIPELINE_READY,
+    PIPELINE_FAILED
+} PipelineStatus;
+
+// A pipeline of the registry. The pipeline is published by the compile job.
 struct RenderProg {
-    uint64_t    stateBits;
-    VkPipeline  pipeline;
+    PipelineKey                     key;
+    std::atomic<VkPipeline>         pipeline{VK_NULL_HANDLE};
+    std::atomic<PipelineStatus>     status{PIPELINE_COMPILING};
+    std::atomic<bool>               used{false};                                // Drawn with while recording, goes into the manifest.
+};
+
+// The shaders of a program, shared by all its pipelines.
+struct PipelineProgram {
+    std::string         name;
+    VkShaderModule      vertexShader = VK_NULL_HANDLE;
+    VkShaderModule      fragmentShader = VK_NULL_HANDLE;
+    VertexLayout        vertexLayout = VERTEX_LAYOUT_NONE;
+    VkPipeline          fallback = VK_NULL_HANDLE;                              // GLS_DEFAULT on the main render pass.
 };
 
+/*
+================================================================================
+RenderPipelineManager
+
+DESCRIPTION:
+Registry of all the graphics pipelines, keyed by program, state bits, render
+pass and vertex layout. Lookups are a single hash table probe under a shared
+lock, so the job workers recording the view look up pipelines concurrently.
+
+A miss never compiles on the calling thread. It registers the pipeline and
+starts its compile on the job system, and until the pipeline is ready draws use
+the fallback of the program, which is its GLS_DEFAULT pipeline compiled when the
+program was loaded. Compiles go through the pipeline cache, so on warm starts
+they are mostly cache hits.
+
+To avoid the misses altogether, the pipelines a level uses are listed in a
+manifest that is compiled in parallel while the level loads. With
+`recordPipelines` set in the config, every pipeline drawn with is marked and
+SaveManifest writes them out, together with the ones of the manifest that was
+precompiled, so the manifest only grows over the recording sessions.
+================================================================================
+*/
 class RenderPipelineManager {
 public:
-    RenderPipelineManager();
-    ~RenderPipelineManager() = default;
+                    RenderPipelineManager();
+                    ~RenderPipelineManager();
+
+    void            Init();                                                     // Creates the shared pipeline layout, loads the built-in programs.
+    void            Shutdown();                                                 // Waits for the compiles and destroys all the pipelines.
+
+    int             LoadProgram(const char *name, const char *vertexPath, const char *fragmentPath,
+                                VertexLayout vertexLayout);                     // Loads the shaders and compiles the fallback. Returns the program index or -1.
+    int             FindProgram(std::string_view name) const;                   // Gets the index of a loaded program, -1 if unknown.
+
+    VkPipeline      GetPipeline(int program, uint64_t stateBits, VkRenderPass renderPass);    // Gets the pipeline, or the fallback while it compiles.
+    bool            BindPipeline(VkCommandBuffer commandBuffer, int program, uint64_t stateBits,
+                                 VkRenderPass renderPass);                      // Binds the pipeline. Returns `false` if there's nothing to draw with.
+
+    int             PrecompileManifest(const char *path);                       // Compiles the pipelines of the manifest in parallel, blocking. Returns the number compiled.
+    bool            SaveManifest(const char *path) const;                       // Writes the recorded pipelines. Returns `false` on IO errors.
+    void            ClearRecording();                                           // Forgets the recorded pipelines, for the next level.
 
-    void Init();                                                                // Initializes the rendering pipeline.
-    void Shutdown();                                                            // Shuts down the rendering pipeline.
-    void StartFrame();                                                          // Starts the frame drawing logic on the screen.
-    void Submit(uint64_t stateBits, VkCommandBuffer cmdBuffer);                 // Commits the command buffer to execute.
-    VkPipeline GetPipeline();                                                   // Gets the rendering pipeline.
+    [[nodiscard]] bool              IsRecording() const { return m_recording; }
+    [[nodiscard]] VkPipelineLayout  PipelineLayout() const { return m_pipelineLayout; }
+    [[nodiscard]] int               NumPipelines();                             // Gets the number of registered pipelines.
 
 private:
-    int					    m_counter;
-    int					    m_currentData;
+    RenderProg *    Register(const PipelineKey &key, bool &inserted);           // Finds or adds the pipeline, inserted tells whether it was added.
+    VkPipeline      Compile(const PipelineKey &key) const;                      // Builds the pipeline, blocking.
+    static void     CompileJob(void *data);
 
-    std::vector<RenderProg> m_renderProgs;
+    VkPipelineLayout                    m_pipelineLayout;
+    bool                                m_recording;                            // Marks the pipelines used for the manifest.
+    List<PipelineProgram *>             m_programs;
+    HashTable<std::string, int, StringHashTraitsI>  m_programIndices;
 
+    mutable std::shared_mutex           m_mutex;                                // Guards the registry, lookups take it shared.
+    HashTable<PipelineKey, RenderProg *, PipelineKeyHashTraits> m_renderProgs;
+    JobCounter                          m_compileCounter;                       // Compiles in flight.
 };
 
+extern RenderPipelineManager renderPipelineManager;
 
 #endif // !RELOAD_RENDER_PIPELINE_MANAGER_H
@@ -3,3 +3,47 @@
 //
 
 #include "RenderProgram.h"
+
+#include "ReloadLib/FileSystem.h"
+#include "VulkanHelpers.h"
+
+static const uint32_t SPIRV_MAGIC = 0x07230203;
+
+/*
+================================================================================
+RenderProgram::LoadShaderModule
+
+DESCRIPTION:
+Opens the SPIR-V asset and creates the shader module straight from the
+mapping. Loose files are mapped page aligned and archived blobs start on an
+ARCHIVE_ALIGNMENT boundary, both satisfy the 4 byte alignment Vulkan needs for
+the code pointer.
+
+RETURNS:
+The shader module, or VK_NULL_HANDLE if the file is missing or isn't SPIR-V.
+================================================================================
+*/
+VkShaderModule RenderProgram::LoadShaderModule(const char *path) {
+    AssetFile file;
+    if (!file.Open(path)) {
+        return VK_NULL_HANDLE;
+    }
+
+    const Span<const uint8_t> code = file.Data();
+    const auto * words = reinterpret_cast<const uint32_t *>(code.Data());
+
+    if (code.Size() < sizeof(uint32_t) || code.Size() % sizeof(uint32_t) != 0 || words[0] != SPIRV_MAGIC) {
+        SDL_LogError(LOG_RENDER, "%s is not a SPIR-V binary.", path);
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.Size();
+    createInfo.pCode = words;
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateShaderModule(vkContext.device, &createInfo, nullptr, &shaderModule))
+
+    return shaderModule;
+}
@@ -1,8 +1,12 @@
 #ifndef RELOAD_RENDER_PROGRAM_H
 #define RELOAD_RENDER_PROGRAM_H
 
-class RenderProgram {
+#include "Common.h"
+#include "VulkanCommon.h"
 
+class RenderProgram {
+public:
+    static VkShaderModule   LoadShaderModule(const char *path);                 // Creates a shader module from a SPIR-V file. Returns VK_NULL_HANDLE on failure.
 };
 
 
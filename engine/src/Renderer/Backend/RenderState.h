@@ -5,7 +5,120 @@
 #ifndef RELOAD_STATE_H
 #define RELOAD_STATE_H
 
+#include <cstdint>
+
 const auto STENCIL_SHADOW_TEST_VALUE = 128;
 const auto STENCIL_SHADOW_MASK_VALUE = 255;
 
+// The fixed function state of a pipeline, packed into 64 bits. Together with
+// the program, render pass and vertex layout it identifies a pipeline.
+
+// blend factors
+static const uint64_t GLS_SRCBLEND_ONE						= 0 << 0;
+static const uint64_t GLS_SRCBLEND_ZERO						= 1 << 0;
+static const uint64_t GLS_SRCBLEND_DST_COLOR				= 2 << 0;
+static const uint64_t GLS_SRCBLEND_ONE_MINUS_DST_COLOR		= 3 << 0;
+static const uint64_t GLS_SRCBLEND_SRC_ALPHA				= 4 << 0;
+static const uint64_t GLS_SRCBLEND_ONE_MINUS_SRC_ALPHA		= 5 << 0;
+static const uint64_t GLS_SRCBLEND_DST_ALPHA				= 6 << 0;
+static const uint64_t GLS_SRCBLEND_ONE_MINUS_DST_ALPHA		= 7 << 0;
+static const uint64_t GLS_SRCBLEND_BITS						= 7 << 0;
+
+static const uint64_t GLS_DSTBLEND_ZERO						= 0 << 3;
+static const uint64_t GLS_DSTBLEND_ONE						= 1 << 3;
+static const uint64_t GLS_DSTBLEND_SRC_COLOR				= 2 << 3;
+static const uint64_t GLS_DSTBLEND_ONE_MINUS_SRC_COLOR		= 3 << 3;
+static const uint64_t GLS_DSTBLEND_SRC_ALPHA				= 4 << 3;
+static const uint64_t GLS_DSTBLEND_ONE_MINUS_SRC_ALPHA		= 5 << 3;
+static const uint64_t GLS_DSTBLEND_DST_ALPHA				= 6 << 3;
+static const uint64_t GLS_DSTBLEND_ONE_MINUS_DST_ALPHA		= 7 << 3;
+static const uint64_t GLS_DSTBLEND_BITS						= 7 << 3;
+
+// write masks, a set bit disables the write
+static const uint64_t GLS_DEPTHMASK							= 1 << 6;
+static const uint64_t GLS_REDMASK							= 1 << 7;
+static const uint64_t GLS_GREENMASK							= 1 << 8;
+static const uint64_t GLS_BLUEMASK							= 1 << 9;
+static const uint64_t GLS_ALPHAMASK							= 1 << 10;
+static const uint64_t GLS_COLORMASK							= GLS_REDMASK | GLS_GREENMASK | GLS_BLUEMASK;
+
+static const uint64_t GLS_POLYMODE_LINE						= 1 << 11;
+static const uint64_t GLS_POLYGON_OFFSET					= 1 << 12;
+
+static const uint64_t GLS_DEPTHFUNC_LESS					= 0 << 13;
+static const uint64_t GLS_DEPTHFUNC_ALWAYS					= 1 << 13;
+static const uint64_t GLS_DEPTHFUNC_GREATER					= 2 << 13;
+static const uint64_t GLS_DEPTHFUNC_EQUAL					= 3 << 13;
+static const uint64_t GLS_DEPTHFUNC_BITS					= 3 << 13;
+
+static const uint64_t GLS_CULL_FRONTSIDED					= 0 << 15;
+static const uint64_t GLS_CULL_BACKSIDED					= 1 << 15;
+static const uint64_t GLS_CULL_TWOSIDED						= 2 << 15;
+static const uint64_t GLS_CULL_BITS							= 3 << 15;
+
+static const uint64_t GLS_MIRROR_VIEW						= 1 << 17;          // flips the front face
+
+static const uint64_t GLS_BLENDOP_ADD						= 0 << 18;
+static const uint64_t GLS_BLENDOP_SUB						= 1 << 18;
+static const uint64_t GLS_BLENDOP_MIN						= 2 << 18;
+static const uint64_t GLS_BLENDOP_MAX						= 3 << 18;
+static const uint64_t GLS_BLENDOP_BITS						= 3 << 18;
+
+// stencil, the reference and mask are baked into the pipeline as well
+static const int      GLS_STENCIL_FUNC_REF_SHIFT			= 20;
+static const uint64_t GLS_STENCIL_FUNC_REF_BITS				= 0xFFull << GLS_STENCIL_FUNC_REF_SHIFT;
+
+static const int      GLS_STENCIL_FUNC_MASK_SHIFT			= 28;
+static const uint64_t GLS_STENCIL_FUNC_MASK_BITS			= 0xFFull << GLS_STENCIL_FUNC_MASK_SHIFT;
+
+#define GLS_STENCIL_MAKE_REF(x)		((static_cast<uint64_t>(x) << GLS_STENCIL_FUNC_REF_SHIFT) & GLS_STENCIL_FUNC_REF_BITS)
+#define GLS_STENCIL_MAKE_MASK(x)	((static_cast<uint64_t>(x) << GLS_STENCIL_FUNC_MASK_SHIFT) & GLS_STENCIL_FUNC_MASK_BITS)
+
+static const uint64_t GLS_STENCIL_FUNC_ALWAYS				= 0ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_LESS					= 1ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_LEQUAL				= 2ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_GREATER				= 3ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_GEQUAL				= 4ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_EQUAL				= 5ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_NOTEQUAL				= 6ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_NEVER				= 7ull << 36;
+static const uint64_t GLS_STENCIL_FUNC_BITS					= 7ull << 36;
+
+static const uint64_t GLS_STENCIL_OP_FAIL_KEEP				= 0ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_ZERO				= 1ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_REPLACE			= 2ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_INCR				= 3ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_DECR				= 4ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_INVERT			= 5ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_INCR_WRAP			= 6ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_DECR_WRAP			= 7ull << 39;
+static const uint64_t GLS_STENCIL_OP_FAIL_BITS				= 7ull << 39;
+
+static const uint64_t GLS_STENCIL_OP_ZFAIL_KEEP				= 0ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_ZERO				= 1ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_REPLACE			= 2ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_INCR				= 3ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_DECR				= 4ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_INVERT			= 5ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_INCR_WRAP		= 6ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_DECR_WRAP		= 7ull << 42;
+static const uint64_t GLS_STENCIL_OP_ZFAIL_BITS				= 7ull << 42;
+
+static const uint64_t GLS_STENCIL_OP_PASS_KEEP				= 0ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_ZERO				= 1ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_REPLACE			= 2ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_INCR				= 3ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_DECR				= 4ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_INVERT			= 5ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_INCR_WRAP			= 6ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_DECR_WRAP			= 7ull << 45;
+static const uint64_t GLS_STENCIL_OP_PASS_BITS				= 7ull << 45;
+
+static const uint64_t GLS_STENCIL_OP_BITS					= GLS_STENCIL_OP_FAIL_BITS | GLS_STENCIL_OP_ZFAIL_BITS | GLS_STENCIL_OP_PASS_BITS;
+
+// stencil testing is enabled when any of the func or op bits are set
+static const uint64_t GLS_STENCIL_BITS						= GLS_STENCIL_FUNC_BITS | GLS_STENCIL_OP_BITS;
+
+static const uint64_t GLS_DEFAULT							= 0;
+
 #endif //RELOAD_STATE_H
@@ -0,0 +1,170 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_RETIRE_QUEUE_H
+#define RELOAD_RETIRE_QUEUE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "ReloadLib/Containers/List.h"
+
+/*
+================================================================================
+RetireQueue<T>
+
+DESCRIPTION:
+FIFO of values waiting for the GPU timeline to reach their retire value. The
+queue is kept in timeline order, a value lower than the one before it is raised
+to it, so `Collect` only has to look at the front.
+
+NOTE:
+Not thread safe, the owner guards it with its own lock.
+================================================================================
+*/
+template<typename T>
+class RetireQueue {
+public:
+                    RetireQueue() : m_first(0), m_lastValue(0) {}
+
+    void            Push(const T &value, uint64_t retireValue);                 // Queues the value until the timeline reaches retireValue.
+    template<typename F>
+    int             Collect(uint64_t completed, const F &fn, int maxCount = INT_MAX);  // Calls fn on the values retired by completed. Returns their number.
+    template<typename F>
+    void            Flush(const F &fn);                                         // Calls fn on all the values and empties the queue.
+    void            Clear();                                                    // Drops all the values and frees the storage.
+
+    [[nodiscard]] int       NumPending() const { return m_values.Size() - m_first; }  // Gets the number of values waiting.
+    [[nodiscard]] uint64_t  FrontValue() const;                                 // Gets the retire value of the oldest entry, 0 if empty.
+
+private:
+    struct Entry {
+        T               value;
+        uint64_t        retireValue;
+    };
+
+    void            Compact();
+
+    List<Entry>     m_values;                                                   // [m_first, Size()) is pending.
+    int             m_first;
+    uint64_t        m_lastValue;                                                // Retire value of the newest entry.
+};
+
+/*
+================================================================================
+RetireQueue<T>::Push
+
+DESCRIPTION:
+Appends the value to the back of the queue.
+================================================================================
+*/
+template<typename T>
+inline void RetireQueue<T>::Push(const T &value, uint64_t retireValue) {
+    m_lastValue = std::max(m_lastValue, retireValue);
+
+    Entry & entry = m_values.Alloc();
+    entry.value = value;
+    entry.retireValue = m_lastValue;
+}
+
+/*
+================================================================================
+RetireQueue<T>::Collect
+
+DESCRIPTION:
+Takes up to `maxCount` values off the front of the queue whose retire value
+`completed` has reached and calls `fn` on each of them, oldest first.
+
+RETURNS:
+The number of values taken off the queue.
+================================================================================
+*/
+template<typename T>
+template<typename F>
+inline int RetireQueue<T>::Collect(uint64_t completed, const F &fn, int maxCount) {
+    const int numValues = m_values.Size();
+
+    int count = 0;
+    while (count < maxCount && m_first < numValues && m_values[m_first].retireValue <= completed) {
+        fn(m_values[m_first++].value);
+        count++;
+    }
+
+    Compact();
+    return count;
+}
+
+/*
+================================================================================
+RetireQueue<T>::Flush
+
+DESCRIPTION:
+Calls `fn` on every pending value regardless of the timeline, used once the GPU
+is idle.
+================================================================================
+*/
+template<typename T>
+template<typename F>
+inline void RetireQueue<T>::Flush(const F &fn) {
+    for (int i = m_first; i < m_values.Size(); i++) {
+        fn(m_values[i].value);
+    }
+
+    Clear();
+}
+
+/*
+================================================================================
+RetireQueue<T>::Clear
+
+DESCRIPTION:
+Drops all the values without calling anything on them.
+================================================================================
+*/
+template<typename T>
+inline void RetireQueue<T>::Clear() {
+    m_values.Clear();
+    m_first = 0;
+    m_lastValue = 0;
+}
+
+/*
+================================================================================
+RetireQueue<T>::FrontValue
+
+RETURNS:
+The retire value of the oldest pending entry, 0 when the queue is empty.
+================================================================================
+*/
+template<typename T>
+inline uint64_t RetireQueue<T>::FrontValue() const {
+    return m_first < m_values.Size() ? m_values[m_first].retireValue : 0;
+}
+
+/*
+================================================================================
+RetireQueue<T>::Compact
+
+DESCRIPTION:
+Keeps the storage when the queue drains, values are retired every frame, and
+moves the pending part down once the retired part outgrows it.
+================================================================================
+*/
+template<typename T>
+inline void RetireQueue<T>::Compact() {
+    const int numValues = m_values.Size();
+
+    if (m_first == numValues) {
+        m_values.SetSize(0);
+        m_first = 0;
+    } else if (m_first > numValues / 2) {
+        for (int i = m_first; i < numValues; i++) {
+            m_values[i - m_first] = m_values[i];
+        }
+        m_values.SetSize(numValues - m_first);
+        m_first = 0;
+    }
+}
+
+#endif //RELOAD_RETIRE_QUEUE_H
@@ -5,6 +5,7 @@
 #include "StagingManager.h"
 
 #include "ConfigManager.h"
+#include "GpuTimeline.h"
 #include "VulkanCommon.h"
 #include "VulkanHelpers.h"
 #include "VulkanMemory.h"
@@ -20,11 +21,21 @@ The default constructor.
 ================================================================================
 */
 StagingManager::StagingManager() {
-    m_maxBufferSize = 0;
-    m_currentBuffer = 0;
+    m_ringSize      = 0;
     m_mappedData    = nullptr;
     m_memory        = VK_NULL_HANDLE;
+    m_buffer        = VK_NULL_HANDLE;
     m_commandPool   = VK_NULL_HANDLE;
+    m_acquirePool   = VK_NULL_HANDLE;
+    m_useTransferQueue = false;
+
+    m_head              = 0;
+    m_tail              = 0;
+    m_numSegments       = 0;
+    m_currentSegment    = 0;
+    m_oldestSegment     = 0;
+    m_numPending        = 0;
+    m_nextSerial        = 1;
 }
 
 /*
@@ -42,48 +53,46 @@ StagingManager::~StagingManager() = default;
 StagingManager::Init
 
 DESCRIPTION:
-Initializes the staging manager.
+Creates the ring buffer of uploadBufferSizeMB, maps it for the lifetime of the
+manager and creates the command buffers of uploadSegments segments.
+The copies are recorded for the dedicated transfer queue when there is one.
 ================================================================================
 */
 void StagingManager::Init() {
-    m_maxBufferSize = vkConfig.uploadBufferSizeMB * 1024 * 1024;
+    m_ringSize = vkConfig.uploadBufferSizeMB * 1024 * 1024;
+    m_numSegments = std::max(2u, std::min(vkConfig.uploadSegments, MAX_STAGING_SEGMENTS));
+    m_useTransferQueue = vkContext.transferQueue != VK_NULL_HANDLE
+            && vkContext.transferFamilyIdx != vkContext.graphicsFamilyIdx;
 
     VkBufferCreateInfo bufferCreateInfo = {};
     bufferCreateInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferCreateInfo.size   = static_cast<VkDeviceSize>(m_maxBufferSize);
+    bufferCreateInfo.size   = static_cast<VkDeviceSize>(m_ringSize);
     bufferCreateInfo.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
-    for (auto & m_buffer : m_buffers) {
-        m_buffer.offset = 0;
-
-        VK_CHECK(vkCreateBuffer(vkContext.device, &bufferCreateInfo, nullptr, &m_buffer.buffer))
-    }
+    VK_CHECK(vkCreateBuffer(vkContext.device, &bufferCreateInfo, nullptr, &m_buffer))
 
     VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(vkContext.device, m_buffers[0].buffer, &memoryRequirements);
-
-    const VkDeviceSize alignMod = memoryRequirements.size % memoryRequirements.alignment;
-    const VkDeviceSize alignedSize = (alignMod == 0)
-            ? memoryRequirements.size
-            : memoryRequirements.size + memoryRequirements.alignment - alignMod;
+    vkGetBufferMemoryRequirements(vkContext.device, m_buffer, &memoryRequirements);
 
     VkMemoryAllocateInfo memoryAllocateInfo = {};
     memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize = alignedSize * MAX_FRAMES_IN_FLIGHT;
+    memoryAllocateInfo.allocationSize = memoryRequirements.size;
     memoryAllocateInfo.memoryTypeIndex = FindMemoryTypeIndex(memoryRequirements.memoryTypeBits, VK_MEMORY_USAGE_CPU_TO_GPU);
 
     VK_CHECK(vkAllocateMemory(vkContext.device, &memoryAllocateInfo, nullptr, &m_memory))
-
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i ) {
-        VK_CHECK(vkBindBufferMemory(vkContext.device, m_buffers[i].buffer, m_memory, i * alignedSize))
-    }
-
-    VK_CHECK(vkMapMemory(vkContext.device, m_memory, 0, alignedSize * MAX_FRAMES_IN_FLIGHT, 0, reinterpret_cast< void ** >( &m_mappedData )))
+    VK_CHECK(vkBindBufferMemory(vkContext.device, m_buffer, m_memory, 0))
+    VK_CHECK(vkMapMemory(vkContext.device, m_memory, 0, memoryRequirements.size, 0, reinterpret_cast< void ** >( &m_mappedData )))
 
     VkCommandPoolCreateInfo commandPoolCreateInfo = {};
     commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     commandPoolCreateInfo.queueFamilyIndex = static_cast<uint32_t>(vkContext.graphicsFamilyIdx);
+
+    if (m_useTransferQueue) {
+        VK_CHECK(vkCreateCommandPool(vkContext.device, &commandPoolCreateInfo, nullptr, &m_acquirePool))
+        commandPoolCreateInfo.queueFamilyIndex = static_cast<uint32_t>(vkContext.transferFamilyIdx);
+    }
+
     VK_CHECK(vkCreateCommandPool(vkContext.device, &commandPoolCreateInfo, nullptr, &m_commandPool))
 
     VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
@@ -91,19 +100,30 @@ void StagingManager::Init() {
     commandBufferAllocateInfo.commandPool = m_commandPool;
     commandBufferAllocateInfo.commandBufferCount = 1;
 
-    VkFenceCreateInfo fenceCreateInfo = {};
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-
-    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i ) {
-        VK_CHECK(vkAllocateCommandBuffers(vkContext.device, &commandBufferAllocateInfo, &m_buffers[i].commandBuffer))
-        VK_CHECK(vkCreateFence(vkContext.device, &fenceCreateInfo, nullptr, &m_buffers[i].fence))
-        VK_CHECK(vkBeginCommandBuffer(m_buffers[ i ].commandBuffer, &commandBufferBeginInfo))
+    for (uint32_t i = 0; i < m_numSegments; ++i ) {
+        commandBufferAllocateInfo.commandPool = m_commandPool;
+        VK_CHECK(vkAllocateCommandBuffers(vkContext.device, &commandBufferAllocateInfo, &m_segments[i].commandBuffer))
 
-        m_buffers[i].data = static_cast<char *>(m_mappedData) + (i * alignedSize);
+        if (m_useTransferQueue) {
+            commandBufferAllocateInfo.commandPool = m_acquirePool;
+            VK_CHECK(vkAllocateCommandBuffers(vkContext.device, &commandBufferAllocateInfo, &m_segments[i].acquireBuffer))
+            VK_CHECK(vkCreateSemaphore(vkContext.device, &semaphoreCreateInfo, nullptr, &m_segments[i].semaphore))
+        }
     }
+
+    SDL_LogInfo(LOG_RENDER, "Staging uploads on the %s queue.", m_useTransferQueue ? "transfer" : "graphics");
+
+    m_head = 0;
+    m_tail = 0;
+    m_currentSegment = 0;
+    m_oldestSegment = 0;
+    m_numPending = 0;
+    m_nextSerial = 1;
+
+    BeginSegment();
 }
 
 /*
@@ -115,90 +135,123 @@ Shuts down the stagingManager manager.
 ================================================================================
 */
 void StagingManager::Shutdown() {
+    while (m_numPending > 0) {
+        RetireOldest();
+    }
+
     vkUnmapMemory(vkContext.device, m_memory);
+    vkFreeMemory(vkContext.device, m_memory, nullptr);
+    vkDestroyBuffer(vkContext.device, m_buffer, nullptr);
     m_memory = VK_NULL_HANDLE;
+    m_buffer = VK_NULL_HANDLE;
     m_mappedData = nullptr;
 
-    for (auto & buffer : m_buffers) {
-        vkDestroyFence(vkContext.device, buffer.fence, nullptr);
-        vkDestroyBuffer(vkContext.device, buffer.buffer, nullptr);
-        vkFreeCommandBuffers(vkContext.device, m_commandPool, 1, &buffer.commandBuffer);
+    for (uint32_t i = 0; i < m_numSegments; ++i ) {
+        vkFreeCommandBuffers(vkContext.device, m_commandPool, 1, &m_segments[i].commandBuffer);
+
+        if (m_useTransferQueue) {
+            vkDestroySemaphore(vkContext.device, m_segments[i].semaphore, nullptr);
+            vkFreeCommandBuffers(vkContext.device, m_acquirePool, 1, &m_segments[i].acquireBuffer);
+        }
+
+        m_segments[i] = RVkStagingSegment();
+    }
+
+    vkDestroyCommandPool(vkContext.device, m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+
+    if (m_acquirePool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(vkContext.device, m_acquirePool, nullptr);
+        m_acquirePool = VK_NULL_HANDLE;
     }
-    memset(m_buffers, 0, sizeof(m_buffers));
 
-    m_maxBufferSize = 0;
-    m_currentBuffer = 0;
+    m_ringSize = 0;
+    m_numSegments = 0;
 }
 
 /*
 ================================================================================
-Class::Method
+StagingManager::Stage
 
 DESCRIPTION:
+Allocates `size` bytes of the ring, never straddling the end of the buffer.
+Segments the GPU is done with are retired first. If the allocation still
+overlaps data in flight, the segments holding it are submitted and waited for.
+
 RETURNS:
-NOTE:
+The mapped memory to write the upload to, along with the command buffer to
+record the copy into and the buffer and offset to copy from. nullptr if the
+size is over MaxStageSize, which StageChunks never asks for.
 ================================================================================
 */
 char *StagingManager::Stage(uint32_t size, uint32_t alignment,
                             VkCommandBuffer &commandBuffer, VkBuffer &buffer,
                             VkDeviceSize &bufferOffset) {
-    if (size > m_maxBufferSize) {
-        spdlog::critical(
-                "Can't allocate {} MB in gpu transfer buffer",
-                (int)(size / 1024 / 1024 ));
+    if (size > MaxStageSize()) {
+        SDL_LogError(LOG_RENDER, "Can't stage %u bytes in a %u MB upload buffer.", size, m_ringSize / 1024 / 1024);
+        return nullptr;
     }
 
-    RVkStagingBuffer * stage = &m_buffers[m_currentBuffer];
-    uint32_t alignMod = (uint32_t)stage->offset % alignment;
-    stage->offset = ((stage->offset % alignment) == 0)
-            ? stage->offset
-            : (stage->offset + alignment - alignMod);
-
-    if ((stage->offset + size) >= (m_maxBufferSize) && !stage->submitted) {
-        Flush();
+    uint64_t position = m_head + (alignment - m_head % alignment) % alignment;
+    const uint64_t ringOffset = position % m_ringSize;
+    if (ringOffset + size > m_ringSize) {
+        position += m_ringSize - ringOffset;
     }
 
-    stage = &m_buffers[m_currentBuffer];
-    if (stage->submitted) {
-        Wait(*stage);
+    RetireCompleted();
+
+    while (position + size - m_tail > m_ringSize) {
+        // The ring wrapped onto data the GPU hasn't consumed yet.
+        if (m_numPending == 0) {
+            Flush();
+        } else {
+            RetireOldest();
+        }
     }
 
-    commandBuffer = stage->commandBuffer;
-    buffer = stage->buffer;
-    bufferOffset = stage->offset;
+    m_head = position + size;
 
-    char * data = stage->data + stage->offset;
-    stage->offset += size;
+    commandBuffer = m_segments[m_currentSegment].commandBuffer;
+    buffer = m_buffer;
+    bufferOffset = position % m_ringSize;
 
-    return data;
+    return m_mappedData + bufferOffset;
 }
 
 /*
 ================================================================================
-Class::Method
+StagingManager::Flush
 
 DESCRIPTION:
-RETURNS:
-NOTE:
+Submits the uploads recorded into the current segment and starts the next one.
+Doesn't wait for anything unless all the segments are in flight.
+
+On the graphics queue the submit signals the GPU timeline value that retires
+the segment. On the transfer queue the segment signals its semaphore instead,
+and its acquire is submitted to the graphics queue right away, waiting on the
+semaphore and signaling the timeline value. Either way the uploads are ordered
+before anything submitted to the graphics queue after the Flush.
 ================================================================================
 */
 void StagingManager::Flush() {
-    RVkStagingBuffer & stage = m_buffers[m_currentBuffer];
-    if (stage.submitted || stage.offset == 0) {
+    RVkStagingSegment & segment = m_segments[m_currentSegment];
+    if (segment.begin == m_head) {
         return;
     }
 
-    VkMemoryBarrier barrier = {};
-    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
-    vkCmdPipelineBarrier(
-            stage.commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    if (!m_useTransferQueue) {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(
+                segment.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
 
-    vkEndCommandBuffer(stage.commandBuffer);
+    VK_CHECK(vkEndCommandBuffer(segment.commandBuffer))
 
     VkMappedMemoryRange memoryRange = {};
     memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
@@ -209,28 +262,251 @@ void StagingManager::Flush() {
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &stage.commandBuffer;
+    submitInfo.pCommandBuffers = &segment.commandBuffer;
 
-    vkQueueSubmit(vkContext.graphicsQueue, 1, &submitInfo, stage.fence);
+    if (m_useTransferQueue) {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &segment.semaphore;
 
-    stage.submitted = true;
+        VK_CHECK(vkQueueSubmit(vkContext.transferQueue, 1, &submitInfo, VK_NULL_HANDLE))
 
-    m_currentBuffer = (m_currentBuffer + 1) % MAX_FRAMES_IN_FLIGHT;
+        // Images and buffers are used as soon as the Flush returns, so the
+        // ownership has to be acquired before any later graphics submit.
+        SubmitAcquire(segment);
+    } else {
+        segment.retireValue = gpuTimeline.Advance();
+        VkSemaphore timeline = gpuTimeline.Semaphore();
+
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &segment.retireValue;
+
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &timeline;
+
+        VK_CHECK(vkQueueSubmit(vkContext.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE))
+    }
+
+    segment.end = m_head;
+    segment.submitted = true;
+    m_numPending++;
+
+    m_currentSegment = (m_currentSegment + 1) % m_numSegments;
+
+    if (m_numPending == m_numSegments) {
+        RetireOldest();
+    }
+
+    BeginSegment();
 }
 
-void StagingManager::Wait(RVkStagingBuffer &stage) {
-    if (!stage.submitted) {
-        return;
+/*
+================================================================================
+StagingManager::RetireCompleted
+
+DESCRIPTION:
+Retires the submitted segments from the oldest one until one is still in
+flight, going by their timeline values.
+================================================================================
+*/
+void StagingManager::RetireCompleted() {
+    while (m_numPending > 0) {
+        RVkStagingSegment & segment = m_segments[m_oldestSegment];
+        if (!gpuTimeline.IsComplete(segment.retireValue)) {
+            return;
+        }
+
+        m_tail = segment.end;
+        segment.submitted = false;
+        m_oldestSegment = (m_oldestSegment + 1) % m_numSegments;
+        m_numPending--;
     }
+}
 
-    VK_CHECK(vkWaitForFences(vkContext.device, 1, &stage.fence, VK_TRUE, UINT64_MAX))
-    VK_CHECK(vkResetFences(vkContext.device, 1, &stage.fence))
+/*
+================================================================================
+StagingManager::RetireOldest
 
-    stage.offset = 0;
-    stage.submitted = false;
+DESCRIPTION:
+Blocks until the GPU is done with the oldest submitted segment and retires it.
+================================================================================
+*/
+void StagingManager::RetireOldest() {
+    assert(m_numPending > 0);
+
+    RVkStagingSegment & segment = m_segments[m_oldestSegment];
+
+    gpuTimeline.Wait(segment.retireValue);
+
+    m_tail = segment.end;
+    segment.submitted = false;
+    m_oldestSegment = (m_oldestSegment + 1) % m_numSegments;
+    m_numPending--;
+}
+
+/*
+================================================================================
+StagingManager::BeginSegment
+
+DESCRIPTION:
+Starts recording the current segment at the head of the ring. When nothing is
+in flight, the tail catches up with it.
+================================================================================
+*/
+void StagingManager::BeginSegment() {
+    RVkStagingSegment & segment = m_segments[m_currentSegment];
+    assert(!segment.submitted);
+
+    segment.serial = m_nextSerial++;
+    segment.begin = m_head;
+    segment.end = m_head;
+
+    if (m_numPending == 0) {
+        m_tail = m_head;
+    }
 
     VkCommandBufferBeginInfo commandBufferBeginInfo = {};
     commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VK_CHECK(vkBeginCommandBuffer(segment.commandBuffer, &commandBufferBeginInfo))
+
+    if (m_useTransferQueue) {
+        VK_CHECK(vkBeginCommandBuffer(segment.acquireBuffer, &commandBufferBeginInfo))
+    }
+}
+
+/*
+================================================================================
+StagingManager::SubmitAcquire
+
+DESCRIPTION:
+Submits the acquiring half of the ownership transfers of a segment that was
+just submitted to the transfer queue. It waits for the semaphore of the segment
+and signals the timeline value that retires the segment.
+================================================================================
+*/
+void StagingManager::SubmitAcquire(RVkStagingSegment &segment) {
+    const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSemaphore timeline = gpuTimeline.Semaphore();
+
+    VK_CHECK(vkEndCommandBuffer(segment.acquireBuffer))
+
+    segment.retireValue = gpuTimeline.Advance();
+
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &segment.retireValue;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &segment.semaphore;
+    submitInfo.pWaitDstStageMask = &waitStageMask;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &segment.acquireBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline;
+
+    VK_CHECK(vkQueueSubmit(vkContext.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE))
+}
+
+/*
+================================================================================
+StagingManager::IsUploadDone
+
+DESCRIPTION:
+Checks the upload against the segment it was recorded into. Uploads of the
+segment being recorded aren't submitted yet, those of retired segments are done
+and the others are done once the timeline passed the value of their segment.
+
+RETURNS:
+`true` if the GPU finished the upload, also for id 0.
+================================================================================
+*/
+bool StagingManager::IsUploadDone(uint64_t uploadId) const {
+    if (uploadId >= m_segments[m_currentSegment].serial) {
+        return false;
+    }
 
-    VK_CHECK(vkBeginCommandBuffer(stage.commandBuffer, &commandBufferBeginInfo))
-}
\ No newline at end of file
+    for (uint32_t i = 0; i < m_numPending; i++) {
+        const RVkStagingSegment & segment = m_segments[(m_oldestSegment + i) % m_numSegments];
+        if (segment.serial == uploadId) {
+            return gpuTimeline.IsComplete(segment.retireValue);
+        }
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+StagingManager::HandOffImage
+
+DESCRIPTION:
+Records the transition of an uploaded image from TRANSFER_DST_OPTIMAL to the
+layout in the barrier, ready to be sampled. On the transfer queue the barrier is
+split into the release on the transfer queue and the acquire on the graphics
+queue, which has to be the first use of the image there.
+================================================================================
+*/
+void StagingManager::HandOffImage(VkCommandBuffer commandBuffer, VkImageMemoryBarrier barrier) {
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+    if (!m_useTransferQueue) {
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+
+    barrier.srcQueueFamilyIndex = static_cast<uint32_t>(vkContext.transferFamilyIdx);
+    barrier.dstQueueFamilyIndex = static_cast<uint32_t>(vkContext.graphicsFamilyIdx);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(m_segments[m_currentSegment].acquireBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+/*
+================================================================================
+StagingManager::HandOffBuffer
+
+DESCRIPTION:
+Makes an uploaded buffer range visible to the given stages and accesses of the
+graphics queue, transferring its ownership when the copy ran on the transfer
+queue.
+================================================================================
+*/
+void StagingManager::HandOffBuffer(VkCommandBuffer commandBuffer, VkBufferMemoryBarrier barrier, VkPipelineStageFlags dstStageMask) {
+    const VkAccessFlags dstAccessMask = barrier.dstAccessMask;
+
+    if (!m_useTransferQueue) {
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        return;
+    }
+
+    barrier.srcQueueFamilyIndex = static_cast<uint32_t>(vkContext.transferFamilyIdx);
+    barrier.dstQueueFamilyIndex = static_cast<uint32_t>(vkContext.graphicsFamilyIdx);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dstAccessMask;
+    vkCmdPipelineBarrier(m_segments[m_currentSegment].acquireBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
@@ -8,6 +8,39 @@
 #include "RenderCommon.h"
 #include "VulkanCommon.h"
 
+static const uint32_t MAX_STAGING_SEGMENTS = 16;
+
+/*
+================================================================================
+StagingManager
+
+DESCRIPTION:
+Ring allocator over one persistently mapped upload buffer. Allocations are
+recorded into the current segment, which is submitted by Flush once per frame,
+or earlier when the ring runs out of space. Every submitted segment is retired
+by the GPU timeline value its submit signals, which is polled without blocking,
+and frees its part of the ring.
+Staging only blocks when the ring wraps onto data the GPU is still reading, or
+when all the segments are in flight.
+
+Ring positions only ever grow, the byte in the buffer is `position % size`, so
+the space in use is simply [m_tail, m_head).
+
+When the GPU has a dedicated transfer queue the copies run there, so the DMA
+engine streams data while the graphics queue keeps rendering. Every segment then
+releases the ownership of what it uploaded, and a second command buffer acquires
+it on the graphics queue behind a semaphore. The acquire is submitted by the
+same Flush, right behind the copies, so on both paths everything submitted to
+the graphics queue after a Flush sees its uploads.
+
+Every segment has a serial, StageChunks returns it as the id of the upload. The
+id tells when the GPU is done with the upload, for users that must not touch the
+destination before, like streaming and defragmenting images.
+
+NOTE:
+Not thread safe. Uploads are recorded on the render thread, or before it starts.
+================================================================================
+*/
 class StagingManager {
 public:
                     StagingManager();
@@ -16,22 +49,90 @@ public:
     void			Init();
     void			Shutdown();
 
-    char *			Stage(uint32_t size, uint32_t alignment, VkCommandBuffer & commandBuffer, VkBuffer & buffer, VkDeviceSize & bufferOffset);
-    void			Flush();
+    template<typename F>
+    uint64_t        StageChunks(uint32_t size, uint32_t alignment, uint32_t granularity, const F &func);   // Stages an upload of any size in chunks. Returns its id.
+    void			Flush();                                                    // Submits the current segment.
+    bool            IsUploadDone(uint64_t uploadId) const;                      // Checks whether the GPU finished the upload, without waiting.
+
+    void            HandOffImage(VkCommandBuffer commandBuffer, VkImageMemoryBarrier barrier);     // Transitions an uploaded image for sampling on the graphics queue.
+    void            HandOffBuffer(VkCommandBuffer commandBuffer, VkBufferMemoryBarrier barrier,
+                                  VkPipelineStageFlags dstStageMask);           // Makes an uploaded buffer range visible on the graphics queue.
+
+    [[nodiscard]] bool      UsesTransferQueue() const { return m_useTransferQueue; }
+
+    [[nodiscard]] uint32_t  MaxStageSize() const { return m_ringSize / 2; }     // Largest chunk StageChunks stages at once.
 
 private:
-    void			Wait(RVkStagingBuffer & stage);
+    char *			Stage(uint32_t size, uint32_t alignment, VkCommandBuffer & commandBuffer, VkBuffer & buffer, VkDeviceSize & bufferOffset);
+    void            RetireCompleted();                                          // Retires the segments the GPU is done with, without waiting.
+    void            RetireOldest();                                             // Waits for the oldest segment and retires it.
+    void            BeginSegment();                                             // Starts recording the next segment.
+    void            SubmitAcquire(RVkStagingSegment & segment);                 // Submits the acquiring half of a segment on the transfer queue.
 
 private:
-    uint32_t	    m_maxBufferSize;
-    uint32_t		m_currentBuffer;
+    uint32_t	    m_ringSize;
     char *			m_mappedData;
     VkDeviceMemory	m_memory;
-    VkCommandPool	m_commandPool;
+    VkBuffer        m_buffer;
+    VkCommandPool	m_commandPool;                                              // Pool of the queue the copies run on.
+    VkCommandPool   m_acquirePool;                                              // Graphics pool of the acquire buffers.
+    bool            m_useTransferQueue;
 
-    RVkStagingBuffer   m_buffers[MAX_FRAMES_IN_FLIGHT];
+    uint64_t        m_head;                                                     // Ring position of the next allocation.
+    uint64_t        m_tail;                                                     // Ring position of the oldest data in use.
+
+    RVkStagingSegment   m_segments[MAX_STAGING_SEGMENTS];
+    uint32_t            m_numSegments;
+    uint32_t            m_currentSegment;                                       // The segment being recorded.
+    uint32_t            m_oldestSegment;                                        // The oldest submitted segment.
+    uint32_t            m_numPending;                                           // Submitted segments not retired yet.
+    uint64_t            m_nextSerial;                                           // Serial of the next segment to begin.
 };
 
 extern StagingManager stagingManager;
 
+/*
+================================================================================
+StagingManager::StageChunks
+
+DESCRIPTION:
+Stages an upload that may be larger than the ring by splitting it into chunks
+that are multiples of `granularity`, for example a row of texels or a row of
+compressed blocks. For every chunk `func(data, offset, size, commandBuffer,
+buffer, bufferOffset)` is called to fill the staged memory at `data` with bytes
+[offset, offset + size) of the upload and to record the copy.
+
+RETURNS:
+The id of the upload for IsUploadDone: the serial of the segment holding the
+last chunk, segments complete in order. 0 when there's nothing to upload.
+================================================================================
+*/
+template<typename F>
+inline uint64_t StagingManager::StageChunks(uint32_t size, uint32_t alignment, uint32_t granularity, const F &func) {
+    assert(granularity > 0 && granularity <= MaxStageSize());
+
+    const uint32_t maxChunk = MaxStageSize() - MaxStageSize() % granularity;
+    uint64_t uploadId = 0;
+
+    for (uint32_t offset = 0; offset < size; ) {
+        const uint32_t chunk = std::min(size - offset, maxChunk);
+
+        VkCommandBuffer commandBuffer;
+        VkBuffer buffer;
+        VkDeviceSize bufferOffset;
+        char * data = Stage(chunk, alignment, commandBuffer, buffer, bufferOffset);
+        if (data == nullptr) {
+            return uploadId;
+        }
+
+        // Stage may have flushed, the chunk is recorded into the current segment.
+        uploadId = m_segments[m_currentSegment].serial;
+
+        func(data, offset, chunk, commandBuffer, buffer, bufferOffset);
+        offset += chunk;
+    }
+
+    return uploadId;
+}
+
 #endif //RELOAD_STAGING_MANAGER_H
@@ -18,8 +18,12 @@ struct GPU {
     VkPhysicalDeviceProperties          props{};
     VkPhysicalDeviceMemoryProperties    memProps{};
     VkPhysicalDeviceFeatures            features{};
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT   descriptorIndexingFeatures{};
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProps{};
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR    timelineSemaphoreFeatures{};
     VkSurfaceCapabilitiesKHR            surfaceCaps{};
-    VkQueueFlags                        supportedQueues;
+    VkQueueFlags                        supportedQueues = 0;
+    bool                                memoryBudget = false;                   // VK_EXT_memory_budget is supported
 
     std::vector<VkSurfaceFormatKHR>            surfaceFormats;
     std::vector<VkPresentModeKHR>              presentModes;
@@ -53,17 +57,22 @@ struct RVkSwapchain {
     VkFormat format = VK_FORMAT_UNDEFINED;
     VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
     VkExtent2D extent{};
-    VkImage images[MAX_FRAMES_IN_FLIGHT];
+    VkImage images[MAX_SWAPCHAIN_IMAGES];
     int imageCount = 0;
 };
 
-struct RVkStagingBuffer {
+// A run of the staging ring recorded into one command buffer and retired by one GPU timeline value.
+struct RVkStagingSegment {
     bool				submitted = false;
+    uint64_t            serial = 0;                                             // Upload id of everything recorded into the segment.
     VkCommandBuffer		commandBuffer = VK_NULL_HANDLE;
-    VkBuffer			buffer = VK_NULL_HANDLE;
-    VkFence				fence = VK_NULL_HANDLE;
-    VkDeviceSize		offset = 0;
-    char *				data = nullptr;
+    uint64_t            retireValue = 0;                                        // Timeline value signaled once the GPU is done with the segment.
+    uint64_t    		begin = 0;                                              // Ring position of the first byte.
+    uint64_t    		end = 0;                                                // Ring position past the last byte, set on submit.
+
+    // Used when the copies run on the transfer queue.
+    VkCommandBuffer     acquireBuffer = VK_NULL_HANDLE;                         // Graphics queue side of the ownership transfers.
+    VkSemaphore         semaphore = VK_NULL_HANDLE;                             // Signaled by the transfer queue, waited on by the acquire.
 };
 
 extern VkInstance       vkInstance;
@@ -5,9 +5,17 @@
 #include "RenderSystem.h"
 #include "../Common.h"
 #include "Renderer/Backend/ImageManager.h"
+#include "Renderer/Backend/RenderPipelineManager.h"
+#include "Windowing/Window.h"
+
+#include <new>
 
 RenderSystem::RenderSystem() {
     m_Initialized = false;
+    m_frameCount = 0;
+    m_renderThread = nullptr;
+    m_backendCommands = nullptr;
+    m_running = false;
 }
 
 RenderSystem::~RenderSystem() {
@@ -18,7 +26,7 @@ RenderSystem::~RenderSystem() {
 RenderSystem::Init
 
 DESCRIPTION:
-Initializes the rendering system.
+Initializes the rendering system and starts the render thread.
 ================================================================================
 */
 void RenderSystem::Init() {
@@ -31,6 +39,15 @@ void RenderSystem::Init() {
 
     globalImages->Init();
     m_backend.Init();
+    globalImages->CreateIntrinsicImages();
+
+    m_frameCount = 0;
+    Mem::BeginFrameArena(0);
+
+    m_running = true;
+    m_renderThread = new std::thread(&RenderSystem::RenderThread, this);
+
+    m_Initialized = true;
 }
 
 /*
@@ -38,15 +55,162 @@ void RenderSystem::Init() {
 RenderSystem::Shutdown
 
 DESCRIPTION:
-Shuts down the rendering system.
+Waits for the backend to finish the frame in flight, stops the render thread and
+shuts down the rendering system.
 ================================================================================
 */
 void RenderSystem::Shutdown() {
+    if (!m_Initialized) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_backendCommands == nullptr; });
+        m_running = false;
+    }
+    m_cv.notify_all();
+
+    m_renderThread->join();
+    delete m_renderThread;
+    m_renderThread = nullptr;
+
+    if (renderPipelineManager.IsRecording() && !m_pipelineManifest.empty()) {
+        renderPipelineManager.SaveManifest(m_pipelineManifest.c_str());
+    }
+
+    globalImages->Shutdown();
     m_backend.Shutdown();
+
+    m_Initialized = false;
+}
+
+/*
+================================================================================
+RenderSystem::AllocView
+
+DESCRIPTION:
+Allocates an empty view in frame temporary memory. The view and everything it
+points to has to live in frame memory as well, it's read by the backend while
+the frontend is already working on the next frame. The view covers the whole
+window, its size is read here so the render thread never touches the window.
+
+RETURNS:
+The new view.
+================================================================================
+*/
+ViewDefiniton * RenderSystem::AllocView() {
+    void * mem = Mem::FrameAlloc(sizeof(ViewDefiniton), alignof(ViewDefiniton));
+    auto * viewDef = new (mem) ViewDefiniton();
+
+    viewDef->viewport.x2 = window.width - 1;
+    viewDef->viewport.y2 = window.height - 1;
+
+    return viewDef;
+}
+
+/*
+================================================================================
+RenderSystem::DrawView
+
+DESCRIPTION:
+Sorts the surfaces of the view by their sort key and queues the view to be
+drawn this frame. The sort runs on the frontend, so the backend can record the
+surfaces in order without touching the keys.
+================================================================================
+*/
+void RenderSystem::DrawView(ViewDefiniton *viewDef) {
+    viewDef->drawSurfs.SortByKey([](const DrawSurface *surf) { return surf->sort; });
+
+    RenderCommand command;
+    command.type = RC_DRAW_VIEW;
+    command.viewDef = viewDef;
+
+    m_commands[m_frameCount % MAX_FRAMES_IN_FLIGHT].Add(command);
 }
 
-void RenderSystem::RenderCommandBuffers() {
-    m_backend.SwapBuffers();
-    m_backend.Execute();
+/*
+================================================================================
+RenderSystem::SwapCommandBuffers
+
+DESCRIPTION:
+Ends the frame of the frontend and hands it over to the render thread. Only
+waits when the backend is still busy with the previous frame. Then starts the
+next frame, recycling the command list and frame memory of the frame the
+backend has just finished.
+================================================================================
+*/
+void RenderSystem::SwapCommandBuffers() {
+    List<RenderCommand> & commands = m_commands[m_frameCount % MAX_FRAMES_IN_FLIGHT];
+
+    RenderCommand swap;
+    swap.type = RC_SWAP_BUFFERS;
+    commands.Add(swap);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_backendCommands == nullptr; });
+        m_backendCommands = &commands;
+    }
+    m_cv.notify_all();
+
+    m_frameCount++;
+
+    const uint32_t frame = static_cast<uint32_t>(m_frameCount % MAX_FRAMES_IN_FLIGHT);
+    Mem::BeginFrameArena(static_cast<int>(frame));
+    m_commands[frame].Clear();
+}
+
+/*
+================================================================================
+RenderSystem::RenderThread
+
+DESCRIPTION:
+Executes the frames handed over by SwapCommandBuffers until shutdown, waiting on
+the acquire and the fences so the frontend doesn't have to.
+================================================================================
+*/
+void RenderSystem::RenderThread() {
+    while (true) {
+        const List<RenderCommand> * commands;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_backendCommands != nullptr || !m_running; });
+
+            if (m_backendCommands == nullptr) {
+                return;
+            }
+
+            commands = m_backendCommands;
+        }
+
+        m_backend.ExecuteCommands(commands->Data(), commands->Size());
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_backendCommands = nullptr;
+        }
+        m_cv.notify_all();
+    }
 }
 
+/*
+================================================================================
+RenderSystem::PrecompilePipelines
+
+DESCRIPTION:
+Compiles the pipelines listed in the manifest of the level being loaded, so the
+level doesn't hitch on the first draw of each of them. While recording, the
+manifest of the previous level is saved first and the new one is saved over
+on the next level load or on shutdown.
+================================================================================
+*/
+void RenderSystem::PrecompilePipelines(const char *manifestPath) {
+    if (renderPipelineManager.IsRecording() && !m_pipelineManifest.empty()) {
+        renderPipelineManager.SaveManifest(m_pipelineManifest.c_str());
+        renderPipelineManager.ClearRecording();
+    }
+
+    m_pipelineManifest = manifestPath;
+    renderPipelineManager.PrecompileManifest(manifestPath);
+}
@@ -5,8 +5,25 @@
 #ifndef RELOAD_RENDERSYSTEM_H
 #define RELOAD_RENDERSYSTEM_H
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "Renderer/Backend/RenderBackend.h"
 
+/*
+================================================================================
+RenderSystem
+
+DESCRIPTION:
+The renderer frontend. It queues render commands for the current frame while the
+backend executes the previous one on the render thread, so the simulation of
+frame N+1 overlaps the submission of frame N.
+
+The command lists and the frame temporary memory are double buffered: the
+frontend writes one of them while the backend reads the other, and
+SwapCommandBuffers only waits for the backend to finish the previous frame.
+================================================================================
+*/
 class RenderSystem {
 public:
                     RenderSystem();
@@ -14,10 +31,27 @@ public:
 
     void            Init();                                                     // Initializes the rendering system.
     void            Shutdown();                                                 // Shuts down the rendering system.
-    void            RenderCommandBuffers();
+
+    ViewDefiniton * AllocView();                                                // Allocates an empty view in frame temporary memory.
+    void            DrawView(ViewDefiniton *viewDef);                           // Sorts the surfaces of the view and queues it to be drawn this frame.
+    void            SwapCommandBuffers();                                       // Hands the frame to the render thread and starts the next one.
+    void            PrecompilePipelines(const char *manifestPath);              // Compiles the pipelines of the level's manifest, blocking.
+
 private:
+    void            RenderThread();                                             // Executes the frames handed over by the frontend.
+
     RenderBackend   m_backend;
     bool            m_Initialized;
+    std::string     m_pipelineManifest;                                         // Manifest of the current level, recorded into while recording.
+
+    List<RenderCommand>             m_commands[MAX_FRAMES_IN_FLIGHT];           // Frontend writes m_commands[m_frameCount % MAX_FRAMES_IN_FLIGHT].
+    uint64_t                        m_frameCount;                               // Frames handed over to the backend.
+
+    std::thread *                   m_renderThread;
+    std::mutex                      m_mutex;
+    std::condition_variable         m_cv;
+    const List<RenderCommand> *     m_backendCommands;                          // Frame the backend works on, nullptr while it's idle.
+    bool                            m_running;
 };
 
 
@@ -30,11 +30,14 @@ typedef struct VulkanConfig {
     int             swapInterval;
     unsigned int    deviceLocalMemoryMB;
     unsigned int    uploadBufferSizeMB;
+    unsigned int    uploadSegments;
+    unsigned int    dynamicBufferSizeMB;
     Version         apiVersion;
     Version         programVersion;
     Version         engineVersion;
     bool            enableValidationLayers;
     bool            enableDebugLayer;
+    bool            recordPipelines;
     const char *    programName;
     const char *    engineName;
 } VulkanConfig;
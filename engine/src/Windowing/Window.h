@@ -6,13 +6,14 @@
 #define RELOAD_WINDOW_H
 
 #include "ReloadLib/Containers/List.h"
+#include "ReloadLib/Containers/InlineList.h"
 
 struct RDisplay {
     bool	isDefault = false;
     int		width = 0;
     int		height = 0;
     int		hz = 0;
-    List<uint32_t> modes;
+    InlineList<uint32_t, 32> modes;                                     // Packed as (width << 16) | height.
 };
 
 struct RWindow {
@@ -1,7 +1,12 @@
 #include "ConfigManager.h"
 #include "Game.h"
+#include "ReloadLib/FileSystem.h"
+
+static const char * ASSET_ARCHIVE = "assets.rpak";                              // Packed assets, shadow the loose files when present.
 
 int main(int argc, char* argv[]) {
+    fileSystem.Mount(ASSET_ARCHIVE);
+
     ConfigManager::LoadSystemConfig();
     spdlog::set_pattern("[%H:%M:%S %z] [%n] [%^---%L---%$] [thread %t] %v");
 
@@ -11,6 +16,8 @@ int main(int argc, char* argv[]) {
     game.Run();
     game.Shutdown();
 
+    fileSystem.Unmount();
+
     return 0;
 }
 
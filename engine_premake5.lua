@@ -104,3 +104,14 @@ project "ReloadEngineCore"
 			"-framework OpenAL",
 			"-fno-rtti"
 		}
+
+	-- compile the shaders to SPIR-V next to their sources before the build, so
+	-- the assets copied after it carry them along
+	local glslc = os.host() == "windows" and "%{VULKAN_SDK}/Bin/glslc" or "glslc"
+	local shaderCommands = {}
+	for _, shader in ipairs(table.join(os.matchfiles("engine/assets/shaders/*.vert"), os.matchfiles("engine/assets/shaders/*.frag"))) do
+		table.insert(shaderCommands, glslc .. " --target-env=vulkan1.1 %{rootdir}/" .. shader .. " -o %{rootdir}/" .. shader .. ".spv")
+	end
+
+	filter {}
+		prebuildcommands(shaderCommands)
@@ -35,3 +35,5 @@ workspace(settings.reload_engine)
     include "third_party/volk/volk_premake5"
     include "third_party/spdlog/spdlog_premake5"
     include "engine_premake5"
+    include "tools/packer/packer_premake5"
+    include "tests/tests_premake5"
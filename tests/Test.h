@@ -0,0 +1,48 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_TEST_H
+#define RELOAD_TEST_H
+
+/*
+================================================================================
+Tests
+
+DESCRIPTION:
+Minimal test harness for the engine library. `TEST` defines a test and registers
+it before main runs, `CHECK` fails the running test and returns from it when the
+condition doesn't hold. The runner executes every registered test and exits
+with the number of failed ones, or runs only the tests whose names contain the
+first argument.
+================================================================================
+*/
+typedef void (*TestFunc)();
+
+struct TestCase {
+    const char *        name;
+    TestFunc            func;
+    TestCase *          next;
+};
+
+class TestRegistrar {
+public:
+                    TestRegistrar(const char *name, TestFunc func);
+};
+
+void                TestFailed(const char *file, int line, const char *expression);
+
+#define TEST(name) \
+    static void Test_##name(); \
+    static TestRegistrar testRegistrar_##name(#name, &Test_##name); \
+    static void Test_##name()
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            TestFailed(__FILE__, __LINE__, #expression); \
+            return; \
+        } \
+    } while (0)
+
+#endif //RELOAD_TEST_H
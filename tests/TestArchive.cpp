@@ -0,0 +1,142 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "ReloadLib/Archive.h"
+#include "ArchiveWriter.h"
+
+namespace fs = std::filesystem;
+
+// Directory of loose files packed by the tests, removed again when done.
+class ScratchDir {
+public:
+    explicit        ScratchDir(const char *name) : m_path(fs::temp_directory_path() / name) {
+        fs::remove_all(m_path);
+        fs::create_directories(m_path);
+    }
+                    ~ScratchDir() { std::error_code error; fs::remove_all(m_path, error); }
+
+    void            Write(const std::string &name, const std::string &contents) const {
+        const fs::path path = m_path / "assets" / name;
+        fs::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    [[nodiscard]] fs::path      Assets() const { return m_path / "assets"; }
+    [[nodiscard]] std::string   ArchivePath() const { return (m_path / "assets.rpak").string(); }
+
+private:
+    fs::path        m_path;
+};
+
+static std::string ToString(Span<const uint8_t> data) {
+    return std::string(reinterpret_cast<const char *>(data.Data()), data.Size());
+}
+
+TEST(Archive_RoundTrip) {
+    ScratchDir dir("reload_test_archive");
+
+    const std::string large(3 * ARCHIVE_ALIGNMENT + 17, 'x');
+    dir.Write("shaders/default.vert.spv", "vertex");
+    dir.Write("Textures/Wall.PNG", "wall pixels");
+    dir.Write("textures/wall.tga", "other format");
+    dir.Write("models/large.bin", large);
+    dir.Write("empty.txt", "");
+
+    size_t numPacked = 0;
+    CHECK(PackArchive(dir.ArchivePath().c_str(), dir.Assets(), numPacked));
+    CHECK(numPacked == 5);
+
+    Archive archive;
+    CHECK(archive.Open(dir.ArchivePath().c_str()));
+    CHECK(archive.NumEntries() == 5);
+
+    Span<const uint8_t> data;
+    CHECK(archive.Find("shaders/default.vert.spv", data));
+    CHECK(ToString(data) == "vertex");
+
+    // Names are folded, the extension tells formats apart.
+    CHECK(archive.Find("textures\\WALL.png", data));
+    CHECK(ToString(data) == "wall pixels");
+    CHECK(archive.Find("textures/wall.tga", data));
+    CHECK(ToString(data) == "other format");
+
+    CHECK(archive.Find("models/large.bin", data));
+    CHECK(ToString(data) == large);
+
+    CHECK(archive.Find("empty.txt", data));
+    CHECK(data.Size() == 0);
+
+    CHECK(!archive.Contains("textures/wall"));
+    CHECK(!archive.Contains("missing.png"));
+    CHECK(!archive.Find("missing.png", data));
+
+    archive.Close();
+    CHECK(!archive.IsOpen());
+}
+
+TEST(Archive_LocateMatchesFileContents) {
+    ScratchDir dir("reload_test_archive_locate");
+
+    dir.Write("a.txt", "first");
+    dir.Write("b/c.txt", "second");
+
+    size_t numPacked = 0;
+    CHECK(PackArchive(dir.ArchivePath().c_str(), dir.Assets(), numPacked));
+
+    Archive archive;
+    CHECK(archive.Open(dir.ArchivePath().c_str()));
+
+    // Readers going through file reads see the same bytes as the mapping.
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    CHECK(archive.Locate("b/c.txt", offset, size));
+    CHECK(offset % ARCHIVE_ALIGNMENT == 0);
+    CHECK(size == 6);
+
+    std::ifstream file(dir.ArchivePath(), std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(offset));
+    std::string contents(static_cast<size_t>(size), '\0');
+    file.read(&contents[0], static_cast<std::streamsize>(size));
+    CHECK(contents == "second");
+
+    CHECK(!archive.Locate("c.txt", offset, size));
+}
+
+TEST(Archive_PackRejectsFoldedDuplicates) {
+    ScratchDir dir("reload_test_archive_duplicates");
+
+    dir.Write("Sound.wav", "one");
+    dir.Write("sound.WAV", "two");
+
+    // Only possible on case sensitive file systems.
+    size_t numFiles = 0;
+    for (const fs::directory_entry & entry : fs::directory_iterator(dir.Assets())) {
+        numFiles += entry.is_regular_file() ? 1 : 0;
+    }
+    if (numFiles < 2) {
+        return;
+    }
+
+    size_t numPacked = 0;
+    CHECK(!PackArchive(dir.ArchivePath().c_str(), dir.Assets(), numPacked));
+}
+
+TEST(Archive_OpenRejectsInvalidFiles) {
+    ScratchDir dir("reload_test_archive_invalid");
+
+    dir.Write("short.rpak", "RPAK");
+    dir.Write("garbage.rpak", std::string(4096, 'g'));
+
+    Archive archive;
+    CHECK(!archive.Open((dir.Assets() / "short.rpak").string().c_str()));
+    CHECK(!archive.Open((dir.Assets() / "garbage.rpak").string().c_str()));
+    CHECK(!archive.Open((dir.Assets() / "missing.rpak").string().c_str()));
+    CHECK(!archive.IsOpen());
+}
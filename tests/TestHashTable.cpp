@@ -0,0 +1,146 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+#include "Tracked.h"
+
+#include <random>
+#include <unordered_map>
+#include "ReloadLib/Containers/HashTable.h"
+
+// Puts every key into one of four probe chains, so lookups and removals have to
+// walk and shift long runs of colliding entries.
+struct CollidingTraits {
+    static inline uint32_t  GetHash(int key) { return static_cast<uint32_t>(key & 3) * 0x10000u; }
+    static inline bool      Equals(int a, int b) { return a == b; }
+};
+
+TEST(HashTable_SetFindAndReplace) {
+    HashTable<int, int> table;
+
+    for (int i = 0; i < 1000; i++) {
+        table.Set(i, i * 2);
+    }
+
+    CHECK(table.Size() == 1000);
+    for (int i = 0; i < 1000; i++) {
+        const int * value = table.Find(i);
+        CHECK(value != nullptr);
+        CHECK(*value == i * 2);
+    }
+    CHECK(table.Find(1000) == nullptr);
+    CHECK(!table.Contains(-1));
+
+    table.Set(10, 7);
+    CHECK(table.Size() == 1000);
+    CHECK(*table.Find(10) == 7);
+}
+
+TEST(HashTable_ProbesThroughCollisions) {
+    HashTable<int, int, CollidingTraits> table;
+
+    for (int i = 0; i < 200; i++) {
+        table.Set(i, i);
+    }
+
+    CHECK(table.Size() == 200);
+    for (int i = 0; i < 200; i++) {
+        CHECK(table.Find(i) != nullptr && *table.Find(i) == i);
+    }
+    CHECK(table.Find(200) == nullptr);
+}
+
+TEST(HashTable_RemoveShiftsCollidingEntries) {
+    HashTable<int, int, CollidingTraits> table;
+
+    for (int i = 0; i < 64; i++) {
+        table.Set(i, i);
+    }
+
+    // Removing from the middle of the chains must leave the rest reachable.
+    for (int i = 0; i < 64; i += 3) {
+        CHECK(table.Remove(i));
+        CHECK(!table.Remove(i));
+    }
+
+    for (int i = 0; i < 64; i++) {
+        if (i % 3 == 0) {
+            CHECK(!table.Contains(i));
+        } else {
+            CHECK(table.Find(i) != nullptr && *table.Find(i) == i);
+        }
+    }
+
+    for (int i = 0; i < 64; i += 3) {
+        table.Set(i, -i);
+    }
+    CHECK(table.Size() == 64);
+    CHECK(*table.Find(63) == -63);
+}
+
+TEST(HashTable_MatchesReferenceMap) {
+    HashTable<int, int> table;
+    std::unordered_map<int, int> reference;
+    std::mt19937 random(1234);
+
+    for (int step = 0; step < 20000; step++) {
+        const int key = static_cast<int>(random() % 512);
+        const int op = static_cast<int>(random() % 3);
+
+        if (op == 0) {
+            CHECK(table.Remove(key) == (reference.erase(key) == 1));
+        } else {
+            table.Set(key, step);
+            reference[key] = step;
+        }
+    }
+
+    CHECK(table.Size() == static_cast<int>(reference.size()));
+
+    int numIterated = 0;
+    for (auto & entry : table) {
+        CHECK(reference.count(entry.key) == 1);
+        CHECK(reference[entry.key] == entry.value);
+        numIterated++;
+    }
+    CHECK(numIterated == table.Size());
+}
+
+TEST(HashTable_StringKeysIgnoreCase) {
+    HashTable<std::string, int, StringHashTraitsI> table;
+
+    table.Set(std::string_view("Textures/Wall.png"), 1);
+    table.Set(std::string_view("sounds/step.wav"), 2);
+
+    CHECK(table.Find(std::string_view("textures/wall.PNG")) != nullptr);
+    CHECK(*table.Find(std::string_view("SOUNDS/STEP.WAV")) == 2);
+    CHECK(!table.Contains(std::string_view("textures/wall.png2")));
+
+    table.Set(std::string_view("TEXTURES/WALL.PNG"), 3);
+    CHECK(table.Size() == 2);
+    CHECK(table.Remove(std::string_view("textures/wall.png")));
+    CHECK(table.Size() == 1);
+}
+
+TEST(HashTable_DestroysValues) {
+    {
+        HashTable<int, Tracked> table;
+
+        for (int i = 0; i < 100; i++) {
+            table.Set(i, Tracked(i));
+        }
+        CHECK(Tracked::numLive == 100);
+
+        CHECK(table.Remove(5));
+        CHECK(Tracked::numLive == 99);
+
+        table.Clear();
+        CHECK(Tracked::numLive == 0);
+        CHECK(table.Size() == 0);
+
+        table.Set(1, Tracked(1));
+    }
+
+    CHECK(Tracked::numLive == 0);
+}
@@ -0,0 +1,119 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+#include "Tracked.h"
+#include "ReloadLib/Containers/InlineList.h"
+
+TEST(InlineList_StaysInlineUpToN) {
+    InlineList<int, 4> list;
+
+    for (int i = 0; i < 4; i++) {
+        list.Add(i);
+    }
+
+    CHECK(list.IsInline());
+    CHECK(list.MemoryUsed() == 0);
+    CHECK(list.AllocatedCount() == 4);
+}
+
+TEST(InlineList_SpillsPastN) {
+    {
+        InlineList<Tracked, 4> list;
+
+        for (int i = 0; i < 5; i++) {
+            list.Add(Tracked(i));
+        }
+
+        CHECK(!list.IsInline());
+        CHECK(list.MemoryUsed() > 0);
+        CHECK(list.Size() == 5);
+        CHECK(Tracked::numLive == 5);
+
+        for (int i = 5; i < 64; i++) {
+            list.Add(Tracked(i));
+        }
+
+        CHECK(Tracked::numLive == 64);
+        for (int i = 0; i < 64; i++) {
+            CHECK(list[i].value == i);
+        }
+    }
+
+    CHECK(Tracked::numLive == 0);
+}
+
+TEST(InlineList_ShrinksBackInline) {
+    InlineList<Tracked, 4> list;
+
+    for (int i = 0; i < 10; i++) {
+        list.Add(Tracked(i));
+    }
+
+    list.SetSize(3);
+    list.Resize(3);
+    CHECK(list.IsInline());
+    CHECK(list.Size() == 3);
+    CHECK(list[2].value == 2);
+    CHECK(Tracked::numLive == 3);
+
+    list.Add(Tracked(7));
+    list.Add(Tracked(8));
+    CHECK(!list.IsInline());
+
+    list.Clear();
+    CHECK(list.IsInline());
+    CHECK(list.Size() == 0);
+    CHECK(Tracked::numLive == 0);
+}
+
+TEST(InlineList_MoveInlineAndSpilled) {
+    InlineList<Tracked, 4> small;
+    small.Add(Tracked(1));
+    small.Add(Tracked(2));
+
+    InlineList<Tracked, 4> movedSmall(std::move(small));
+    CHECK(movedSmall.IsInline());
+    CHECK(movedSmall.Size() == 2);
+    CHECK(movedSmall[1].value == 2);
+
+    InlineList<Tracked, 4> large;
+    for (int i = 0; i < 8; i++) {
+        large.Add(Tracked(i));
+    }
+    const Tracked * spilled = large.Data();
+
+    // A spilled block is taken over, not copied.
+    InlineList<Tracked, 4> movedLarge(std::move(large));
+    CHECK(movedLarge.Data() == spilled);
+    CHECK(movedLarge.Size() == 8);
+    CHECK(large.Size() == 0);
+    CHECK(large.IsInline());
+
+    InlineList<Tracked, 4> copy(movedLarge);
+    CHECK(copy.Size() == 8);
+    CHECK(copy[7].value == 7);
+
+    movedSmall.Clear();
+    movedLarge.Clear();
+    copy.Clear();
+    small.Clear();
+    CHECK(Tracked::numLive == 0);
+}
+
+TEST(InlineList_RemoveAcrossSpill) {
+    InlineList<int, 2> list;
+    for (int i = 0; i < 6; i++) {
+        list.Add(i);
+    }
+
+    CHECK(list.RemoveIndex(1));
+    CHECK(list[1] == 2);
+    CHECK(list.Remove(5));
+    CHECK(list.Size() == 4);
+    CHECK(list.IndexOf(4) == 3);
+    CHECK(list.Find(5) == nullptr);
+    CHECK(list.AddUnique(4) == 3);
+    CHECK(list.Size() == 4);
+}
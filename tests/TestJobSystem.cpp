@@ -0,0 +1,213 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ReloadLib/sys/JobSystem.h"
+
+static void IncrementJob(void *data) {
+    static_cast<std::atomic<int> *>(data)->fetch_add(1);
+}
+
+static void SetFlagJob(void *data) {
+    static_cast<std::atomic<bool> *>(data)->store(true);
+}
+
+TEST(JobSystem_RunsImmediatelyBeforeInit) {
+    JobSystem jobs;
+    std::atomic<int> numRun{0};
+
+    Job job;
+    job.func = &IncrementJob;
+    job.data = &numRun;
+
+    JobCounter counter;
+    jobs.Run(&job, 1, &counter);
+
+    CHECK(numRun == 1);
+    CHECK(counter.IsDone());
+}
+
+TEST(JobSystem_CounterTracksAllJobs) {
+    JobSystem jobs;
+    jobs.Init(3);
+
+    std::atomic<int> numRun{0};
+    std::vector<Job> batch(500);
+    for (Job & job : batch) {
+        job.func = &IncrementJob;
+        job.data = &numRun;
+    }
+
+    JobCounter counter;
+    jobs.Run(batch.data(), static_cast<int>(batch.size()), &counter);
+    jobs.Wait(&counter);
+
+    CHECK(counter.IsDone());
+    CHECK(numRun == 500);
+
+    jobs.Shutdown();
+}
+
+TEST(JobSystem_RunAfterWaitsForDependency) {
+    JobSystem jobs;
+    jobs.Init(3);
+
+    struct Stage {
+        std::atomic<int> *  first;
+        std::atomic<int>    numEarly{0};
+    };
+
+    std::atomic<int> numFirst{0};
+    Stage stage;
+    stage.first = &numFirst;
+
+    std::vector<Job> first(200);
+    for (Job & job : first) {
+        job.func = &IncrementJob;
+        job.data = &numFirst;
+    }
+
+    // Counts how often a dependent job saw the first group unfinished.
+    std::vector<Job> second(50);
+    for (Job & job : second) {
+        job.func = [](void *data) {
+            auto * s = static_cast<Stage *>(data);
+            if (s->first->load() != 200) {
+                s->numEarly++;
+            }
+        };
+        job.data = &stage;
+    }
+
+    JobCounter firstCounter;
+    JobCounter secondCounter;
+    jobs.Run(first.data(), static_cast<int>(first.size()), &firstCounter);
+    jobs.RunAfter(&firstCounter, second.data(), static_cast<int>(second.size()), &secondCounter);
+    jobs.Wait(&secondCounter);
+
+    CHECK(firstCounter.IsDone());
+    CHECK(secondCounter.IsDone());
+    CHECK(stage.numEarly == 0);
+
+    jobs.Shutdown();
+}
+
+TEST(JobSystem_NestedJobsKeepCounterOpen) {
+    JobSystem jobs;
+    jobs.Init(3);
+
+    struct Nested {
+        JobSystem *         jobs;
+        JobCounter *        counter;
+        std::atomic<int>    numLeaves{0};
+    };
+
+    JobCounter counter;
+    Nested nested;
+    nested.jobs = &jobs;
+    nested.counter = &counter;
+
+    // Every parent spawns its children on the same counter before it finishes.
+    std::vector<Job> parents(20);
+    for (Job & job : parents) {
+        job.func = [](void *data) {
+            auto * n = static_cast<Nested *>(data);
+
+            Job children[10];
+            for (Job & child : children) {
+                child.func = &IncrementJob;
+                child.data = &n->numLeaves;
+            }
+            n->jobs->Run(children, 10, n->counter);
+        };
+        job.data = &nested;
+    }
+
+    jobs.Run(parents.data(), static_cast<int>(parents.size()), &counter);
+    jobs.Wait(&counter);
+
+    CHECK(nested.numLeaves == 200);
+
+    jobs.Shutdown();
+}
+
+TEST(JobSystem_WaitSkipsOtherBackgroundJobs) {
+    JobSystem jobs;
+
+    // Without workers only Wait runs jobs, so it's deterministic which ones.
+    jobs.Init(0);
+
+    std::atomic<bool> backgroundRan{false};
+    std::atomic<bool> frameRan{false};
+
+    Job background;
+    background.func = &SetFlagJob;
+    background.data = &backgroundRan;
+
+    Job frame;
+    frame.func = &SetFlagJob;
+    frame.data = &frameRan;
+
+    JobCounter backgroundCounter;
+    JobCounter frameCounter;
+    jobs.RunBackground(&background, 1, &backgroundCounter);
+    jobs.Run(&frame, 1, &frameCounter);
+
+    jobs.Wait(&frameCounter);
+    CHECK(frameRan);
+    CHECK(!backgroundRan);
+    CHECK(!backgroundCounter.IsDone());
+
+    // Waiting on the background counter itself does run it.
+    jobs.Wait(&backgroundCounter);
+    CHECK(backgroundRan);
+
+    jobs.Shutdown();
+}
+
+TEST(JobSystem_ParallelForCoversRangeOnce) {
+    JobSystem jobs;
+    jobs.Init(3);
+
+    std::vector<std::atomic<int>> hits(1000);
+    jobs.ParallelFor(1000, 7, [&hits](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            hits[static_cast<size_t>(i)]++;
+        }
+    });
+
+    for (const std::atomic<int> & hit : hits) {
+        CHECK(hit == 1);
+    }
+
+    jobs.Shutdown();
+}
+
+TEST(JobSystem_ThreadSlotSharesLastSlot) {
+    JobSystem jobs;
+    jobs.Init(3);
+
+    const int numThreads = jobs.NumThreads();
+    CHECK(JobSystem::ThreadSlot(numThreads) == 0);
+
+    std::atomic<bool> inRange{true};
+    jobs.ParallelFor(100, 1, [&inRange, numThreads](int, int) {
+        const int slot = JobSystem::ThreadSlot(numThreads);
+        if (slot < 0 || slot >= numThreads) {
+            inRange = false;
+        }
+    });
+    CHECK(inRange);
+
+    int otherSlot = -1;
+    std::thread other([&otherSlot, numThreads]() { otherSlot = JobSystem::ThreadSlot(numThreads); });
+    other.join();
+    CHECK(otherSlot == numThreads);
+
+    jobs.Shutdown();
+}
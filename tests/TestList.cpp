@@ -0,0 +1,100 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+#include "Tracked.h"
+#include "ReloadLib/Containers/List.h"
+
+TEST(List_GrowKeepsTriviallyCopyableElements) {
+    List<int> list(4);
+
+    for (int i = 0; i < 1000; i++) {
+        CHECK(list.Add(i * 3) == i);
+    }
+
+    CHECK(list.Size() == 1000);
+    CHECK(list.AllocatedCount() >= 1000);
+    for (int i = 0; i < 1000; i++) {
+        CHECK(list[i] == i * 3);
+    }
+}
+
+TEST(List_GrowRelocatesNonTrivialElements) {
+    {
+        List<Tracked> list(2);
+
+        for (int i = 0; i < 100; i++) {
+            list.Add(Tracked(i));
+        }
+
+        // The old storage is destroyed on every relocation, only the elements
+        // in the list are alive.
+        CHECK(Tracked::numLive == 100);
+        for (int i = 0; i < 100; i++) {
+            CHECK(list[i].value == i);
+            CHECK(!list[i].movedFrom);
+        }
+
+        list.SetSize(10);
+        CHECK(Tracked::numLive == 10);
+
+        list.Condense();
+        CHECK(list.AllocatedCount() == 10);
+        CHECK(Tracked::numLive == 10);
+        CHECK(list[9].value == 9);
+    }
+
+    CHECK(Tracked::numLive == 0);
+}
+
+TEST(List_InsertAndRemoveKeepOrder) {
+    List<Tracked> list;
+
+    for (int i = 0; i < 5; i++) {
+        list.Add(Tracked(i));
+    }
+
+    list.Insert(Tracked(10), 2);
+    CHECK(list.Size() == 6);
+    CHECK(list[1].value == 1);
+    CHECK(list[2].value == 10);
+    CHECK(list[3].value == 2);
+
+    CHECK(list.RemoveIndex(0));
+    CHECK(list[0].value == 1);
+    CHECK(list[4].value == 4);
+
+    CHECK(list.RemoveIndexFast(0));
+    CHECK(list.Size() == 4);
+    CHECK(list[0].value == 4);
+
+    CHECK(list.Remove(Tracked(10)));
+    CHECK(!list.Remove(Tracked(10)));
+    CHECK(list.Size() == 3);
+
+    list.Clear();
+    CHECK(list.Size() == 0);
+    CHECK(Tracked::numLive == 0);
+}
+
+TEST(List_CopyAndMove) {
+    List<Tracked> list;
+    for (int i = 0; i < 20; i++) {
+        list.Add(Tracked(i));
+    }
+
+    List<Tracked> copy(list);
+    CHECK(copy.Size() == 20);
+    CHECK(copy[19].value == 19);
+    CHECK(Tracked::numLive == 40);
+
+    List<Tracked> moved(std::move(copy));
+    CHECK(moved.Size() == 20);
+    CHECK(copy.Size() == 0);
+    CHECK(Tracked::numLive == 40);
+
+    list.Clear();
+    moved.Clear();
+    CHECK(Tracked::numLive == 0);
+}
@@ -0,0 +1,71 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+static TestCase *   firstTest = nullptr;
+static TestCase *   lastTest = nullptr;
+static bool         testFailed = false;
+
+/*
+================================================================================
+TestRegistrar::TestRegistrar
+
+DESCRIPTION:
+Appends the test to the list, so they run in the order they are defined in.
+================================================================================
+*/
+TestRegistrar::TestRegistrar(const char *name, TestFunc func) {
+    auto * test = new TestCase{ name, func, nullptr };
+
+    if (lastTest != nullptr) {
+        lastTest->next = test;
+    } else {
+        firstTest = test;
+    }
+    lastTest = test;
+}
+
+/*
+================================================================================
+TestFailed
+
+DESCRIPTION:
+Reports the failed check of the running test.
+================================================================================
+*/
+void TestFailed(const char *file, int line, const char *expression) {
+    fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+    testFailed = true;
+}
+
+int main(int argc, char **argv) {
+    const char * filter = argc > 1 ? argv[1] : nullptr;
+    int numRun = 0;
+    int numFailed = 0;
+
+    for (TestCase * test = firstTest; test != nullptr; test = test->next) {
+        if (filter != nullptr && strstr(test->name, filter) == nullptr) {
+            continue;
+        }
+
+        testFailed = false;
+        test->func();
+        numRun++;
+
+        if (testFailed) {
+            fprintf(stderr, "FAILED %s\n", test->name);
+            numFailed++;
+        } else {
+            printf("ok     %s\n", test->name);
+        }
+    }
+
+    printf("%d of %d tests passed.\n", numRun - numFailed, numRun);
+
+    return numFailed;
+}
@@ -0,0 +1,109 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "ReloadLib/NameTable.h"
+
+TEST(NameTable_FoldsCaseAndSeparators) {
+    NameTable table;
+
+    const NameId id = table.Intern("Textures\\Wall.TGA");
+    CHECK(id != NAME_NONE);
+    CHECK(table.Intern("textures/wall.tga") == id);
+    CHECK(table.Find("TEXTURES/WALL.tga") == id);
+    CHECK(strcmp(table.GetString(id), "textures/wall.tga") == 0);
+    CHECK(table.Count() == 1);
+}
+
+TEST(NameTable_KeepsExtensions) {
+    NameTable table;
+
+    const NameId tga = table.Intern("textures/wall.tga");
+    const NameId png = table.Intern("textures/wall.png");
+    const NameId none = table.Intern("textures/wall");
+
+    CHECK(tga != png);
+    CHECK(tga != none);
+    CHECK(png != none);
+    CHECK(table.Count() == 3);
+}
+
+TEST(NameTable_RejectsEmptyAndLongPaths) {
+    NameTable table;
+
+    CHECK(table.Intern("") == NAME_NONE);
+
+    const std::string longPath(MAX_PATH, 'a');
+    CHECK(table.Intern(longPath) == NAME_NONE);
+
+    const std::string fitting(MAX_PATH - 1, 'a');
+    CHECK(table.Intern(fitting) != NAME_NONE);
+    CHECK(table.Count() == 1);
+}
+
+TEST(NameTable_FindDoesNotIntern) {
+    NameTable table;
+
+    CHECK(table.Find("sounds/step.wav") == NAME_NONE);
+    CHECK(table.Count() == 0);
+
+    const NameId id = table.Intern("sounds/step.wav");
+    CHECK(table.Find("Sounds/Step.wav") == id);
+}
+
+TEST(NameTable_StringsStayValidAcrossChunks) {
+    NameTable table;
+
+    // Enough names to fill several string chunks.
+    const NameId first = table.Intern("models/first.obj");
+    const char * firstString = table.GetString(first);
+
+    std::vector<NameId> ids;
+    for (int i = 0; i < 20000; i++) {
+        ids.push_back(table.Intern("models/generated/mesh_" + std::to_string(i) + ".obj"));
+    }
+
+    CHECK(table.GetString(first) == firstString);
+    CHECK(strcmp(firstString, "models/first.obj") == 0);
+    for (int i = 0; i < 20000; i++) {
+        CHECK(table.GetString(ids[i]) == "models/generated/mesh_" + std::to_string(i) + ".obj");
+    }
+}
+
+TEST(NameTable_ConcurrentInternAgrees) {
+    NameTable table;
+    static const int numThreads = 4;
+    static const int numNames = 2000;
+
+    std::vector<std::vector<NameId>> ids(numThreads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&table, &ids, t] {
+            for (int i = 0; i < numNames; i++) {
+                // Every thread interns the same names, in a different case.
+                std::string name = "shared/name_" + std::to_string(i) + ".dat";
+                if (t % 2 == 1) {
+                    for (char & c : name) {
+                        c = static_cast<char>(toupper(c));
+                    }
+                }
+                ids[t].push_back(table.Intern(name));
+            }
+        });
+    }
+
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+
+    CHECK(table.Count() == numNames);
+    for (int t = 1; t < numThreads; t++) {
+        CHECK(ids[t] == ids[0]);
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "Test.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "ReloadLib/Containers/List.h"
+
+struct SortItem {
+    uint64_t    key;
+    int         order;                                                          // Position before sorting, to check stability.
+};
+
+// The sort takes its scratch buffers from the current frame arena.
+class ScopedFrameArena {
+public:
+                ScopedFrameArena() { Mem::InitFrameArenas(1, 1024 * 1024); Mem::BeginFrameArena(0); }
+                ~ScopedFrameArena() { Mem::ShutdownFrameArenas(); }
+};
+
+static std::vector<SortItem> MakeItems(int count, uint64_t keyMask, uint32_t seed) {
+    std::mt19937_64 random(seed);
+    std::vector<SortItem> items(static_cast<size_t>(count));
+
+    for (int i = 0; i < count; i++) {
+        items[static_cast<size_t>(i)] = SortItem{ random() & keyMask, i };
+    }
+
+    return items;
+}
+
+static bool MatchesStableSort(std::vector<SortItem> items, uint64_t keyMask) {
+    std::vector<SortItem> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const SortItem &a, const SortItem &b) {
+        return a.key < b.key;
+    });
+
+    if (keyMask > 0xFFFFFFFFu) {
+        RadixSort(items.data(), static_cast<int>(items.size()), [](const SortItem &item) { return item.key; });
+    } else {
+        RadixSort(items.data(), static_cast<int>(items.size()), [](const SortItem &item) { return static_cast<uint32_t>(item.key); });
+    }
+
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].key != expected[i].key || items[i].order != expected[i].order) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST(RadixSort_Sorts32BitKeys) {
+    ScopedFrameArena arena;
+
+    CHECK(MatchesStableSort(MakeItems(10000, 0xFFFFFFFFu, 1), 0xFFFFFFFFu));
+}
+
+TEST(RadixSort_Sorts64BitKeys) {
+    ScopedFrameArena arena;
+
+    CHECK(MatchesStableSort(MakeItems(10000, ~0ull, 2), ~0ull));
+}
+
+TEST(RadixSort_IsStable) {
+    ScopedFrameArena arena;
+
+    // Few distinct keys, so most items tie.
+    CHECK(MatchesStableSort(MakeItems(5000, 0x7, 3), 0x7));
+}
+
+TEST(RadixSort_SkipsUniformDigits) {
+    ScopedFrameArena arena;
+
+    // Only the second and the last byte differ, so an odd number of passes run
+    // and the result has to be copied back from the scratch buffer.
+    CHECK(MatchesStableSort(MakeItems(3000, 0xFF0000000000FF00ull, 4), 0xFF0000000000FF00ull));
+    CHECK(MatchesStableSort(MakeItems(3000, 0x0000FF00u, 5), 0x0000FF00u));
+
+    // All keys equal, nothing moves.
+    CHECK(MatchesStableSort(MakeItems(100, 0, 6), 0));
+}
+
+TEST(RadixSort_HandlesTinyInputs) {
+    ScopedFrameArena arena;
+
+    CHECK(MatchesStableSort(MakeItems(0, ~0ull, 7), ~0ull));
+    CHECK(MatchesStableSort(MakeItems(1, ~0ull, 8), ~0ull));
+    CHECK(MatchesStableSort(MakeItems(2, ~0ull, 9), ~0ull));
+}
+
+TEST(RadixSort_ListSortByKey) {
+    ScopedFrameArena arena;
+
+    List<uint32_t> list;
+    for (uint32_t i = 0; i < 1000; i++) {
+        list.Add((i * 7919u) % 1000u);
+    }
+
+    list.SortByKey([](uint32_t value) { return value; });
+
+    for (int i = 0; i < 1000; i++) {
+        CHECK(list[i] == static_cast<uint32_t>(i));
+    }
+}
@@ -0,0 +1,27 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_TRACKED_H
+#define RELOAD_TRACKED_H
+
+// Counts the live instances, so relocation can be checked to neither leak nor
+// double destroy elements.
+struct Tracked {
+    static inline int   numLive = 0;
+
+    int         value;
+    bool        movedFrom = false;
+
+                Tracked() : value(0) { numLive++; }
+    explicit    Tracked(int v) : value(v) { numLive++; }
+                Tracked(const Tracked &other) : value(other.value) { numLive++; }
+                Tracked(Tracked &&other) noexcept : value(other.value) { other.movedFrom = true; numLive++; }
+                ~Tracked() { numLive--; }
+
+    Tracked &   operator=(const Tracked &other) = default;
+    Tracked &   operator=(Tracked &&other) noexcept { value = other.value; other.movedFrom = true; return *this; }
+    bool        operator==(const Tracked &other) const { return value == other.value; }
+};
+
+#endif //RELOAD_TRACKED_H
@@ -0,0 +1,55 @@
+project "ReloadTests"
+    kind            "ConsoleApp"
+    language        "C++"
+    cppdialect      "C++17"
+    staticruntime   "on"
+
+    files {
+        "*.h",
+        "*.cpp",
+        "%{rootdir}/engine/src/ReloadLib/Archive.cpp",
+        "%{rootdir}/engine/src/ReloadLib/File.cpp",
+        "%{rootdir}/engine/src/ReloadLib/NameTable.cpp",
+        "%{rootdir}/engine/src/ReloadLib/sys/Heap.cpp",
+        "%{rootdir}/engine/src/ReloadLib/sys/JobSystem.cpp",
+        "%{rootdir}/tools/packer/ArchiveWriter.cpp"
+    }
+
+    -- The engine headers pull in SDL, Volk and the loggers through Common.h.
+    includedirs {
+        IncludeDir.Common,
+        IncludeDir.ReloadEngine,
+        IncludeDir.VulkanSDK,
+        IncludeDir.Volk,
+        IncludeDir.SDL2,
+        IncludeDir.Fmt,
+        IncludeDir.Spdlog,
+        "%{rootdir}/tools/packer"
+    }
+
+    libdirs {
+        LibraryDir.Common,
+        LibraryDir.SDL2
+    }
+
+    links {
+        Library.Common,
+        Library.SDL2,
+        Library.Fmt,
+        Library.Spdlog
+    }
+
+    filter "system:linux"
+        defines { "LINUX", "_X11" }
+        buildoptions { "-Wall", "-Wextra" }
+        links { "pthread" }
+
+    filter "configurations:Debug"
+        defines { "DEBUG", "RLD_DEBUG" }
+        runtime "Debug"
+        symbols "on"
+
+    filter "configurations:Release"
+        defines { "NDEBUG", "RLD_NDEBUG" }
+        runtime "Release"
+        optimize "on"
@@ -0,0 +1,243 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include "ArchiveWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct PackEntry {
+    std::string         foldedName;
+    fs::path            sourcePath;
+    ArchiveEntry        entry;
+};
+
+/*
+================================================================================
+WritePadding
+
+DESCRIPTION:
+Pads the file with zeros up to the given alignment.
+
+RETURNS:
+The new file offset.
+================================================================================
+*/
+static uint64_t WritePadding(FILE *file, uint64_t offset, uint64_t alignment) {
+    static const char zeros[ARCHIVE_ALIGNMENT] = {};
+
+    const uint64_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned > offset) {
+        fwrite(zeros, 1, static_cast<size_t>(aligned - offset), file);
+    }
+
+    return aligned;
+}
+
+/*
+================================================================================
+CopyFileContents
+
+DESCRIPTION:
+Appends the contents of the source file to the archive.
+
+RETURNS:
+`false` if the source file couldn't be read completely.
+================================================================================
+*/
+static bool CopyFileContents(FILE *archive, const fs::path &sourcePath, uint64_t size) {
+    FILE * source = fopen(sourcePath.string().c_str(), "rb");
+    if (source == nullptr) {
+        return false;
+    }
+
+    std::vector<char> buffer(1024 * 1024);
+    uint64_t remaining = size;
+
+    while (remaining > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+        if (fread(buffer.data(), 1, chunk, source) != chunk) {
+            fclose(source);
+            return false;
+        }
+
+        fwrite(buffer.data(), 1, chunk, archive);
+        remaining -= chunk;
+    }
+
+    fclose(source);
+    return true;
+}
+
+/*
+================================================================================
+CollectEntries
+
+DESCRIPTION:
+Walks the input directory and creates an entry for every regular file, named by
+its folded path relative to the directory.
+
+RETURNS:
+`false` if two files fold to the same name.
+================================================================================
+*/
+static bool CollectEntries(const fs::path &inputDir, std::vector<PackEntry> &entries) {
+    for (const fs::directory_entry & file : fs::recursive_directory_iterator(inputDir)) {
+        if (!file.is_regular_file()) {
+            continue;
+        }
+
+        const std::string name = fs::relative(file.path(), inputDir).generic_string();
+
+        char buffer[ARCHIVE_MAX_NAME];
+        const std::string_view folded = ArchiveFoldName(name, buffer);
+        if (folded.empty()) {
+            fprintf(stderr, "Skipping %s, the name is longer than %u characters.\n", name.c_str(), ARCHIVE_MAX_NAME);
+            continue;
+        }
+
+        PackEntry pack = {};
+        pack.foldedName = std::string(folded);
+        pack.sourcePath = file.path();
+        pack.entry.hash = ArchiveHashName(folded);
+        pack.entry.size = static_cast<uint64_t>(file.file_size());
+        pack.entry.storedSize = pack.entry.size;
+        pack.entry.compression = ARCHIVE_COMPRESSION_NONE;
+
+        entries.push_back(std::move(pack));
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PackEntry &a, const PackEntry &b) {
+        return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.foldedName < b.foldedName;
+    });
+
+    for (size_t i = 1; i < entries.size(); i++) {
+        if (entries[i].foldedName == entries[i - 1].foldedName) {
+            fprintf(stderr, "%s and %s map to the same archive name.\n",
+                    entries[i - 1].sourcePath.string().c_str(), entries[i].sourcePath.string().c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+================================================================================
+WriteArchive
+
+DESCRIPTION:
+Writes the blobs, each aligned to ARCHIVE_ALIGNMENT, followed by the sorted
+index, the bucket table and the names. The header is written last, once all the
+offsets are known.
+
+RETURNS:
+`false` on any IO error.
+================================================================================
+*/
+static bool WriteArchive(const char *outputPath, std::vector<PackEntry> &entries) {
+    FILE * archive = fopen(outputPath, "wb");
+    if (archive == nullptr) {
+        fprintf(stderr, "Couldn't create %s.\n", outputPath);
+        return false;
+    }
+
+    ArchiveHeader header = {};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.numEntries = static_cast<uint32_t>(entries.size());
+
+    // About one entry per bucket.
+    while (header.bucketBits < 24 && (1ull << header.bucketBits) < entries.size()) {
+        header.bucketBits++;
+    }
+
+    fwrite(&header, sizeof(header), 1, archive);
+    uint64_t offset = sizeof(header);
+
+    std::string names;
+    for (PackEntry & pack : entries) {
+        offset = WritePadding(archive, offset, ARCHIVE_ALIGNMENT);
+
+        if (!CopyFileContents(archive, pack.sourcePath, pack.entry.storedSize)) {
+            fprintf(stderr, "Couldn't read %s.\n", pack.sourcePath.string().c_str());
+            fclose(archive);
+            return false;
+        }
+
+        pack.entry.offset = offset;
+        pack.entry.nameOffset = static_cast<uint32_t>(names.size());
+        pack.entry.nameLength = static_cast<uint32_t>(pack.foldedName.size());
+        names += pack.foldedName;
+
+        offset += pack.entry.storedSize;
+    }
+
+    offset = WritePadding(archive, offset, alignof(ArchiveEntry));
+    header.entriesOffset = offset;
+    for (const PackEntry & pack : entries) {
+        fwrite(&pack.entry, sizeof(pack.entry), 1, archive);
+    }
+    offset += entries.size() * sizeof(ArchiveEntry);
+
+    const uint32_t numBuckets = 1u << header.bucketBits;
+    std::vector<uint32_t> buckets(numBuckets + 1, 0);
+    for (const PackEntry & pack : entries) {
+        buckets[ArchiveBucket(pack.entry.hash, header.bucketBits) + 1]++;
+    }
+    for (uint32_t i = 0; i < numBuckets; i++) {
+        buckets[i + 1] += buckets[i];
+    }
+
+    header.bucketsOffset = offset;
+    fwrite(buckets.data(), sizeof(uint32_t), buckets.size(), archive);
+    offset += buckets.size() * sizeof(uint32_t);
+
+    header.namesOffset = offset;
+    header.namesSize = names.size();
+    fwrite(names.data(), 1, names.size(), archive);
+
+    fseek(archive, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, archive);
+
+    const bool failed = ferror(archive) != 0;
+    fclose(archive);
+
+    if (failed) {
+        fprintf(stderr, "Error writing %s.\n", outputPath);
+    }
+
+    return !failed;
+}
+
+/*
+================================================================================
+PackArchive
+
+DESCRIPTION:
+Packs every regular file under the input directory into a new archive, named by
+its path relative to the directory.
+
+RETURNS:
+`false` if two files fold to the same name or on any IO error.
+================================================================================
+*/
+bool PackArchive(const char *outputPath, const fs::path &inputDir, size_t &numPacked) {
+    std::vector<PackEntry> entries;
+    if (!CollectEntries(inputDir, entries)) {
+        return false;
+    }
+
+    if (!WriteArchive(outputPath, entries)) {
+        return false;
+    }
+
+    numPacked = entries.size();
+    return true;
+}
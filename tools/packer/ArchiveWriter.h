@@ -0,0 +1,14 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#ifndef RELOAD_ARCHIVE_WRITER_H
+#define RELOAD_ARCHIVE_WRITER_H
+
+#include <cstddef>
+#include <filesystem>
+#include "ReloadLib/ArchiveFormat.h"
+
+bool PackArchive(const char *outputPath, const std::filesystem::path &inputDir, size_t &numPacked);     // Packs the directory into a new archive.
+
+#endif //RELOAD_ARCHIVE_WRITER_H
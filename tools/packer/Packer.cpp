@@ -0,0 +1,31 @@
+//
+// Created by ivan on 18.10.26.
+//
+
+#include <cstdio>
+#include <filesystem>
+
+#include "ArchiveWriter.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <output archive> <input directory>\n", argv[0]);
+        return 1;
+    }
+
+    const fs::path inputDir(argv[2]);
+    if (!fs::is_directory(inputDir)) {
+        fprintf(stderr, "%s is not a directory.\n", argv[2]);
+        return 1;
+    }
+
+    size_t numPacked = 0;
+    if (!PackArchive(argv[1], inputDir, numPacked)) {
+        return 1;
+    }
+
+    printf("Packed %zu files into %s.\n", numPacked, argv[1]);
+    return 0;
+}
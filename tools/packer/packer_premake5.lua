@@ -0,0 +1,21 @@
+project "ReloadPacker"
+    kind            "ConsoleApp"
+    language        "C++"
+    cppdialect      "C++17"
+    staticruntime   "on"
+
+    files { "ArchiveWriter.h", "ArchiveWriter.cpp", "Packer.cpp" }
+
+    -- The archive layout is shared with the engine's runtime reader.
+    includedirs { "%{rootdir}/engine/src" }
+
+    filter "system:linux"
+        buildoptions { "-Wall", "-Wextra", "-Wconversion", "-pedantic" }
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "on"